@@ -1,5 +1,7 @@
 #pragma once
 
+#include <ctime>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -17,6 +19,16 @@ class AssemblyState;
 class AssemblerOperationHandler;
 class AssemblerTarget;
 class Entry;
+class EquSnapshot;
+class IncludeCache;
+
+/**
+ * Where an entry came from. file is empty for the listing passed to Process.
+ */
+struct SourceLocation {
+    std::filesystem::path file {};
+    std::size_t line = 0;
+};
 
 class Assembler {
 
@@ -25,11 +37,70 @@ public:
     ~Assembler();
     std::unique_ptr<object::ObjectFile> Process(const std::vector<Entry>& listing);
 
+    /**
+     * Stamp results with the given time instead of the current time, so that identical
+     * inputs produce identical objects.
+     */
+    void SetFixedAssemblyTime(std::time_t time);
+
+    /**
+     * Define the equs in snapshot at the start of every listing, before any of its own.
+     */
+    void AddEquSnapshot(std::shared_ptr<const EquSnapshot> snapshot);
+
+    /**
+     * Share parsed 'use' files with other assemblers. By default, each assembler has its own cache.
+     */
+    void SetIncludeCache(std::shared_ptr<IncludeCache> cache);
+
+    /**
+     * Search directory for relative 'use' paths, after any previously added directories.
+     * Paths not found in any include directory are resolved against the working directory.
+     */
+    void AddIncludeDirectory(std::filesystem::path directory);
+
+    /**
+     * Resolve relative 'use' paths not found in any include directory against directory, rather
+     * than the process's working directory, e.g. for a request made from another directory.
+     */
+    void SetWorkingDirectory(std::filesystem::path directory);
+
+    // The canonical paths of files included by the last call to Process, in order of first use.
+    const std::vector<std::filesystem::path>& GetIncludedFiles() const;
+
+    /**
+     * For each entry of the listing last passed to Process, the code offset it was encoded at if
+     * it's a target instruction. Entries of included files aren't counted.
+     */
+    const std::vector<std::optional<std::size_t>>& GetInstructionOffsets() const;
+
+    /**
+     * The entry being assembled when Process last threw, if the failure can be attributed to one.
+     * Failures in the second pass, e.g. resolving expressions, can't be.
+     */
+    std::optional<SourceLocation> GetFailureLocation() const;
+
 protected:
     void CreateResult(AssemblyState& state);
+    void ProcessListing(const std::vector<Entry>& listing, AssemblyState& state, std::vector<std::filesystem::path>& include_stack);
+    void ProcessUse(const Entry& entry, AssemblyState& state, std::vector<std::filesystem::path>& include_stack);
 
 private:
     uint16_t assembler_version;
+    std::optional<std::time_t> fixed_assembly_time {};
+    std::vector<std::shared_ptr<const EquSnapshot>> equ_snapshots {};
+    std::shared_ptr<IncludeCache> include_cache;
+    std::vector<std::filesystem::path> include_directories {};
+    std::filesystem::path working_directory {};
+    std::vector<std::filesystem::path> included_files {};
+    std::vector<std::optional<std::size_t>> instruction_offsets {};
+
+    // Updated as entries are handled, so that failures can be attributed cheaply.
+    std::filesystem::path current_file {};
+    std::size_t current_line = 0;
+
+    // Second pass actions may refer to included entries, so they're kept until the result is created.
+    std::vector<std::shared_ptr<const std::vector<Entry>>> included_listings {};
     std::unique_ptr<AssemblerTarget> target;
     std::vector<std::unique_ptr<AssemblerOperationHandler>> op_handlers;
 };
@@ -46,7 +117,9 @@ struct OperationException : std::runtime_error {
         UnexpectedVSect,
         UnexpectedEnds,
         NeedsPSectContext,
-        NeedsVSectContext
+        NeedsVSectContext,
+        MissingInclude,
+        RecursiveInclude
     };
 
     OperationException(std::string op, Code code, const std::string& cause)
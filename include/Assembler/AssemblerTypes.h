@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <optional>
 #include <string>
 #include <tuple>
@@ -23,6 +24,9 @@ struct Entry {
     std::optional <std::string> operation{};
     std::optional <std::string> operands{};
     std::optional <std::string> comment{};
+
+    // 1-based line of the entry in its source, or 0 if it wasn't parsed from one.
+    std::size_t line{};
 };
 
 }
\ No newline at end of file
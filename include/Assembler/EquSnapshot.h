@@ -0,0 +1,70 @@
+#pragma once
+
+#include <MappedFile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace assembler {
+
+class AssemblyState;
+class Entry;
+
+/**
+ * A precompiled set of equ definitions, e.g. from a system definitions file.
+ *
+ * Compiling a listing resolves every equ it can to a constant. Equs which remain symbolic are
+ * stored as encoded expressions. Loading a snapshot skips lexing and parsing entirely.
+ *
+ * Layout (big endian):
+ *   header       magic, version, entry count, then the offset and size of each section below
+ *   entries      { name, operand text, value, kind, is global } per equ, in definition order
+ *   strings      names and operand text
+ *   expressions  prefix encoded expression trees for symbolic equs
+ */
+class EquSnapshot {
+public:
+    /**
+     * Compile a listing of equ directives (and comments) into a snapshot.
+     * Throws if the listing contains anything else.
+     */
+    static std::string Compile(const std::vector<Entry>& listing);
+
+    explicit EquSnapshot(const std::string& path);
+
+    // The memory must outlive the snapshot.
+    EquSnapshot(const char* data, std::size_t size);
+
+    EquSnapshot(const EquSnapshot&) = delete;
+    EquSnapshot& operator=(const EquSnapshot&) = delete;
+
+    uint32_t Count() const { return count; }
+
+    // The constant value of name, if it's defined by the snapshot and was resolved when compiled.
+    std::optional<uint32_t> ConstantValue(std::string_view name) const;
+
+    /**
+     * Define every equ in the snapshot, as if its directive had been assembled.
+     */
+    void LoadInto(AssemblyState& state) const;
+
+private:
+    void ReadHeader();
+
+    std::optional<support::MappedFile> mapping;
+    const char* data;
+    std::size_t size;
+
+    uint32_t count = 0;
+    uint32_t entries = 0;
+    uint32_t strings = 0;
+    uint32_t strings_size = 0;
+    uint32_t expressions = 0;
+    uint32_t expressions_size = 0;
+};
+
+}
\ No newline at end of file
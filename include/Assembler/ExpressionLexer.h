@@ -46,7 +46,7 @@ public:
 
 private:
     std::string expression;
-    std::vector<std::tuple<std::regex, TokenType>> lexicon;
+    const std::vector<std::tuple<std::regex, TokenType>>* lexicon;
 };
 
 struct UnhandledTokenException : std::runtime_error {
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace assembler {
+
+class Entry;
+
+/**
+ * Parsed listings of files included with 'use', shared between assemblies.
+ *
+ * Listings are keyed by canonical path and revalidated against the file's modification
+ * time and size, so a header included by many sources is read and parsed once per process.
+ * Concurrent requests for the same file wait on a single parse. Listings are immutable
+ * once published.
+ */
+class IncludeCache {
+public:
+    using Listing = std::vector<Entry>;
+
+    /**
+     * Get the listing of the file at path, parsing it if it's not cached or has changed.
+     * Throws if the file can't be read.
+     */
+    std::shared_ptr<const Listing> Get(const std::filesystem::path& path);
+
+    // The number of times a file has been parsed by this cache.
+    std::size_t ParseCount() const;
+
+private:
+    struct Slot {
+        std::filesystem::file_time_type modified;
+        std::uintmax_t size;
+        std::shared_future<std::shared_ptr<const Listing>> listing;
+    };
+
+    mutable std::mutex mutex {};
+    std::unordered_map<std::string, Slot> slots {};
+    std::size_t parse_count = 0;
+};
+
+}
\ No newline at end of file
@@ -18,6 +18,9 @@ public:
 
     const std::vector<Entry>& GetListing() const;
 
+    // The number of lines read so far. If Parse throws, this is the offending line.
+    std::size_t GetLineNumber() const;
+
 private:
     bool ParseBlank(const std::string& line) const;
     bool ParseComment(const std::string& line, Entry& entry) const;
@@ -28,6 +31,7 @@ private:
 
 private:
     std::vector<Entry> listing;
+    std::size_t line_number = 0;
 };
 
 // TODO: add proper messages using some sort of string concatenation
@@ -54,6 +54,10 @@ public:
         }
     }
 
+    // Wrap an expression which was parsed ahead of time, e.g. one loaded from an EquSnapshot.
+    ExpressionOperand(const OperandInfo& info, std::unique_ptr<expression::Expression> expr)
+        : Operand(info), expr(std::move(expr)) {}
+
     u_int32_t Resolve(const ExpressionResolver& resolver) const {
         try {
             return resolver.Resolve(*expr);
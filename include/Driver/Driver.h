@@ -0,0 +1,164 @@
+#pragma once
+
+#include <AssemblerTypes.h>
+#include <Endian.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace assembler {
+    class EquSnapshot;
+    class IncludeCache;
+}
+
+namespace object {
+    struct ObjectFile;
+}
+
+namespace driver {
+
+struct AssembleOptions {
+    uint16_t assembler_version = 15;
+    support::Endian endian = support::Endian::big;
+
+    // When set, the ROF is stamped with this time rather than the current time.
+    std::optional<std::time_t> fixed_time {};
+
+    // Searched in order for relative 'use' paths, before the working directory.
+    std::vector<std::filesystem::path> include_directories {};
+
+    // Relative 'use' paths not found in an include directory resolve against this. Empty for the process's.
+    std::filesystem::path working_directory {};
+    std::vector<std::shared_ptr<const assembler::EquSnapshot>> equ_snapshots {};
+
+    // Shared with other assemblies when set. Otherwise, included files are parsed for this call only.
+    std::shared_ptr<assembler::IncludeCache> include_cache {};
+};
+
+struct Diagnostic {
+    enum class Severity {
+        Error,
+        Warning
+    };
+
+    Severity severity = Severity::Error;
+
+    // Empty for the source passed to Assemble.
+    std::filesystem::path file {};
+
+    // 1-based, or 0 if the diagnostic isn't about a particular line.
+    std::size_t line = 0;
+
+    std::string message {};
+};
+
+struct AssembleResult {
+    // Empty if assembly failed, in which case diagnostics has at least one error.
+    std::optional<std::string> rof {};
+    std::vector<Diagnostic> diagnostics {};
+
+    // The canonical paths of files included with 'use', in order of first use.
+    std::vector<std::filesystem::path> included_files {};
+
+    // The assembled object, e.g. for its symbols and counters. Empty if assembly failed.
+    std::shared_ptr<const object::ObjectFile> object {};
+};
+
+/**
+ * Assemble source to a ROF in memory. Nothing is read from disk but included files and
+ * nothing is written. Failures are reported as diagnostics rather than thrown.
+ *
+ * Safe to call concurrently, provided options aren't modified meanwhile.
+ */
+AssembleResult Assemble(std::string_view source, const AssembleOptions& options = {});
+
+/**
+ * Assemble a listing which has already been parsed, e.g. by IncrementalListing.
+ */
+AssembleResult Assemble(const std::vector<assembler::Entry>& listing, const AssembleOptions& options = {});
+
+/**
+ * The listing of a source which is edited and reassembled repeatedly.
+ *
+ * Entries depend only on the text of their own line, so each update reparses only lines
+ * whose text wasn't in the previous version. Lines which moved are reused and renumbered.
+ */
+class IncrementalListing {
+public:
+    /**
+     * Bring the listing up to date with source. Returns a diagnostic for each line which
+     * couldn't be parsed. Such lines are left out of the listing.
+     */
+    std::vector<Diagnostic> Update(std::string_view source);
+
+    const std::vector<assembler::Entry>& Listing() const { return listing; }
+
+    // The number of lines parsed by the last update.
+    std::size_t LastParsedLineCount() const { return last_parsed; }
+
+private:
+    struct ParsedLine {
+        // Empty for blank lines.
+        std::optional<assembler::Entry> entry {};
+        std::optional<std::string> error {};
+    };
+
+    std::unordered_map<std::string, ParsedLine> lines;
+    std::vector<assembler::Entry> listing;
+    std::size_t last_parsed = 0;
+};
+
+/**
+ * Reassembles a listing which is edited repeatedly, e.g. by IncrementalListing, keeping the
+ * layout of the last successful assembly: its counters, symbols and the offset of each instruction.
+ *
+ * If only the operands of instructions changed, and neither the options nor the included files
+ * did, the layout still holds. Just those instructions are encoded, into a copy of the previous
+ * object, and if nothing changed the previous result is returned as is. Any other change may
+ * shift the layout, so the listing is assembled in full.
+ */
+class IncrementalAssembly {
+public:
+    AssembleResult Update(const std::vector<assembler::Entry>& listing, const AssembleOptions& options);
+
+    // Whether the last update kept the previous layout rather than assembling in full.
+    bool LastKeptLayout() const { return last_kept_layout; }
+
+    // The number of instructions encoded by the last update.
+    std::size_t LastEncodedCount() const { return last_encoded; }
+
+private:
+    struct IncludedFile {
+        std::filesystem::path path;
+        std::filesystem::file_time_type modified;
+        std::uintmax_t size;
+    };
+
+    std::optional<AssembleResult> KeepLayout(const std::vector<assembler::Entry>& listing, const AssembleOptions& options);
+    bool IncludesChanged() const;
+
+    // Empty unless the last assembly succeeded.
+    std::optional<AssembleResult> previous {};
+    std::vector<assembler::Entry> previous_listing {};
+    std::vector<std::optional<std::size_t>> instruction_offsets {};
+    std::vector<IncludedFile> included_files {};
+    AssembleOptions previous_options {};
+
+    bool last_kept_layout = false;
+    std::size_t last_encoded = 0;
+};
+
+/**
+ * Format a diagnostic as "<file>:<line>: error: <message>", naming the source source_name.
+ */
+std::string FormatDiagnostic(const Diagnostic& diagnostic, std::string_view source_name);
+
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Driver.h"
+
+#include <AssemblerTypes.h>
+#include <Expression.h>
+#include <ObjectFile.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace driver {
+
+/**
+ * A name defined by a label, in the source or in a file it uses.
+ */
+struct Definition {
+    enum class Kind {
+        Label,
+        Equ,
+        Set
+    };
+
+    std::string name {};
+    Kind kind = Kind::Label;
+    bool is_global = false;
+
+    // Empty for the indexed source.
+    std::filesystem::path file {};
+    std::size_t line = 0;
+
+    // The operand text of equ and set definitions.
+    std::string operands {};
+};
+
+/**
+ * Editor state for a source which changes often, e.g. one open in an editor.
+ *
+ * Update is cheap enough to call on every edit. It reparses only changed lines, and indexes
+ * the definitions in the source. Analyze runs a full assembly pass, which lays out the
+ * counters and indexes the definitions in used files. It's meant to be called once edits
+ * have settled.
+ *
+ * Queries are answered from these indexes. Layouts and diagnostics from Analyze are kept
+ * until the next call to it, so they may be stale after an Update.
+ */
+class SourceIndex {
+public:
+    // Where each counter symbol landed in the last analysis.
+    struct Layout {
+        std::map<std::string, object::SymbolInfo> symbols {};
+        decltype(object::ObjectFile::counter) counter {};
+    };
+
+    explicit SourceIndex(AssembleOptions options = {});
+
+    void Update(std::string_view source);
+    void Analyze();
+
+    // Whether the last analysis was of the current source.
+    bool IsAnalyzed() const { return analyzed; }
+
+    bool HasParseErrors() const { return !parse_diagnostics.empty(); }
+
+    /**
+     * Parse errors in the current source or, if there are none, the result of the last analysis.
+     */
+    const std::vector<Diagnostic>& Diagnostics() const;
+
+    // The definitions in the source, in order.
+    const std::vector<Definition>& Definitions() const { return definitions; }
+
+    // The first definition of name in the source or, failing that, in the files it uses.
+    const Definition* FindDefinition(std::string_view name) const;
+
+    /**
+     * The value of an equ or set, if it's constant. Sets are given their first value.
+     */
+    std::optional<uint32_t> Value(std::string_view name) const;
+
+    // Empty until the source has been analyzed without errors.
+    const std::optional<Layout>& GetLayout() const { return layout; }
+
+    std::size_t LastParsedLineCount() const { return listing.LastParsedLineCount(); }
+
+private:
+    std::optional<uint32_t> Evaluate(const std::string& name, std::vector<std::string>& resolving) const;
+    const expression::Expression* ParseOperands(const std::string& operands) const;
+
+    AssembleOptions options;
+    IncrementalListing listing {};
+    bool analyzed = false;
+
+    std::vector<Diagnostic> parse_diagnostics {};
+    std::vector<Diagnostic> analysis_diagnostics {};
+
+    std::vector<Definition> definitions {};
+    std::unordered_map<std::string, std::size_t> definition_index {};
+    std::unordered_map<std::string, Definition> included_definitions {};
+    std::optional<Layout> layout {};
+
+    // Parsed operands by their text, or null if they aren't an expression. Kept across updates.
+    mutable std::unordered_map<std::string, std::shared_ptr<const expression::Expression>> expressions {};
+    mutable std::unordered_map<std::string, std::optional<uint32_t>> values {};
+};
+
+}
\ No newline at end of file
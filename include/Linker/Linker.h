@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace rof {
+    class Rof15ObjectReader;
+    class RofArchive;
+}
+
+namespace linker {
+
+struct ModuleOptions {
+    // Defaults to the name of the first object.
+    std::optional<std::string> name {};
+
+    // Defaults to the edition of the first object.
+    std::optional<uint16_t> edition {};
+
+    uint16_t access = 0x0555;
+    uint16_t attributes_revision = 0x8000;
+
+    // Added to the sum of the stack sizes required by each object.
+    uint32_t extra_stack = 0;
+};
+
+/**
+ * Links ROF 15 objects into a single OS-9 module.
+ *
+ * Code from each object is placed after the module header, in the order objects were added.
+ * Initialized data from every object precedes uninitialized data in the module's data area.
+ * Code symbols resolve to module offsets, and data symbols to offsets into the data area.
+ *
+ * Symbol resolution, relocation and section copying are spread across worker_count threads.
+ * Link errors (undefined or duplicate symbols, bad relocations) raise std::runtime_error.
+ */
+class Linker {
+public:
+    explicit Linker(unsigned int worker_count = 1);
+
+    void AddObject(std::shared_ptr<const rof::Rof15ObjectReader> object);
+
+    /**
+     * Add an archive to search for symbols left undefined by the objects. Only the members
+     * which define a needed symbol are linked, after all objects.
+     */
+    void AddArchive(std::shared_ptr<const rof::RofArchive> archive);
+
+    std::vector<char> Link(const ModuleOptions& options) const;
+
+private:
+    std::vector<std::shared_ptr<const rof::Rof15ObjectReader>> GetObjectsToLink() const;
+
+    std::vector<std::shared_ptr<const rof::Rof15ObjectReader>> objects {};
+    std::vector<std::shared_ptr<const rof::RofArchive>> archives {};
+    unsigned int worker_count;
+};
+
+}
\ No newline at end of file
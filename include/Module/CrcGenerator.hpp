@@ -29,7 +29,37 @@
 
 #include <cstdio>
 #include <cstdint>
+#include <thread>
 
 namespace module::crc {
+/**
+ * Fold size bytes of data into the CRC in accumulator. A null data folds in a single zero byte.
+ * Uses carry-less multiplication where the CPU has it, and GeneratePortable otherwise.
+ */
 void Generate(const char* data, size_t size, uint32_t* accumulator);
+
+// Processes 8 bytes at a time through tables, on any CPU.
+void GeneratePortable(const char* data, size_t size, uint32_t* accumulator);
+
+// One byte at a time. The reference for Generate, which must match it bit for bit.
+void GenerateBytewise(const char* data, size_t size, uint32_t* accumulator);
+
+// Buffers at least this large are split across threads by GenerateParallel.
+constexpr size_t ParallelThreshold = 2 * 1024 * 1024;
+
+/**
+ * As Generate, but buffers of at least ParallelThreshold bytes are split into chunks, which are
+ * generated on up to worker_count threads and then combined.
+ */
+void GenerateParallel(const char* data, size_t size, uint32_t* accumulator,
+    unsigned int worker_count = std::thread::hardware_concurrency());
+
+// Advance the CRC in accumulator as if size zero bytes were folded in, in O(log size) steps.
+void ShiftZeros(size_t size, uint32_t* accumulator);
+
+/**
+ * The CRC of a buffer a followed by a buffer b, from crc_a, the CRC of a from any start, and
+ * crc_b, the CRC of b started from zero.
+ */
+uint32_t Combine(uint32_t crc_a, uint32_t crc_b, size_t size_b);
 }
\ No newline at end of file
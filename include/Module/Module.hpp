@@ -27,21 +27,42 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <memory>
+#include <optional>
 #include <string>
+#include <thread>
 #include <utility>
 
+#include "MappedFile.h"
 #include "ModuleHeader.hpp"
+#include "ModuleHeaderView.hpp"
 
 namespace module {
 
 class Module {
 public:
-    Module(std::shared_ptr<ModuleHeader> header, std::unique_ptr<char[]> raw_module): header(std::move(header)), raw_module(std::move(raw_module)) {}
+    Module(std::shared_ptr<ModuleHeader> header, std::unique_ptr<char[]> raw_module);
 
-    inline std::shared_ptr<ModuleHeader> GetHeader() {
-        return header;
+    /**
+     * Views the module at the start of data, which holds size bytes and must outlive the Module.
+     * Nothing is copied. Throws if the header claims more than size bytes.
+     */
+    Module(const char* data, std::size_t size);
+
+    /**
+     * Views the module at the start of a mapped file, which the Module keeps mapped.
+     * Throws if the header claims more than the file's size.
+     */
+    explicit Module(support::MappedFile file);
+
+    // Deserializes the whole header on first use. Prefer GetHeaderView to read a few fields.
+    std::shared_ptr<ModuleHeader> GetHeader();
+
+    inline const ModuleHeaderView& GetHeaderView() const {
+        return view;
     }
 
     std::string GetName();
@@ -50,11 +71,34 @@ public:
     void GetDataReferenceList(uint32_t* unadjusted_pointers);
 
     bool IsHeaderValid();
-    bool IsCrcValid();
+    // Large modules are checked on up to worker_count threads.
+    bool IsCrcValid(unsigned int worker_count = std::thread::hardware_concurrency());
 
 private:
     std::shared_ptr<ModuleHeader> header;
+
+    // At most one of these owns the module's bytes. Borrowed modules own neither.
     std::unique_ptr<char[]> raw_module;
+    std::optional<support::MappedFile> mapping;
+
+    const char* data;
+    ModuleHeaderView view;
+};
+
+// What the tools which check many module files report about each.
+struct ModuleCheck {
+    std::string name {};
+    std::size_t size = 0;
+    uint16_t edition = 0;
+    bool header_valid = false;
+    bool crc_valid = false;
 };
 
+/**
+ * Check the header parity and CRC of the module at the start of file. Callers check many files
+ * in parallel already, so the CRC is generated on the calling thread alone.
+ * Throws if the file doesn't start with a whole module.
+ */
+ModuleCheck CheckModuleFile(support::MappedFile file);
+
 }
\ No newline at end of file
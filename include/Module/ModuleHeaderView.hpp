@@ -0,0 +1,98 @@
+#pragma once
+
+#include <Endian.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace module {
+
+/**
+ * Reads the fields of a module header in place, each as it's asked for.
+ *
+ * The accessors match ModuleHeader's, but each decodes a single field with the endianness of the
+ * module's sync bytes, rather than deserializing the whole header up front.
+ */
+class ModuleHeaderView {
+public:
+    // Byte offsets of the fields, following the layout of ModuleHeader.
+    static constexpr std::size_t SyncBytesOffset = 0;
+    static constexpr std::size_t SystemRevisionOffset = 2;
+    static constexpr std::size_t SizeOffset = 4;
+    static constexpr std::size_t OwnerOffset = 8;
+    static constexpr std::size_t OffsetToNameOffset = 12;
+    static constexpr std::size_t AccessOffset = 16;
+    static constexpr std::size_t TypeLanguageOffset = 18;
+    static constexpr std::size_t AttRevOffset = 20;
+    static constexpr std::size_t EditionOffset = 22;
+    static constexpr std::size_t HardwareNeedsOffset = 24;
+    static constexpr std::size_t OffsetToSharedOffset = 28;
+    static constexpr std::size_t OffsetToSymbolOffset = 32;
+    static constexpr std::size_t OffsetToExecOffset = 36;
+    static constexpr std::size_t OffsetToExceptOffset = 40;
+    static constexpr std::size_t SizeOfDataOffset = 44;
+    static constexpr std::size_t MinStackSizeOffset = 48;
+    static constexpr std::size_t InitializedDataOffsetOffset = 52;
+    static constexpr std::size_t InitDataRefOffsetOffset = 56;
+    static constexpr std::size_t InitOffsetOffset = 60;
+    static constexpr std::size_t TermOffsetOffset = 64;
+    static constexpr std::size_t DataBiasOffset = 68;
+    static constexpr std::size_t CodeBiasOffset = 72;
+    static constexpr std::size_t LinkIdentOffset = 76;
+    static constexpr std::size_t ParityOffset = 86;
+    static constexpr std::size_t HeaderSize = 88;
+
+    /**
+     * data holds at least size bytes, and must outlive the view. Throws if size is too small
+     * for a header, or if the sync bytes are unknown.
+     */
+    ModuleHeaderView(const char* data, std::size_t size);
+
+    const char* Data() const { return data; }
+    support::Endian GetEndian() const { return endian; }
+
+    uint16_t SyncBytes() const { return Load<uint16_t>(SyncBytesOffset); }
+    uint16_t SystemRevision() const { return Load<uint16_t>(SystemRevisionOffset); }
+
+    uint32_t Size() const { return Load<uint32_t>(SizeOffset); }
+    uint32_t Owner() const { return Load<uint32_t>(OwnerOffset); }
+    uint32_t OffsetToName() const { return Load<uint32_t>(OffsetToNameOffset); }
+
+    uint16_t Access() const { return Load<uint16_t>(AccessOffset); }
+    uint16_t TypeLanguage() const { return Load<uint16_t>(TypeLanguageOffset); }
+    uint16_t AttRev() const { return Load<uint16_t>(AttRevOffset); }
+    uint16_t Edition() const { return Load<uint16_t>(EditionOffset); }
+
+    uint32_t HardwareNeeds() const { return Load<uint32_t>(HardwareNeedsOffset); }
+    uint32_t OffsetToShared() const { return Load<uint32_t>(OffsetToSharedOffset); }
+    uint32_t OffsetToSymbol() const { return Load<uint32_t>(OffsetToSymbolOffset); }
+    uint32_t OffsetToExec() const { return Load<uint32_t>(OffsetToExecOffset); }
+    uint32_t OffsetToExcept() const { return Load<uint32_t>(OffsetToExceptOffset); }
+    uint32_t SizeOfData() const { return Load<uint32_t>(SizeOfDataOffset); }
+    uint32_t MinStackSize() const { return Load<uint32_t>(MinStackSizeOffset); }
+    uint32_t InitializedDataOffset() const { return Load<uint32_t>(InitializedDataOffsetOffset); }
+    uint32_t InitDataRefOffset() const { return Load<uint32_t>(InitDataRefOffsetOffset); }
+    uint32_t InitOffset() const { return Load<uint32_t>(InitOffsetOffset); }
+    uint32_t TermOffset() const { return Load<uint32_t>(TermOffsetOffset); }
+    uint32_t DataBias() const { return Load<uint32_t>(DataBiasOffset); }
+    uint32_t CodeBias() const { return Load<uint32_t>(CodeBiasOffset); }
+
+    uint16_t LinkIdent() const { return Load<uint16_t>(LinkIdentOffset); }
+
+    uint16_t Parity() const { return Load<uint16_t>(ParityOffset); }
+
+private:
+    template<typename T>
+    T Load(std::size_t offset) const {
+        T value;
+        std::memcpy(&value, data + offset, sizeof(T));
+        if (endian != support::HostEndian) support::EndianSwap(&value);
+        return value;
+    }
+
+    const char* data;
+    support::Endian endian;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <Endian.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace module {
+
+/**
+ * Patches a module in place, keeping its header parity and CRC valid without rereading it.
+ *
+ * The CRC is linear, so changing the bytes at some offset changes the module's CRC by the CRC
+ * (from zero) of the XOR of the old and new bytes, shifted past the rest of the module. Each
+ * write folds in only its own bytes, and Commit applies the total to the CRC field.
+ */
+class ModulePatcher {
+public:
+    /**
+     * data holds a module of size bytes, which must outlive the patcher. Throws if it's too
+     * small to be a module, or if its header claims more than size bytes.
+     */
+    ModulePatcher(char* data, std::size_t size);
+
+    std::size_t ModuleSize() const { return module_size; }
+    support::Endian GetEndian() const { return endian; }
+
+    // Throw if count bytes at offset can't be written, i.e. they overlap the CRC or the module size.
+    void CheckWritable(std::size_t offset, std::size_t count) const;
+
+    // Overwrite count bytes at offset.
+    void Write(std::size_t offset, const char* bytes, std::size_t count);
+
+    void SetAccess(uint16_t access);
+    void SetTypeLanguage(uint16_t type_language);
+    void SetAttributesRevision(uint16_t attributes_revision);
+    void SetEdition(uint16_t edition);
+    void SetMinStackSize(uint32_t stack_size);
+
+    /**
+     * Recompute the header parity, and apply every write since the last commit to the CRC.
+     * Assumes the CRC was valid before the first write. Returns the new CRC complement.
+     */
+    uint32_t Commit();
+
+    /**
+     * Recompute the header parity and the CRC over the whole module, e.g. if the CRC wasn't
+     * valid to begin with. Returns the new CRC complement.
+     */
+    uint32_t Rebuild();
+
+private:
+    template<typename T>
+    void WriteField(std::size_t offset, T value);
+
+    char* data;
+    std::size_t module_size;
+    support::Endian endian;
+
+    // The XOR of the module's old and new CRC, for the writes since the last commit.
+    uint32_t crc_delta = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace module {
+
+struct ScannedModule {
+    std::size_t offset;
+    std::size_t size;
+    std::string name;
+    bool crc_valid;
+};
+
+/**
+ * Offset of the first sync bytes of any known port at or after from, or size if there are none.
+ * Compares 16 offsets at a time with SSE2 where it's available, and uses FindSyncBytesPortable otherwise.
+ */
+std::size_t FindSyncBytes(const char* data, std::size_t size, std::size_t from);
+
+// One offset at a time. The reference for FindSyncBytes.
+std::size_t FindSyncBytesPortable(const char* data, std::size_t size, std::size_t from);
+
+/**
+ * Find the modules in an image made of modules and padding, such as a bootfile or ROM, in order.
+ *
+ * Each occurrence of sync bytes is a candidate, which is confirmed by its header parity and by
+ * fitting in the image. The contents of a confirmed module aren't searched. The CRCs of the
+ * confirmed modules are then checked on up to worker_count threads.
+ */
+std::vector<ScannedModule> ScanImage(const char* data, std::size_t size,
+    unsigned int worker_count = std::thread::hardware_concurrency());
+
+}
\ No newline at end of file
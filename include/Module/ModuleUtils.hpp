@@ -33,6 +33,7 @@
 
 namespace module::util
 {
+    bool HasKnownSyncBytes(const char* header_data);
     bool IsBigEndian(const char* header_data);
     void ParseDataReferenceList(uint32_t* ref_list, const char* table_data);
 
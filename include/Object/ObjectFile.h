@@ -121,6 +121,9 @@ struct ObjectFile {
     uint16_t assembler_version;
     std::time_t assembly_time;
 
+    // Set when assembly_time was fixed for reproducible output. It's then written in UTC, not local time.
+    bool fixed_assembly_time = false;
+
     std::string name;
     uint16_t tylan;
     uint16_t revision;
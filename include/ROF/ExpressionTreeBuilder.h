@@ -2,7 +2,12 @@
 
 #include <Expression.h>
 
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace object {
@@ -10,10 +15,44 @@ class ObjectFile;
 }
 
 namespace rof {
+
+/**
+ * Table of external names referenced by expression trees, in first-seen order.
+ *
+ * Names are interned into stable storage, and indexed by a hash map keyed by views of
+ * the interned names, so assigning an index to a reference is O(1) regardless of
+ * how many distinct names the table holds.
+ */
+class ExternRefTable {
+public:
+    ExternRefTable() = default;
+    ExternRefTable(ExternRefTable&&) = default;
+    ExternRefTable& operator=(ExternRefTable&&) = default;
+
+    // Copying would leave the index viewing the source table's names.
+    ExternRefTable(const ExternRefTable&) = delete;
+    ExternRefTable& operator=(const ExternRefTable&) = delete;
+
+    uint32_t IndexOf(const std::string& name);
+
+    const std::deque<std::string>& Names() const {
+        return names;
+    }
+
+    std::size_t Size() const {
+        return names.size();
+    }
+
+private:
+    // Note: deque is used so that views held by the index remain valid as names are added.
+    std::deque<std::string> names {};
+    std::unordered_map<std::string_view, uint32_t> index {};
+};
+
 class ExpressionTree;
 class ExpressionTreeBuilder : public expression::ExpressionVisitor {
 public:
-    explicit ExpressionTreeBuilder(const object::ObjectFile&, std::vector<std::string>&);
+    explicit ExpressionTreeBuilder(const object::ObjectFile&, ExternRefTable&);
     std::unique_ptr<ExpressionTree> Build(const expression::Expression& expression);
 
 protected:
@@ -40,6 +79,6 @@ private:
     std::unique_ptr<ExpressionTree> SubTree(const expression::Expression& expr) const;
 
     const object::ObjectFile& object_file;
-    std::vector<std::string>& extern_refs;
+    ExternRefTable& extern_refs;
 };
 }
\ No newline at end of file
@@ -77,6 +77,9 @@ struct Reference : SerializableReference {
     auto& ExprTreeIndex() { return std::get<4>(*this); }
 };
 
+// Set in ExpressionRef flags when the reference is to a symbol in this ROF, rather than an extern ref index.
+constexpr uint16_t LocalReferenceFlag = 1U << 12;
+
 using ExpressionVal = uint32_t;
 using SerializableExprRef = SerializableStruct<uint16_t, uint32_t>;
 struct ExpressionRef : SerializableExprRef {
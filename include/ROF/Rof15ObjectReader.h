@@ -0,0 +1,246 @@
+#pragma once
+
+#include "Endian.h"
+#include "MappedFile.h"
+#include "Rof15ObjectFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rof {
+
+// The bytes of a whole ROF, and the endian its fields are encoded in.
+struct RofBytes {
+    const char* data = nullptr;
+    std::size_t size = 0;
+    support::Endian endian = support::big;
+};
+
+struct ExternDefinitionView {
+    std::string_view name;
+    uint16_t type;
+    uint32_t symbol_value;
+};
+
+/**
+ * An undecoded expression tree within a ROF.
+ * Operands are decoded on request, and are themselves views.
+ */
+class ExpressionTreeView {
+public:
+    ExpressionTreeView(RofBytes rof, std::size_t offset);
+
+    ExpressionOperator Op() const;
+
+    // Number of subtree operands (0 for constants and references, 1 for unary operators, 2 otherwise).
+    unsigned int SubtreeCount() const;
+
+    // Only valid when Op() is NumericConstant.
+    ExpressionVal Value() const;
+
+    // Only valid when Op() is Reference.
+    ExpressionRef Ref() const;
+
+    ExpressionTreeView Operand1() const;
+    ExpressionTreeView Operand2() const;
+
+    // Size of the encoded tree, in bytes.
+    std::size_t EncodedSize() const;
+
+    // Materialize the tree.
+    std::unique_ptr<ExpressionTree> Decode() const;
+
+private:
+    RofBytes rof;
+    std::size_t offset;
+};
+
+struct ExternDefinitionCodec {
+    using Value = ExternDefinitionView;
+    static Value Decode(const RofBytes& rof, std::size_t offset);
+    static std::size_t Next(const RofBytes& rof, std::size_t offset);
+};
+
+struct ExternRefCodec {
+    using Value = std::string_view;
+    static Value Decode(const RofBytes& rof, std::size_t offset);
+    static std::size_t Next(const RofBytes& rof, std::size_t offset);
+};
+
+struct ExpressionTreeCodec {
+    using Value = ExpressionTreeView;
+    static Value Decode(const RofBytes& rof, std::size_t offset);
+    static std::size_t Next(const RofBytes& rof, std::size_t offset);
+};
+
+struct ReferenceCodec {
+    using Value = Reference;
+    static constexpr std::size_t EntrySize = 12;
+    static Value Decode(const RofBytes& rof, std::size_t offset);
+    static std::size_t Next(const RofBytes& rof, std::size_t offset);
+};
+
+/**
+ * A count-prefixed table of entries within a ROF.
+ * Entries are decoded as the table is iterated.
+ */
+template<typename Codec>
+class TableView {
+public:
+    using value_type = typename Codec::Value;
+
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename Codec::Value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(RofBytes rof, std::size_t offset, uint32_t remaining) : rof(rof), offset(offset), remaining(remaining) {}
+
+        value_type operator*() const { return Codec::Decode(rof, offset); }
+
+        Iterator& operator++() {
+            offset = Codec::Next(rof, offset);
+            remaining--;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            auto previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator& other) const { return remaining == other.remaining; }
+        bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+        // Offset of the current entry within the ROF.
+        std::size_t Offset() const { return offset; }
+
+    private:
+        RofBytes rof;
+        std::size_t offset;
+        uint32_t remaining;
+    };
+
+    TableView(RofBytes rof, std::size_t offset, uint32_t count) : rof(rof), first(offset), count(count) {}
+
+    uint32_t Count() const { return count; }
+    bool Empty() const { return count == 0; }
+
+    Iterator begin() const { return Iterator(rof, first, count); }
+    Iterator end() const { return Iterator(rof, 0, 0); }
+
+    /**
+     * Random access into tables of fixed size entries.
+     */
+    value_type At(uint32_t index) const {
+        static_assert(Codec::EntrySize > 0, "At requires fixed size entries.");
+        if (index >= count) {
+            throw std::out_of_range("ROF table index out of range.");
+        }
+        return Codec::Decode(rof, first + static_cast<std::size_t>(index) * Codec::EntrySize);
+    }
+
+private:
+    RofBytes rof;
+    std::size_t first;
+    uint32_t count;
+};
+
+using ExternDefinitionsView = TableView<ExternDefinitionCodec>;
+using ExternRefsView = TableView<ExternRefCodec>;
+using ExpressionTreesView = TableView<ExpressionTreeCodec>;
+using ReferencesView = TableView<ReferenceCodec>;
+
+/**
+ * Reads a ROF in place, either from a memory mapped file or from memory owned by the caller.
+ *
+ * Only the header is decoded up front. Each section is located the first time it is requested,
+ * and its entries are decoded as they are visited. Malformed input raises std::runtime_error.
+ *
+ * Views returned by the reader refer to its memory and must not outlive it.
+ */
+class Rof15ObjectReader {
+public:
+    /**
+     * Map and read the ROF at path.
+     * The field endian is inferred from the target CPU unless given.
+     */
+    explicit Rof15ObjectReader(const std::string& path, std::optional<support::Endian> endian = std::nullopt);
+
+    /**
+     * Read a ROF from memory owned by the caller, which must outlive the reader.
+     */
+    Rof15ObjectReader(const char* data, std::size_t size, std::optional<support::Endian> endian = std::nullopt);
+
+    Rof15ObjectReader(const Rof15ObjectReader&) = delete;
+    Rof15ObjectReader& operator=(const Rof15ObjectReader&) = delete;
+
+    Rof15Header Header() const { return header; }
+    support::Endian Endian() const { return rof.endian; }
+
+    // The encoded size of the ROF, in bytes.
+    std::size_t Size() const;
+
+    ExternDefinitionsView ExternDefinitions() const;
+
+    std::string_view Code() const;
+    std::string_view InitializedData() const;
+    std::string_view RemoteInitializedData() const;
+    std::string_view DebugInfo() const;
+
+    ExternRefsView ExternRefs() const;
+    ExpressionTreesView ExpressionTrees() const;
+    ReferencesView References() const;
+
+    /**
+     * The expression tree at index, as referred to by Reference::ExprTreeIndex.
+     * The first call indexes every tree in the ROF.
+     */
+    ExpressionTreeView ExpressionTreeAt(uint32_t index) const;
+
+private:
+    struct LazyOffset {
+        std::once_flag once;
+        std::size_t value = 0;
+    };
+
+    void ReadHeader(std::optional<support::Endian> endian);
+
+    std::size_t SectionsOffset() const;
+    std::size_t ExternRefsOffset() const;
+    std::size_t ExpressionTreesOffset() const;
+    std::size_t ReferencesOffset() const;
+
+    std::optional<support::MappedFile> mapping;
+    RofBytes rof;
+    Rof15Header header;
+    std::size_t extern_defs_offset = 0;
+
+    struct {
+        std::size_t code = 0;
+        std::size_t initialized_data = 0;
+        std::size_t remote_initialized_data = 0;
+        std::size_t debug_info = 0;
+    } section_sizes;
+
+    mutable LazyOffset sections_offset;
+    mutable LazyOffset expression_trees_offset;
+    mutable LazyOffset references_offset;
+
+    mutable std::once_flag tree_index_once;
+    mutable std::vector<std::size_t> tree_offsets;
+};
+
+}
\ No newline at end of file
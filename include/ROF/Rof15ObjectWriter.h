@@ -11,7 +11,17 @@ namespace rof {
 class Rof15ObjectWriter {
 public:
     explicit Rof15ObjectWriter();
+
+    /**
+     * Create a writer which builds references and expression trees on up to worker_count threads.
+     * Output is byte-identical to the serial writer.
+     */
+    explicit Rof15ObjectWriter(unsigned int worker_count);
+
     void Write(const object::ObjectFile&, std::ostream&) const;
+
+private:
+    unsigned int worker_count = 1;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rof {
+
+class Rof15ObjectReader;
+
+/*
+ * ROF archive layout. All fields are big endian.
+ *
+ *   header       magic, version, then the count and offset of each table below
+ *   members      { name offset, data offset, data size, modification time } per member
+ *   symbols      { name offset, name length, member index } per external definition, sorted by name
+ *   strings      NUL terminated member and symbol names
+ *   data         each member ROF, 4 byte aligned
+ *
+ * Tables are fixed size records, so a mapped archive is searched in place.
+ */
+constexpr std::array<char, 8> RofArchiveMagic = { '!', '<', 'r', 'o', 'f', 'l', 'b', '>' };
+constexpr uint32_t RofArchiveVersion = 1;
+
+struct ArchiveMember {
+    std::string_view name;
+    std::string_view data;
+    uint32_t modification_time;
+};
+
+struct ArchiveSymbol {
+    std::string_view name;
+    uint32_t member_index;
+};
+
+/**
+ * Reads a ROF archive in place, from a memory mapped file or from memory owned by the caller.
+ * Malformed archives raise std::runtime_error.
+ */
+class RofArchive {
+public:
+    explicit RofArchive(const std::string& path);
+
+    // The memory must outlive the archive.
+    RofArchive(const char* data, std::size_t size);
+
+    RofArchive(const RofArchive&) = delete;
+    RofArchive& operator=(const RofArchive&) = delete;
+
+    static bool IsArchive(const char* data, std::size_t size);
+
+    uint32_t MemberCount() const { return member_count; }
+    ArchiveMember Member(uint32_t index) const;
+    std::optional<uint32_t> FindMember(std::string_view name) const;
+
+    uint32_t SymbolCount() const { return symbol_count; }
+    ArchiveSymbol Symbol(uint32_t index) const;
+
+    /**
+     * The index of the member which defines name, found by binary search of the symbol table.
+     */
+    std::optional<uint32_t> FindSymbol(std::string_view name) const;
+
+    /**
+     * Read a member in place. The archive must outlive the reader.
+     */
+    std::unique_ptr<Rof15ObjectReader> OpenMember(uint32_t index) const;
+
+private:
+    void ReadHeader();
+    uint32_t ReadWord(std::size_t offset) const;
+    std::string_view String(uint32_t offset, std::optional<uint32_t> length = std::nullopt) const;
+
+    std::optional<support::MappedFile> mapping;
+    const char* data;
+    std::size_t size;
+
+    uint32_t member_count = 0;
+    uint32_t member_table = 0;
+    uint32_t symbol_count = 0;
+    uint32_t symbol_table = 0;
+    uint32_t string_table = 0;
+    uint32_t string_table_size = 0;
+};
+
+/**
+ * Builds a ROF archive, indexing the external definitions of each member.
+ * When several members define a symbol, the index refers to the first.
+ */
+class RofArchiveWriter {
+public:
+    // Add a member, or replace the member with the same name in place.
+    void AddMember(const std::string& name, std::string rof, uint32_t modification_time = 0);
+
+    bool RemoveMember(const std::string& name);
+
+    // Add every member of an existing archive.
+    void AddMembers(const RofArchive& archive);
+
+    void Write(std::ostream& out) const;
+
+private:
+    struct Member {
+        std::string name;
+        std::string rof;
+        uint32_t modification_time;
+    };
+
+    std::vector<Member> members {};
+};
+
+}
\ No newline at end of file
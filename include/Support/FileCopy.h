@@ -0,0 +1,102 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+namespace support {
+
+// The ways CopyFileRange copies, from fastest to most widely supported.
+enum class CopyMethod {
+    CopyFileRange,
+    SendFile,
+    Buffered
+};
+
+/**
+ * Copy count bytes from in_offset in one file to out_offset in another, without moving either
+ * descriptor's position. Throws if the input ends first.
+ *
+ * On Linux, copy_file_range keeps the bytes in the kernel, and may share extents on filesystems
+ * that support reflinks. Where it isn't supported between the two files, sendfile is tried, then
+ * a buffered copy as a last resort. Methods before first are skipped, e.g. to test the fallbacks.
+ */
+inline void CopyFileRange(int in, off_t in_offset, int out, off_t out_offset, std::size_t count,
+    CopyMethod first = CopyMethod::CopyFileRange) {
+    auto fail = [](const char* operation) {
+        throw std::runtime_error(std::string("Failed to copy file data (") + operation + "): " + std::strerror(errno));
+    };
+
+#if defined(__linux__)
+    // EXDEV, EINVAL, ENOSYS and EOPNOTSUPP mean this pair of files can't use the call, not that the copy failed.
+    auto unsupported = [](int error) {
+        return error == EXDEV || error == EINVAL || error == ENOSYS || error == EOPNOTSUPP;
+    };
+
+    while (first <= CopyMethod::CopyFileRange && count > 0) {
+        auto copied = copy_file_range(in, &in_offset, out, &out_offset, count, 0);
+        if (copied > 0) {
+            count -= static_cast<std::size_t>(copied);
+            continue;
+        }
+        if (copied == 0) throw std::runtime_error("Failed to copy file data: unexpected end of file.");
+        if (errno == EINTR) continue;
+        if (unsupported(errno)) break;
+        fail("copy_file_range");
+    }
+
+    // sendfile writes at the output's position, so seek there first, and back once done.
+    auto position = lseek(out, 0, SEEK_CUR);
+    if (first <= CopyMethod::SendFile && count > 0 && position >= 0 && lseek(out, out_offset, SEEK_SET) == out_offset) {
+        struct RestorePosition {
+            ~RestorePosition() { lseek(fd, position, SEEK_SET); }
+            int fd;
+            off_t position;
+        } restore { out, position };
+
+        while (count > 0) {
+            auto copied = sendfile(out, in, &in_offset, count);
+            if (copied > 0) {
+                count -= static_cast<std::size_t>(copied);
+                out_offset += copied;
+                continue;
+            }
+            if (copied == 0) throw std::runtime_error("Failed to copy file data: unexpected end of file.");
+            if (errno == EINTR) continue;
+            if (unsupported(errno)) break;
+            fail("sendfile");
+        }
+    }
+#endif
+
+    std::vector<char> buffer(count > 0 ? std::min<std::size_t>(count, 1U << 20U) : 0);
+    while (count > 0) {
+        auto read = pread(in, buffer.data(), std::min(count, buffer.size()), in_offset);
+        if (read < 0 && errno == EINTR) continue;
+        if (read < 0) fail("read");
+        if (read == 0) throw std::runtime_error("Failed to copy file data: unexpected end of file.");
+
+        for (ssize_t written = 0; written < read;) {
+            auto result = pwrite(out, buffer.data() + written, static_cast<std::size_t>(read - written), out_offset);
+            if (result < 0 && errno == EINTR) continue;
+            if (result < 0) fail("write");
+            written += result;
+            out_offset += result;
+        }
+
+        in_offset += read;
+        count -= static_cast<std::size_t>(read);
+    }
+}
+
+}
\ No newline at end of file
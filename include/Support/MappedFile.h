@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace support {
+
+/**
+ * RAII wrapper for a file mapped into memory.
+ *
+ * Read-only mappings are private. Read-write mappings are shared, so writes through
+ * MutableData() are reflected in the underlying file.
+ */
+class MappedFile {
+public:
+    enum class Access {
+        ReadOnly,
+        ReadWrite
+    };
+
+    explicit MappedFile(const std::string& path, Access access = Access::ReadOnly) : access(access) {
+        int fd = open(path.c_str(), access == Access::ReadOnly ? O_RDONLY : O_RDWR);
+        if (fd < 0) {
+            throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+        }
+
+        // The mapping remains valid after the descriptor is closed.
+        try {
+            Map(fd, path);
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+
+    /**
+     * Map the file open on fd, which is left open, e.g. to go on reading the same file by
+     * descriptor. name is only used in errors.
+     */
+    MappedFile(int fd, const std::string& name, Access access = Access::ReadOnly) : access(access) {
+        Map(fd, name);
+    }
+
+    ~MappedFile() {
+        if (data) {
+            munmap(data, size);
+        }
+    }
+
+    MappedFile(MappedFile&& other) noexcept
+        : data(std::exchange(other.data, nullptr)), size(std::exchange(other.size, 0)), access(other.access) {}
+
+    MappedFile& operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            if (data) munmap(data, size);
+            data = std::exchange(other.data, nullptr);
+            size = std::exchange(other.size, 0);
+            access = other.access;
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* Data() const {
+        return data;
+    }
+
+    char* MutableData() {
+        if (access != Access::ReadWrite) {
+            throw std::logic_error("File was not mapped for writing.");
+        }
+        return data;
+    }
+
+    std::size_t Size() const {
+        return size;
+    }
+
+    /**
+     * Flush writes to the underlying file.
+     */
+    void Sync() {
+        if (data && access == Access::ReadWrite && msync(data, size, MS_SYNC) != 0) {
+            throw std::runtime_error(std::string("Failed to sync mapping: ") + std::strerror(errno));
+        }
+    }
+
+private:
+    void Map(int fd, const std::string& name) {
+        struct stat info {};
+        if (fstat(fd, &info) != 0) {
+            auto error = errno;
+            throw std::runtime_error("Failed to stat " + name + ": " + std::strerror(error));
+        }
+
+        size = static_cast<std::size_t>(info.st_size);
+
+        // mmap rejects empty mappings. An empty file is simply an empty region.
+        if (size != 0) {
+            auto protection = access == Access::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+            auto flags = access == Access::ReadOnly ? MAP_PRIVATE : MAP_SHARED;
+
+            void* mapped = mmap(nullptr, size, protection, flags, fd, 0);
+            if (mapped == MAP_FAILED) {
+                auto error = errno;
+                throw std::runtime_error("Failed to map " + name + ": " + std::strerror(error));
+            }
+
+            data = static_cast<char*>(mapped);
+        }
+    }
+
+    char* data = nullptr;
+    std::size_t size = 0;
+    Access access;
+};
+
+}
\ No newline at end of file
@@ -8,7 +8,12 @@
 #include <vector>
 #include <iostream>
 
+// Tracing is opt-in, since serialization may run on many threads at once.
+#ifdef SERIALIZATION_TRACE
 #define LOG_STEP(f_) (std::cout << (f_) << std::endl)
+#else
+#define LOG_STEP(f_) ((void) 0)
+#endif
 
 namespace serializer_internal {
 
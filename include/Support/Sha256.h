@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace support {
+
+/**
+ * Incremental SHA-256 (FIPS 180-4), used for content-addressing.
+ */
+class Sha256 {
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    Sha256& Update(const void* data, std::size_t size) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        total_size += size;
+
+        while (size > 0) {
+            auto count = std::min(size, block.size() - block_used);
+            std::memcpy(block.data() + block_used, bytes, count);
+
+            block_used += count;
+            bytes += count;
+            size -= count;
+
+            if (block_used == block.size()) {
+                Compress();
+                block_used = 0;
+            }
+        }
+
+        return *this;
+    }
+
+    Sha256& Update(std::string_view data) {
+        return Update(data.data(), data.size());
+    }
+
+    Digest Finish() {
+        uint64_t bit_size = total_size * 8;
+
+        const uint8_t pad_start = 0x80;
+        Update(&pad_start, 1);
+
+        const uint8_t zero = 0;
+        while (block_used != block.size() - sizeof(bit_size)) {
+            Update(&zero, 1);
+        }
+
+        uint8_t length[sizeof(bit_size)];
+        for (std::size_t i = 0; i < sizeof(bit_size); i++) {
+            length[i] = static_cast<uint8_t>(bit_size >> (56 - 8 * i));
+        }
+        Update(length, sizeof(length));
+
+        Digest digest {};
+        for (std::size_t i = 0; i < state.size(); i++) {
+            digest[i * 4 + 0] = static_cast<uint8_t>(state[i] >> 24);
+            digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+            digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+            digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+        }
+
+        return digest;
+    }
+
+    static std::string ToHex(const Digest& digest) {
+        static constexpr char digits[] = "0123456789abcdef";
+
+        std::string hex {};
+        hex.reserve(digest.size() * 2);
+        for (auto byte : digest) {
+            hex.push_back(digits[byte >> 4]);
+            hex.push_back(digits[byte & 0xF]);
+        }
+
+        return hex;
+    }
+
+private:
+    static constexpr uint32_t RotateRight(uint32_t value, unsigned int count) {
+        return (value >> count) | (value << (32 - count));
+    }
+
+    void Compress() {
+        static constexpr std::array<uint32_t, 64> k = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+
+        std::array<uint32_t, 64> w {};
+        for (std::size_t i = 0; i < 16; i++) {
+            w[i] = (uint32_t(block[i * 4]) << 24) | (uint32_t(block[i * 4 + 1]) << 16)
+                 | (uint32_t(block[i * 4 + 2]) << 8) | uint32_t(block[i * 4 + 3]);
+        }
+
+        for (std::size_t i = 16; i < 64; i++) {
+            auto s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            auto s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        auto [a, b, c, d, e, f, g, h] = state;
+        for (std::size_t i = 0; i < 64; i++) {
+            auto s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+            auto choice = (e & f) ^ (~e & g);
+            auto temp1 = h + s1 + choice + k[i] + w[i];
+            auto s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+            auto majority = (a & b) ^ (a & c) ^ (b & c);
+            auto temp2 = s0 + majority;
+
+            h = g;
+            g = f;
+            f = e;
+            e = d + temp1;
+            d = c;
+            c = b;
+            b = a;
+            a = temp1 + temp2;
+        }
+
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+
+    std::array<uint32_t, 8> state = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    std::array<uint8_t, 64> block {};
+    std::size_t block_used = 0;
+    uint64_t total_size = 0;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace support {
+
+/**
+ * Fixed-size pool of worker threads servicing a shared FIFO task queue.
+ *
+ * Tasks are submitted as callables, and their results (or exceptions) are delivered
+ * through the returned future. Destroying the pool finishes all queued tasks first.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t thread_count = DefaultThreadCount()) {
+        if (thread_count == 0) thread_count = 1;
+
+        workers.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; i++) {
+            workers.emplace_back([this]() { Run(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        available.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template<typename F>
+    auto Submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+
+        // std::function requires copyable targets, so the (move-only) packaged task is shared.
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        auto future = packaged->get_future();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.emplace_back([packaged]() { (*packaged)(); });
+        }
+
+        available.notify_one();
+        return future;
+    }
+
+    std::size_t Size() const {
+        return workers.size();
+    }
+
+    static std::size_t DefaultThreadCount() {
+        auto hardware = std::thread::hardware_concurrency();
+        return hardware != 0 ? hardware : 1;
+    }
+
+private:
+    void Run() {
+        while (true) {
+            std::function<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                available.wait(lock, [this]() { return stopping || !queue.empty(); });
+
+                if (queue.empty()) return; // stopping, and nothing left to do
+
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers {};
+    std::deque<std::function<void()>> queue {};
+    std::mutex mutex {};
+    std::condition_variable available {};
+    bool stopping = false;
+};
+
+}
\ No newline at end of file
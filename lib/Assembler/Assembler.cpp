@@ -4,9 +4,12 @@
 #include "AssemblerTypes.h"
 #include "AssemblerTarget.h"
 #include "AssemblyState.h"
+#include "EquSnapshot.h"
 #include "ExpressionResolver.h"
+#include "IncludeCache.h"
 #include "ObjectFile.h"
 
+#include <algorithm>
 #include <chrono>
 #include <vector>
 
@@ -19,16 +22,21 @@ void Assembler::CreateResult(AssemblyState& state) {
     }
 
     // Set static properties.
-    using clock = std::chrono::system_clock;
-    auto now = clock::now();
-    state.result->assembly_time = clock::to_time_t(now);
+    if (fixed_assembly_time) {
+        state.result->assembly_time = fixed_assembly_time.value();
+        state.result->fixed_assembly_time = true;
+    } else {
+        using clock = std::chrono::system_clock;
+        auto now = clock::now();
+        state.result->assembly_time = clock::to_time_t(now);
+    }
 
     // Set assembler info
     state.result->assembler_version = assembler_version;
 }
 
 Assembler::Assembler(uint16_t assembler_version, std::unique_ptr<AssemblerTarget> target)
-    : assembler_version(assembler_version), target(std::move(target))
+    : assembler_version(assembler_version), include_cache(std::make_shared<IncludeCache>()), target(std::move(target))
 {
     op_handlers.emplace_back(std::make_unique<AssemblerDirectiveHandler>());
     op_handlers.emplace_back(std::make_unique<AssemblerPseudoInstHandler>());
@@ -36,22 +44,86 @@ Assembler::Assembler(uint16_t assembler_version, std::unique_ptr<AssemblerTarget
 
 Assembler::~Assembler() = default;
 
+void Assembler::SetFixedAssemblyTime(std::time_t time) {
+    fixed_assembly_time = time;
+}
+
+void Assembler::AddEquSnapshot(std::shared_ptr<const EquSnapshot> snapshot) {
+    equ_snapshots.push_back(std::move(snapshot));
+}
+
+void Assembler::SetIncludeCache(std::shared_ptr<IncludeCache> cache) {
+    include_cache = std::move(cache);
+}
+
+void Assembler::AddIncludeDirectory(std::filesystem::path directory) {
+    include_directories.push_back(std::move(directory));
+}
+
+void Assembler::SetWorkingDirectory(std::filesystem::path directory) {
+    working_directory = std::move(directory);
+}
+
+const std::vector<std::filesystem::path>& Assembler::GetIncludedFiles() const {
+    return included_files;
+}
+
+const std::vector<std::optional<std::size_t>>& Assembler::GetInstructionOffsets() const {
+    return instruction_offsets;
+}
+
+std::optional<SourceLocation> Assembler::GetFailureLocation() const {
+    if (current_line == 0) {
+        return std::nullopt;
+    }
+
+    return SourceLocation { current_file, current_line };
+}
+
 std::unique_ptr<object::ObjectFile> Assembler::Process(const std::vector<Entry> &listing) {
     AssemblyState state {};
 
     // Set target CPU ID and endianness on object file.
     target->SetTargetSpecificProperties(*state.result);
 
+    for (auto& snapshot : equ_snapshots) {
+        snapshot->LoadInto(state);
+    }
+
+    included_files.clear();
+    included_listings.clear();
+    instruction_offsets.assign(listing.size(), std::nullopt);
+    current_file.clear();
+    current_line = 0;
+
+    std::vector<std::filesystem::path> include_stack {};
+    ProcessListing(listing, state, include_stack);
+
+    current_line = 0;
+    CreateResult(state);
+    included_listings.clear();
+
+    return std::move(state.result);
+}
+
+void Assembler::ProcessListing(const std::vector<Entry>& listing, AssemblyState& state, std::vector<std::filesystem::path>& include_stack) {
     for (auto& entry : listing) {
         if (state.found_program_end) {
             break;
         }
 
+        current_line = entry.line;
+
         if (entry.label) {
             // Remember the label so it can be mapped to the next appropriate counter value.
             state.pending_labels.insert(entry.label.value());
         }
 
+        if (entry.operation == "use") {
+            ProcessUse(entry, state, include_stack);
+            continue;
+        }
+
         if (entry.operation) {
             auto try_handle = [&entry, &state](auto& handler) {
                 return handler->Handle(entry, state);
@@ -70,13 +142,59 @@ std::unique_ptr<object::ObjectFile> Assembler::Process(const std::vector<Entry>
                     throw "target instruction must be inside the psect";
                 }
 
-                target->GetOperationHandler()->Handle(entry, state);
+                auto offset = state.result->counter.code;
+                if (target->GetOperationHandler()->Handle(entry, state) && include_stack.empty()) {
+                    instruction_offsets[&entry - listing.data()] = offset;
+                }
             }
         }
     }
+}
 
-    CreateResult(state);
-    return std::move(state.result);
+void Assembler::ProcessUse(const Entry& entry, AssemblyState& state, std::vector<std::filesystem::path>& include_stack) {
+    Operation operation(entry);
+    operation.RequireNoLabel();
+
+    auto operands = operation.ParseOperands();
+    auto path = std::filesystem::path(operands.Get(0, "path")->AsString());
+
+    auto resolved = path;
+    if (path.is_relative()) {
+        auto found = std::find_if(include_directories.begin(), include_directories.end(), [&path](auto& directory) {
+            std::error_code error {};
+            return std::filesystem::is_regular_file(directory / path, error);
+        });
+
+        if (found != include_directories.end()) {
+            resolved = *found / path;
+        } else {
+            resolved = working_directory / path;
+        }
+    }
+
+    std::error_code error {};
+    if (!std::filesystem::is_regular_file(resolved, error)) {
+        operation.Fail(OperationException::Code::MissingInclude, "file not found: " + path.string());
+    }
+
+    auto canonical = std::filesystem::canonical(resolved);
+    if (std::find(include_stack.begin(), include_stack.end(), canonical) != include_stack.end()) {
+        operation.Fail(OperationException::Code::RecursiveInclude, "file includes itself: " + path.string());
+    }
+
+    if (std::find(included_files.begin(), included_files.end(), canonical) == included_files.end()) {
+        included_files.push_back(canonical);
+    }
+
+    auto& included = *included_listings.emplace_back(include_cache->Get(canonical));
+
+    include_stack.push_back(canonical);
+    current_file = canonical;
+    ProcessListing(included, state, include_stack);
+
+    // Not restored if the include fails, so that the failure is attributed to the included line.
+    include_stack.pop_back();
+    current_file = include_stack.empty() ? std::filesystem::path {} : include_stack.back();
 }
 
 }
\ No newline at end of file
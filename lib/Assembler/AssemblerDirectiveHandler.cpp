@@ -256,7 +256,7 @@ std::unordered_map<std::string, DirectiveHandler> directives = {
     { "ifndef", Op_Unimplemented },
 
     { "endc", Op_Unimplemented },
-    { "use", Op_Unimplemented },
+    // 'use' is expanded by the Assembler, since it splices another listing into this one.
     { "spc", Op_Unimplemented },
     { "end", Op_End},
 };
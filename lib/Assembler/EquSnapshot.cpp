@@ -0,0 +1,402 @@
+#include "EquSnapshot.h"
+
+#include "AssemblerDirectiveHandler.h"
+#include "AssemblerTypes.h"
+#include "AssemblyState.h"
+#include "ExpressionResolver.h"
+#include "Operation.h"
+
+#include <array>
+#include <cstring>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+namespace assembler {
+
+namespace {
+
+using namespace expression;
+
+constexpr std::array<char, 8> SnapshotMagic = { '!', '<', 'e', 'q', 'u', 's', 'n', '>' };
+constexpr uint32_t SnapshotVersion = 1;
+
+constexpr std::size_t HeaderSize = SnapshotMagic.size() + 7 * sizeof(uint32_t);
+constexpr std::size_t EntrySize = 6 * sizeof(uint32_t);
+
+// Guards decoding against stack exhaustion from corrupt snapshots.
+constexpr unsigned int MaxExpressionDepth = 1024;
+
+enum class EntryKind : uint8_t {
+    Constant,
+    Expression
+};
+
+// Follows the order of ExpressionVisitorTypes.
+enum class ExpressionCode : uint8_t {
+    NumericConstant,
+    Reference,
+    Hi,
+    High,
+    Lo,
+    Negation,
+    BitwiseNot,
+    BitwiseAnd,
+    BitwiseOr,
+    BitwiseXor,
+    Multiplication,
+    Division,
+    Addition,
+    Subtraction,
+    LogicalLeftShift,
+    LogicalRightShift,
+    ArithmeticRightShift
+};
+
+[[noreturn]] void Malformed(const std::string& what) {
+    throw std::runtime_error("Malformed equ snapshot: " + what);
+}
+
+uint32_t CheckedSize(std::size_t size) {
+    if (size > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Equ snapshot is too large.");
+    }
+    return static_cast<uint32_t>(size);
+}
+
+void PutWord(std::string& out, uint32_t value) {
+    out.push_back(static_cast<char>(value >> 24U));
+    out.push_back(static_cast<char>(value >> 16U));
+    out.push_back(static_cast<char>(value >> 8U));
+    out.push_back(static_cast<char>(value));
+}
+
+uint32_t ReadWord(const char* data, std::size_t size, std::size_t offset) {
+    if (offset > size || size - offset < sizeof(uint32_t)) {
+        Malformed("unexpected end of file.");
+    }
+
+    auto* bytes = reinterpret_cast<const uint8_t*>(data + offset);
+    return uint32_t(bytes[0]) << 24U | uint32_t(bytes[1]) << 16U | uint32_t(bytes[2]) << 8U | bytes[3];
+}
+
+struct ExpressionEncoder : ExpressionVisitor {
+    ExpressionEncoder(std::string& code, std::string& strings) : code(code), strings(strings) {}
+
+    void Visit(const NumericConstantExpression& expr) override {
+        Put(ExpressionCode::NumericConstant);
+        PutWord(code, expr.value);
+    }
+
+    void Visit(const ReferenceExpression& expr) override {
+        Put(ExpressionCode::Reference);
+        PutWord(code, CheckedSize(strings.size()));
+        PutWord(code, CheckedSize(expr.value.size()));
+        strings.append(expr.value);
+    }
+
+    // The left operand of a function-like operator is just its name.
+    void Visit(const HiExpression& expr) override { Prefix(ExpressionCode::Hi, expr.Right()); }
+    void Visit(const HighExpression& expr) override { Prefix(ExpressionCode::High, expr.Right()); }
+    void Visit(const LoExpression& expr) override { Prefix(ExpressionCode::Lo, expr.Right()); }
+
+    void Visit(const NegationExpression& expr) override { Prefix(ExpressionCode::Negation, expr.Left()); }
+    void Visit(const BitwiseNotExpression& expr) override { Prefix(ExpressionCode::BitwiseNot, expr.Left()); }
+
+    void Visit(const BitwiseAndExpression& expr) override { Infix(ExpressionCode::BitwiseAnd, expr); }
+    void Visit(const BitwiseOrExpression& expr) override { Infix(ExpressionCode::BitwiseOr, expr); }
+    void Visit(const BitwiseXorExpression& expr) override { Infix(ExpressionCode::BitwiseXor, expr); }
+    void Visit(const MultiplicationExpression& expr) override { Infix(ExpressionCode::Multiplication, expr); }
+    void Visit(const DivisionExpression& expr) override { Infix(ExpressionCode::Division, expr); }
+    void Visit(const AdditionExpression& expr) override { Infix(ExpressionCode::Addition, expr); }
+    void Visit(const SubtractionExpression& expr) override { Infix(ExpressionCode::Subtraction, expr); }
+    void Visit(const LogicalLeftShiftExpression& expr) override { Infix(ExpressionCode::LogicalLeftShift, expr); }
+    void Visit(const LogicalRightShiftExpression& expr) override { Infix(ExpressionCode::LogicalRightShift, expr); }
+    void Visit(const ArithmeticRightShiftExpression& expr) override { Infix(ExpressionCode::ArithmeticRightShift, expr); }
+
+private:
+    void Put(ExpressionCode op) {
+        code.push_back(static_cast<char>(op));
+    }
+
+    void Prefix(ExpressionCode op, const Expression& operand) {
+        Put(op);
+        operand.Accept(*this);
+    }
+
+    void Infix(ExpressionCode op, const InfixExpression& expr) {
+        Put(op);
+        expr.Left().Accept(*this);
+        expr.Right().Accept(*this);
+    }
+
+    std::string& code;
+    std::string& strings;
+};
+
+class ExpressionDecoder {
+public:
+    ExpressionDecoder(const char* code, std::size_t code_size, const char* strings, std::size_t strings_size)
+        : code(code), code_size(code_size), strings(strings), strings_size(strings_size) {}
+
+    std::unique_ptr<Expression> Decode(std::size_t& offset, unsigned int depth = 0) const {
+        if (depth > MaxExpressionDepth) Malformed("expression is too deep.");
+        if (offset >= code_size) Malformed("expression extends past end of file.");
+
+        auto op = static_cast<ExpressionCode>(code[offset++]);
+        switch (op) {
+            case ExpressionCode::NumericConstant: {
+                auto value = ReadWord(code, code_size, offset);
+                offset += sizeof(uint32_t);
+                return std::make_unique<NumericConstantExpression>(value);
+            }
+            case ExpressionCode::Reference: {
+                auto name_offset = ReadWord(code, code_size, offset);
+                auto name_size = ReadWord(code, code_size, offset + sizeof(uint32_t));
+                offset += 2 * sizeof(uint32_t);
+                if (name_offset > strings_size || name_size > strings_size - name_offset) {
+                    Malformed("name is outside of the string table.");
+                }
+                return std::make_unique<ReferenceExpression>(std::string(strings + name_offset, name_size));
+            }
+            case ExpressionCode::Hi: return FunctionLike<HiExpression>("hi", offset, depth);
+            case ExpressionCode::High: return FunctionLike<HighExpression>("high", offset, depth);
+            case ExpressionCode::Lo: return FunctionLike<LoExpression>("lo", offset, depth);
+            case ExpressionCode::Negation: return std::make_unique<NegationExpression>(Decode(offset, depth + 1));
+            case ExpressionCode::BitwiseNot: return std::make_unique<BitwiseNotExpression>(Decode(offset, depth + 1));
+            case ExpressionCode::BitwiseAnd: return Infix<BitwiseAndExpression>(offset, depth);
+            case ExpressionCode::BitwiseOr: return Infix<BitwiseOrExpression>(offset, depth);
+            case ExpressionCode::BitwiseXor: return Infix<BitwiseXorExpression>(offset, depth);
+            case ExpressionCode::Multiplication: return Infix<MultiplicationExpression>(offset, depth);
+            case ExpressionCode::Division: return Infix<DivisionExpression>(offset, depth);
+            case ExpressionCode::Addition: return Infix<AdditionExpression>(offset, depth);
+            case ExpressionCode::Subtraction: return Infix<SubtractionExpression>(offset, depth);
+            case ExpressionCode::LogicalLeftShift: return Infix<LogicalLeftShiftExpression>(offset, depth);
+            case ExpressionCode::LogicalRightShift: return Infix<LogicalRightShiftExpression>(offset, depth);
+            case ExpressionCode::ArithmeticRightShift: return Infix<ArithmeticRightShiftExpression>(offset, depth);
+            default:
+                Malformed("unknown expression operator.");
+        }
+    }
+
+private:
+    template<typename T>
+    std::unique_ptr<Expression> FunctionLike(const char* name, std::size_t& offset, unsigned int depth) const {
+        return std::make_unique<T>(std::make_unique<ReferenceExpression>(name), Decode(offset, depth + 1));
+    }
+
+    template<typename T>
+    std::unique_ptr<Expression> Infix(std::size_t& offset, unsigned int depth) const {
+        auto left = Decode(offset, depth + 1);
+        auto right = Decode(offset, depth + 1);
+        return std::make_unique<T>(std::move(left), std::move(right));
+    }
+
+    const char* code;
+    std::size_t code_size;
+    const char* strings;
+    std::size_t strings_size;
+};
+
+}
+
+std::string EquSnapshot::Compile(const std::vector<Entry>& listing) {
+    AssemblyState state {};
+    AssemblerDirectiveHandler directives {};
+
+    // Names and operand text, in order of first definition.
+    std::vector<std::pair<std::string, std::string>> definitions {};
+    std::set<std::string> defined {};
+
+    for (auto& entry : listing) {
+        if (!entry.operation) {
+            if (entry.label) {
+                throw std::runtime_error("Label '" + entry.label->name + "' must be defined by an equ.");
+            }
+            continue;
+        }
+
+        if (entry.operation.value() != "equ") {
+            throw std::runtime_error("Only equ directives may be precompiled, not '" + entry.operation.value() + "'.");
+        }
+
+        directives.Handle(entry, state);
+        if (defined.insert(entry.label->name).second) {
+            definitions.emplace_back(entry.label->name, entry.operands.value_or(""));
+        }
+    }
+
+    // Creates symbols for global equs.
+    for (auto& action : state.second_pass_queue2) {
+        (*action)(state);
+    }
+
+    // Resolve everything possible before taking any expressions, since they may refer to each other.
+    ExpressionResolver resolver(state);
+    std::vector<std::optional<uint32_t>> constants {};
+    for (auto& [name, text] : definitions) {
+        try {
+            constants.emplace_back(state.equs.at(name)->Resolve(resolver));
+        } catch (...) {
+            // Refers to something defined elsewhere, or uses an operator the resolver lacks.
+            constants.emplace_back(std::nullopt);
+        }
+    }
+
+    std::string strings {};
+    std::string code {};
+    std::string entries {};
+    for (std::size_t i = 0; i < definitions.size(); i++) {
+        auto& [name, text] = definitions[i];
+        auto symbol = state.GetSymbol(name);
+
+        PutWord(entries, CheckedSize(strings.size()));
+        PutWord(entries, CheckedSize(name.size()));
+        strings.append(name);
+
+        PutWord(entries, CheckedSize(strings.size()));
+        PutWord(entries, CheckedSize(text.size()));
+        strings.append(text);
+
+        if (constants[i]) {
+            PutWord(entries, constants[i].value());
+        } else {
+            PutWord(entries, CheckedSize(code.size()));
+            auto expression = state.equs.at(name)->Move();
+            ExpressionEncoder encoder(code, strings);
+            expression->Accept(encoder);
+        }
+
+        entries.push_back(static_cast<char>(constants[i] ? EntryKind::Constant : EntryKind::Expression));
+        entries.push_back(static_cast<char>(symbol && symbol->is_global));
+        entries.append(2, '\0');
+    }
+
+    auto entries_offset = HeaderSize;
+    auto strings_offset = entries_offset + entries.size();
+    auto code_offset = strings_offset + strings.size();
+
+    std::string snapshot {};
+    snapshot.append(SnapshotMagic.data(), SnapshotMagic.size());
+    PutWord(snapshot, SnapshotVersion);
+    PutWord(snapshot, CheckedSize(definitions.size()));
+    PutWord(snapshot, CheckedSize(entries_offset));
+    PutWord(snapshot, CheckedSize(strings_offset));
+    PutWord(snapshot, CheckedSize(strings.size()));
+    PutWord(snapshot, CheckedSize(code_offset));
+    PutWord(snapshot, CheckedSize(code.size()));
+
+    snapshot.append(entries);
+    snapshot.append(strings);
+    snapshot.append(code);
+
+    return snapshot;
+}
+
+EquSnapshot::EquSnapshot(const std::string& path) : mapping(std::in_place, path) {
+    data = mapping->Data();
+    size = mapping->Size();
+    ReadHeader();
+}
+
+EquSnapshot::EquSnapshot(const char* data, std::size_t size) : data(data), size(size) {
+    ReadHeader();
+}
+
+void EquSnapshot::ReadHeader() {
+    if (size < HeaderSize || std::memcmp(data, SnapshotMagic.data(), SnapshotMagic.size()) != 0) {
+        throw std::runtime_error("Not an equ snapshot.");
+    }
+
+    std::size_t offset = SnapshotMagic.size();
+    auto next = [&]() {
+        auto word = ReadWord(data, size, offset);
+        offset += sizeof(uint32_t);
+        return word;
+    };
+
+    auto version = next();
+    if (version != SnapshotVersion) {
+        throw std::runtime_error("Unsupported equ snapshot version " + std::to_string(version) + ".");
+    }
+
+    count = next();
+    entries = next();
+    strings = next();
+    strings_size = next();
+    expressions = next();
+    expressions_size = next();
+
+    auto check_section = [this](std::size_t offset, std::size_t length) {
+        if (offset > size || length > size - offset) {
+            Malformed("section extends past end of file.");
+        }
+    };
+
+    check_section(entries, std::size_t(count) * EntrySize);
+    check_section(strings, strings_size);
+    check_section(expressions, expressions_size);
+}
+
+std::optional<uint32_t> EquSnapshot::ConstantValue(std::string_view name) const {
+    for (uint32_t i = 0; i < count; i++) {
+        auto entry = entries + std::size_t(i) * EntrySize;
+        auto name_offset = ReadWord(data, size, entry);
+        auto name_size = ReadWord(data, size, entry + 4);
+        if (name_offset > strings_size || name_size > strings_size - name_offset) {
+            Malformed("name is outside of the string table.");
+        }
+
+        if (std::string_view(data + strings + name_offset, name_size) == name) {
+            if (static_cast<EntryKind>(data[entry + 20]) != EntryKind::Constant) return std::nullopt;
+            return ReadWord(data, size, entry + 16);
+        }
+    }
+
+    return std::nullopt;
+}
+
+void EquSnapshot::LoadInto(AssemblyState& state) const {
+    ExpressionDecoder decoder(data + expressions, expressions_size, data + strings, strings_size);
+
+    auto string_at = [this](uint32_t offset, uint32_t length) {
+        if (offset > strings_size || length > strings_size - offset) {
+            Malformed("name is outside of the string table.");
+        }
+        return std::string(data + strings + offset, length);
+    };
+
+    for (uint32_t i = 0; i < count; i++) {
+        auto entry = entries + std::size_t(i) * EntrySize;
+        auto name = string_at(ReadWord(data, size, entry), ReadWord(data, size, entry + 4));
+        auto text = string_at(ReadWord(data, size, entry + 8), ReadWord(data, size, entry + 12));
+        auto value = ReadWord(data, size, entry + 16);
+        auto kind = static_cast<EntryKind>(data[entry + 20]);
+        bool is_global = data[entry + 21] != 0;
+
+        std::unique_ptr<Expression> expression {};
+        if (kind == EntryKind::Constant) {
+            expression = std::make_unique<NumericConstantExpression>(value);
+        } else if (kind == EntryKind::Expression) {
+            std::size_t offset = value;
+            expression = decoder.Decode(offset);
+        } else {
+            Malformed("unknown entry kind.");
+        }
+
+        state.equs[name] = std::make_unique<ExpressionOperand>(OperandInfo { "equ", 0, text, "expression" }, std::move(expression));
+
+        if (is_global) {
+            object::SymbolInfo symbol_info {};
+            symbol_info.is_global = true;
+            symbol_info.type = object::SymbolInfo::Type::Equ;
+            if (kind == EntryKind::Constant) {
+                symbol_info.value = value;
+            }
+
+            state.UpdateSymbol(Label { name, true }, symbol_info);
+        }
+    }
+}
+
+}
\ No newline at end of file
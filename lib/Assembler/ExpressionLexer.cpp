@@ -9,8 +9,11 @@ constexpr auto MaxDecimalConstantLength = 12;
 constexpr auto MaxHexConstantLength = 8;
 constexpr auto MaxBinaryConstantLength = 32;
 
-ExpressionLexer::ExpressionLexer(std::string expression): expression(std::move(expression)),
-    lexicon({
+namespace {
+
+// Shared by all lexers. Matching against a const regex is thread-safe.
+const std::vector<std::tuple<std::regex, TokenType>>& Lexicon() {
+    static const std::vector<std::tuple<std::regex, TokenType>> lexicon = {
         // Note: order matters. E.g. we must search for hex (0x...) before searching for decimal 0.
         { std::regex(R"(^(0x|\$)[A-Fa-f0-9]+)"), TokenType::HexConstant },
         { std::regex(R"(^[0-9]+)"), TokenType::DecimalConstant },
@@ -31,7 +34,14 @@ ExpressionLexer::ExpressionLexer(std::string expression): expression(std::move(e
         { std::regex(R"(^>>)"), TokenType::DoubleRightCarrot },
         { std::regex(R"(^\()"), TokenType::LeftParen },
         { std::regex(R"(^\))"), TokenType::RightParen }
-    }){}
+    };
+
+    return lexicon;
+}
+
+}
+
+ExpressionLexer::ExpressionLexer(std::string expression): expression(std::move(expression)), lexicon(&Lexicon()) {}
 
 bool ExpressionLexer::HasNext() const {
     return !expression.empty();
@@ -44,7 +54,7 @@ std::string ExpressionLexer::GetTokenStream() const {
 ExpressionLexer ExpressionLexer::Next(assembler::Token& token) const {
     if (!HasNext()) throw TokensExhaustedException();
 
-    for (auto token_candidate : lexicon) {
+    for (auto& token_candidate : *lexicon) {
         std::smatch matches;
         if (std::regex_search(expression, matches, std::get<std::regex>(token_candidate))) {
             // Candidate matched.
@@ -0,0 +1,73 @@
+#include "IncludeCache.h"
+
+#include "AssemblerTypes.h"
+#include "InputFileParser.h"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace assembler {
+
+namespace {
+
+std::shared_ptr<const IncludeCache::Listing> Parse(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        throw std::runtime_error("Failed to open included file: " + path.string());
+    }
+
+    InputFileParser parser {};
+    parser.Parse(in);
+
+    return std::make_shared<const IncludeCache::Listing>(parser.GetListing());
+}
+
+}
+
+std::shared_ptr<const IncludeCache::Listing> IncludeCache::Get(const std::filesystem::path& path) {
+    auto canonical = std::filesystem::canonical(path);
+    auto modified = std::filesystem::last_write_time(canonical);
+    auto size = std::filesystem::file_size(canonical);
+
+    std::promise<std::shared_ptr<const Listing>> parsed {};
+    std::shared_future<std::shared_ptr<const Listing>> cached {};
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto slot = slots.find(canonical.string());
+        if (slot != slots.end() && slot->second.modified == modified && slot->second.size == size) {
+            cached = slot->second.listing;
+        } else {
+            slots[canonical.string()] = Slot { modified, size, parsed.get_future().share() };
+            parse_count++;
+        }
+    }
+
+    if (cached.valid()) {
+        // Waits if another thread is still parsing.
+        return cached.get();
+    }
+
+    try {
+        auto listing = Parse(canonical);
+        parsed.set_value(listing);
+        return listing;
+    } catch (...) {
+        // Waiters see the failure too. The next request tries again.
+        parsed.set_exception(std::current_exception());
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto slot = slots.find(canonical.string());
+        if (slot != slots.end() && slot->second.modified == modified && slot->second.size == size) {
+            slots.erase(slot);
+        }
+        throw;
+    }
+}
+
+std::size_t IncludeCache::ParseCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return parse_count;
+}
+
+}
\ No newline at end of file
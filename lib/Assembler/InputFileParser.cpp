@@ -18,8 +18,12 @@ const std::vector<Entry>& InputFileParser::GetListing() const {
     return listing;
 }
 
+std::size_t InputFileParser::GetLineNumber() const {
+    return line_number;
+}
+
 bool InputFileParser::ParseComment(const std::string& line, Entry& entry) const {
-    const std::regex comment(R"(^\*)");
+    static const std::regex comment(R"(^\*)");
 
     if (std::regex_search(line, comment)) {
         entry.comment = std::regex_replace(line, comment, "");
@@ -30,20 +34,20 @@ bool InputFileParser::ParseComment(const std::string& line, Entry& entry) const
 }
 
 bool InputFileParser::ParseBlank(const std::string& line) const {
-    const std::regex blank(R"(\s*)");
+    static const std::regex blank(R"(\s*)");
     return std::regex_match(line, blank);
 }
 
 std::string InputFileParser::ParseSeparator(const std::string& line) const {
-    const std::regex field_separator(R"(^(\t|\ )+)");
+    static const std::regex field_separator(R"(^(\t|\ )+)");
     return std::regex_replace(line, field_separator, "");
 }
 
 std::string InputFileParser::ParseLabel(const std::string& line, Entry& entry) const {
-    const std::regex field_separator(R"(^(\t|\ )+)");
-    const std::regex label_designator("^=");
-    const std::regex label("^[A-Za-z@_][A-Za-z0-9@_$.]*"); // symbolic name
-    const std::regex label_global_terminator("^:");
+    static const std::regex field_separator(R"(^(\t|\ )+)");
+    static const std::regex label_designator("^=");
+    static const std::regex label("^[A-Za-z@_][A-Za-z0-9@_$.]*"); // symbolic name
+    static const std::regex label_global_terminator("^:");
 
     std::string rest = line;
 
@@ -85,7 +89,7 @@ std::string InputFileParser::ParseLabel(const std::string& line, Entry& entry) c
 
 std::string InputFileParser::ParseOperation(const std::string& line, Entry& entry) const {
     // TODO: make sure this matches only non-space, non-special chars
-    const std::regex operation(R"(^\S+)");
+    static const std::regex operation(R"(^\S+)");
 
     std::smatch matches{};
     if (std::regex_search(line, matches, operation)) {
@@ -99,7 +103,7 @@ std::string InputFileParser::ParseOperation(const std::string& line, Entry& entr
 
 std::string InputFileParser::ParseOperands(const std::string& line, Entry& entry) const {
     // TODO: make sure this matches only non-space, non-special chars
-    const std::regex operands(R"(^\S+)");
+    static const std::regex operands(R"(^\S+)");
 
     std::smatch matches{};
     if (std::regex_search(line, matches, operands)) {
@@ -121,12 +125,15 @@ void InputFileParser::Parse(std::istream& lines) {
 
     std::string line;
     while (std::getline(lines, line)) {
+        line_number++;
+
         if (ParseBlank(line)) {
             // Skip blank line.
             continue;
         }
 
         Entry entry;
+        entry.line = line_number;
 
         if (ParseComment(line, entry)) goto done;
         line = ParseLabel(line, entry);
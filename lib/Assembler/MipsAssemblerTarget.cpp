@@ -18,7 +18,7 @@ using expression::Expression;
 namespace {
 
 uint32_t ParseRegister(std::string register_str) {
-    auto name_to_reg = std::vector<std::regex> {
+    static const auto name_to_reg = std::vector<std::regex> {
         std::regex(R"((\$0|zero))"),
         std::regex(R"((\$1|at))"),
         std::regex(R"((\$2|v0))"),
@@ -0,0 +1,317 @@
+#include "Driver.h"
+
+#include <Assembler.h>
+#include <AssemblerTypes.h>
+#include <AssemblyState.h>
+#include <InputFileParser.h>
+#include <MipsAssemblerTarget.h>
+#include <ObjectFile.h>
+#include <Rof15ObjectWriter.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+
+namespace driver {
+
+namespace {
+
+Diagnostic Error(std::string message, std::filesystem::path file = {}, std::size_t line = 0) {
+    return Diagnostic { Diagnostic::Severity::Error, std::move(file), line, std::move(message) };
+}
+
+// Assembly failures aren't all std::exceptions.
+std::string DescribeCurrentException() {
+    try {
+        throw;
+    } catch (std::exception const& e) {
+        return e.what();
+    } catch (const char* e) {
+        return e;
+    } catch (...) {
+        return "unknown error";
+    }
+}
+
+// Write the ROF for result's object. On failure, the object is dropped and the error reported.
+void WriteRof(AssembleResult& result) {
+    try {
+        rof::Rof15ObjectWriter writer {};
+
+        std::ostringstream rof {};
+        writer.Write(*result.object, rof);
+        result.rof = rof.str();
+    } catch (...) {
+        result.diagnostics.push_back(Error(DescribeCurrentException()));
+        result.object.reset();
+    }
+}
+
+// Also reports the offset of each instruction in listing, if instruction_offsets is set.
+AssembleResult AssembleListing(const std::vector<assembler::Entry>& listing, const AssembleOptions& options,
+    std::vector<std::optional<std::size_t>>* instruction_offsets) {
+    AssembleResult result {};
+
+    assembler::Assembler a(options.assembler_version, std::make_unique<assembler::MipsAssemblerTarget>(options.endian));
+
+    if (options.fixed_time) {
+        a.SetFixedAssemblyTime(options.fixed_time.value());
+    }
+
+    for (auto& snapshot : options.equ_snapshots) {
+        a.AddEquSnapshot(snapshot);
+    }
+
+    if (options.include_cache) {
+        a.SetIncludeCache(options.include_cache);
+    }
+
+    for (auto& directory : options.include_directories) {
+        a.AddIncludeDirectory(directory);
+    }
+
+    a.SetWorkingDirectory(options.working_directory);
+
+    std::unique_ptr<object::ObjectFile> object {};
+    try {
+        object = a.Process(listing);
+    } catch (...) {
+        auto location = a.GetFailureLocation().value_or(assembler::SourceLocation {});
+        result.diagnostics.push_back(Error(DescribeCurrentException(), location.file, location.line));
+        result.included_files = a.GetIncludedFiles();
+        return result;
+    }
+
+    result.included_files = a.GetIncludedFiles();
+    result.object = std::move(object);
+
+    if (instruction_offsets) {
+        *instruction_offsets = a.GetInstructionOffsets();
+    }
+
+    WriteRof(result);
+    return result;
+}
+
+bool SameLabel(const std::optional<assembler::Label>& a, const std::optional<assembler::Label>& b) {
+    if (!a || !b) {
+        return !a && !b;
+    }
+
+    return a->name == b->name && a->is_global == b->is_global;
+}
+
+// Options which may change the layout or the encoding of a listing.
+bool SameOptions(const AssembleOptions& a, const AssembleOptions& b) {
+    return a.assembler_version == b.assembler_version
+        && a.endian == b.endian
+        && a.fixed_time == b.fixed_time
+        && a.include_directories == b.include_directories
+        && a.working_directory == b.working_directory
+        && a.equ_snapshots == b.equ_snapshots;
+}
+
+}
+
+AssembleResult Assemble(std::string_view source, const AssembleOptions& options) {
+    assembler::InputFileParser parser {};
+    try {
+        std::istringstream in { std::string(source) };
+        parser.Parse(in);
+    } catch (...) {
+        AssembleResult result {};
+        result.diagnostics.push_back(Error(DescribeCurrentException(), {}, parser.GetLineNumber()));
+        return result;
+    }
+
+    return Assemble(parser.GetListing(), options);
+}
+
+AssembleResult Assemble(const std::vector<assembler::Entry>& listing, const AssembleOptions& options) {
+    return AssembleListing(listing, options, nullptr);
+}
+
+std::vector<Diagnostic> IncrementalListing::Update(std::string_view source) {
+    std::unordered_map<std::string, ParsedLine> current {};
+    std::vector<Diagnostic> diagnostics {};
+
+    listing.clear();
+    last_parsed = 0;
+
+    std::size_t line_number = 0;
+    std::size_t start = 0;
+    while (start < source.size()) {
+        auto end = source.find('\n', start);
+        if (end == std::string_view::npos) end = source.size();
+
+        std::string text(source.substr(start, end - start));
+        start = end + 1;
+        line_number++;
+
+        auto parsed = current.find(text);
+        if (parsed == current.end()) {
+            auto previous = lines.find(text);
+            if (previous != lines.end()) {
+                parsed = current.emplace(text, std::move(previous->second)).first;
+                lines.erase(previous);
+            } else {
+                ParsedLine line {};
+                try {
+                    std::istringstream in(text);
+                    assembler::InputFileParser parser {};
+                    parser.Parse(in);
+
+                    if (!parser.GetListing().empty()) {
+                        line.entry = parser.GetListing().front();
+                    }
+                } catch (...) {
+                    line.error = DescribeCurrentException();
+                }
+
+                last_parsed++;
+                parsed = current.emplace(text, std::move(line)).first;
+            }
+        }
+
+        if (parsed->second.error) {
+            diagnostics.push_back(Error(parsed->second.error.value(), {}, line_number));
+        } else if (parsed->second.entry) {
+            auto& entry = listing.emplace_back(parsed->second.entry.value());
+            entry.line = line_number;
+        }
+    }
+
+    // Lines no longer in the source are dropped.
+    lines = std::move(current);
+
+    return diagnostics;
+}
+
+AssembleResult IncrementalAssembly::Update(const std::vector<assembler::Entry>& listing, const AssembleOptions& options) {
+    auto kept = KeepLayout(listing, options);
+    last_kept_layout = kept.has_value();
+
+    AssembleResult result {};
+    if (kept) {
+        result = std::move(kept.value());
+    } else {
+        result = AssembleListing(listing, options, &instruction_offsets);
+        previous_listing = listing;
+        last_encoded = std::count_if(instruction_offsets.begin(), instruction_offsets.end(),
+            [](auto& offset) { return offset.has_value(); });
+
+        included_files.clear();
+        for (auto& path : result.included_files) {
+            std::error_code error {};
+            included_files.push_back({
+                path, std::filesystem::last_write_time(path, error), std::filesystem::file_size(path, error)
+            });
+        }
+    }
+
+    previous_options = options;
+    previous = result.rof ? std::optional<AssembleResult>(result) : std::nullopt;
+
+    return result;
+}
+
+std::optional<AssembleResult> IncrementalAssembly::KeepLayout(
+    const std::vector<assembler::Entry>& listing,
+    const AssembleOptions& options
+) {
+    if (!previous || listing.size() != previous_listing.size() || !SameOptions(options, previous_options) || IncludesChanged()) {
+        return std::nullopt;
+    }
+
+    // An instruction's size doesn't depend on its operands, so they may change without moving anything.
+    std::vector<std::size_t> changed {};
+    for (std::size_t i = 0; i < listing.size(); i++) {
+        auto& entry = listing[i];
+        auto& before = previous_listing[i];
+
+        if (!SameLabel(entry.label, before.label) || entry.operation != before.operation) {
+            return std::nullopt;
+        }
+
+        if (entry.operands != before.operands) {
+            if (!instruction_offsets[i]) {
+                return std::nullopt;
+            }
+
+            changed.push_back(i);
+        }
+    }
+
+    last_encoded = changed.size();
+    if (changed.empty()) {
+        return previous;
+    }
+
+    auto object = std::make_unique<object::ObjectFile>(*previous->object);
+    assembler::MipsAssemblerTarget target(options.endian);
+    auto handler = target.GetOperationHandler();
+
+    for (auto i : changed) {
+        auto offset = instruction_offsets[i].value();
+
+        assembler::AssemblyState state {};
+        state.in_psect = true;
+        state.result->counter.code = offset;
+
+        try {
+            handler->Handle(listing[i], state);
+        } catch (...) {
+            // Left to the full pass, which attributes the failure to its line.
+            return std::nullopt;
+        }
+
+        auto encoded = state.result->psect.code_data.find(offset);
+        auto existing = object->psect.code_data.find(offset);
+        if (encoded == state.result->psect.code_data.end() || existing == object->psect.code_data.end()
+            || encoded->second.size != existing->second.size) {
+            return std::nullopt;
+        }
+
+        existing->second = std::move(encoded->second);
+    }
+
+    if (!options.fixed_time) {
+        object->assembly_time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    }
+
+    for (auto i : changed) {
+        previous_listing[i] = listing[i];
+    }
+
+    AssembleResult result {};
+    result.included_files = previous->included_files;
+    result.object = std::move(object);
+
+    WriteRof(result);
+    return result;
+}
+
+bool IncrementalAssembly::IncludesChanged() const {
+    return std::any_of(included_files.begin(), included_files.end(), [](auto& file) {
+        std::error_code error {};
+        return std::filesystem::last_write_time(file.path, error) != file.modified
+            || std::filesystem::file_size(file.path, error) != file.size
+            || error;
+    });
+}
+
+std::string FormatDiagnostic(const Diagnostic& diagnostic, std::string_view source_name) {
+    std::string formatted = diagnostic.file.empty() ? std::string(source_name) : diagnostic.file.string();
+
+    if (diagnostic.line != 0) {
+        formatted += ":" + std::to_string(diagnostic.line);
+    }
+
+    formatted += diagnostic.severity == Diagnostic::Severity::Error ? ": error: " : ": warning: ";
+    formatted += diagnostic.message;
+
+    return formatted;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,232 @@
+#include "SourceIndex.h"
+
+#include <EquSnapshot.h>
+#include <ExpressionLexer.h>
+#include <ExpressionParser.h>
+#include <IncludeCache.h>
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace driver {
+
+namespace {
+
+using namespace expression;
+
+std::optional<Definition> Define(const assembler::Entry& entry, const std::filesystem::path& file) {
+    if (!entry.label || entry.operation == "use") {
+        return std::nullopt;
+    }
+
+    Definition definition {};
+    definition.name = entry.label->name;
+    definition.is_global = entry.label->is_global;
+    definition.file = file;
+    definition.line = entry.line;
+
+    if (entry.operation == "equ" || entry.operation == "set") {
+        definition.kind = entry.operation == "equ" ? Definition::Kind::Equ : Definition::Kind::Set;
+        definition.operands = entry.operands.value_or("");
+    }
+
+    return definition;
+}
+
+// Like the assembler's resolver, but references are looked up by the caller.
+struct Evaluator : ExpressionVisitor {
+    using ReferenceResolver = std::function<uint32_t(const std::string&)>;
+
+    explicit Evaluator(const ReferenceResolver& reference_resolver) : reference_resolver(reference_resolver) {}
+
+    uint32_t Evaluate(const Expression& expr) const {
+        Evaluator evaluator(reference_resolver);
+        expr.Accept(evaluator);
+        return evaluator.result;
+    }
+
+    void Visit(const NumericConstantExpression& expr) override { result = expr.value; }
+    void Visit(const ReferenceExpression& expr) override { result = reference_resolver(expr.Value()); }
+
+    void Visit(const HiExpression&) override { Unsupported(); }
+    void Visit(const HighExpression&) override { Unsupported(); }
+    void Visit(const LoExpression&) override { Unsupported(); }
+    void Visit(const ArithmeticRightShiftExpression&) override { Unsupported(); }
+
+    void Visit(const NegationExpression& expr) override { result = -Evaluate(expr.Left()); }
+    void Visit(const BitwiseNotExpression& expr) override { result = ~Evaluate(expr.Left()); }
+    void Visit(const BitwiseAndExpression& expr) override { result = Evaluate(expr.Left()) & Evaluate(expr.Right()); }
+    void Visit(const BitwiseOrExpression& expr) override { result = Evaluate(expr.Left()) | Evaluate(expr.Right()); }
+    void Visit(const BitwiseXorExpression& expr) override { result = Evaluate(expr.Left()) ^ Evaluate(expr.Right()); }
+    void Visit(const MultiplicationExpression& expr) override { result = Evaluate(expr.Left()) * Evaluate(expr.Right()); }
+    void Visit(const AdditionExpression& expr) override { result = Evaluate(expr.Left()) + Evaluate(expr.Right()); }
+    void Visit(const SubtractionExpression& expr) override { result = Evaluate(expr.Left()) - Evaluate(expr.Right()); }
+    void Visit(const LogicalLeftShiftExpression& expr) override { result = Evaluate(expr.Left()) << Evaluate(expr.Right()); }
+    void Visit(const LogicalRightShiftExpression& expr) override { result = Evaluate(expr.Left()) >> Evaluate(expr.Right()); }
+
+    void Visit(const DivisionExpression& expr) override {
+        auto divisor = Evaluate(expr.Right());
+        if (divisor == 0) throw std::runtime_error("division by zero");
+        result = Evaluate(expr.Left()) / divisor;
+    }
+
+    uint32_t result {};
+
+private:
+    [[noreturn]] static void Unsupported() {
+        throw std::runtime_error("operator can't be evaluated");
+    }
+
+    const ReferenceResolver& reference_resolver;
+};
+
+}
+
+SourceIndex::SourceIndex(AssembleOptions options) : options(std::move(options)) {
+    if (!this->options.include_cache) {
+        // Used files are kept parsed between analyses.
+        this->options.include_cache = std::make_shared<assembler::IncludeCache>();
+    }
+}
+
+void SourceIndex::Update(std::string_view source) {
+    parse_diagnostics = listing.Update(source);
+    analyzed = false;
+
+    definitions.clear();
+    definition_index.clear();
+    for (auto& entry : listing.Listing()) {
+        if (auto definition = Define(entry, {})) {
+            definition_index.emplace(definition->name, definitions.size());
+            definitions.push_back(std::move(definition.value()));
+        }
+    }
+
+    // Keep only the expressions still in use.
+    std::unordered_map<std::string, std::shared_ptr<const Expression>> used {};
+    auto keep = [&](const Definition& definition) {
+        auto expression = expressions.find(definition.operands);
+        if (expression != expressions.end()) {
+            used.insert(*expression);
+        }
+    };
+
+    std::for_each(definitions.begin(), definitions.end(), keep);
+    for (auto& [name, definition] : included_definitions) {
+        keep(definition);
+    }
+
+    expressions = std::move(used);
+    values.clear();
+}
+
+void SourceIndex::Analyze() {
+    auto result = Assemble(listing.Listing(), options);
+    analysis_diagnostics = std::move(result.diagnostics);
+    analyzed = true;
+
+    if (result.object) {
+        layout = Layout { result.object->psect.symbols, result.object->counter };
+    } else {
+        layout.reset();
+    }
+
+    // Used files are already parsed and cached by the assembly.
+    included_definitions.clear();
+    for (auto& file : result.included_files) {
+        auto included = options.include_cache->Get(file);
+        for (auto& entry : *included) {
+            if (auto definition = Define(entry, file)) {
+                included_definitions.emplace(definition->name, std::move(definition.value()));
+            }
+        }
+    }
+
+    values.clear();
+}
+
+const std::vector<Diagnostic>& SourceIndex::Diagnostics() const {
+    return parse_diagnostics.empty() ? analysis_diagnostics : parse_diagnostics;
+}
+
+const Definition* SourceIndex::FindDefinition(std::string_view name) const {
+    std::string key(name);
+
+    auto definition = definition_index.find(key);
+    if (definition != definition_index.end()) {
+        return &definitions[definition->second];
+    }
+
+    auto included = included_definitions.find(key);
+    if (included != included_definitions.end()) {
+        return &included->second;
+    }
+
+    return nullptr;
+}
+
+std::optional<uint32_t> SourceIndex::Value(std::string_view name) const {
+    std::vector<std::string> resolving {};
+    return Evaluate(std::string(name), resolving);
+}
+
+std::optional<uint32_t> SourceIndex::Evaluate(const std::string& name, std::vector<std::string>& resolving) const {
+    auto cached = values.find(name);
+    if (cached != values.end()) {
+        return cached->second;
+    }
+
+    // Equs may refer to each other in a cycle, which has no value.
+    if (std::find(resolving.begin(), resolving.end(), name) != resolving.end()) {
+        return std::nullopt;
+    }
+
+    std::optional<uint32_t> value {};
+    auto definition = FindDefinition(name);
+    if (definition && definition->kind != Definition::Kind::Label) {
+        if (auto expression = ParseOperands(definition->operands)) {
+            resolving.push_back(name);
+
+            Evaluator::ReferenceResolver resolve_reference = [&](const std::string& reference) {
+                auto referenced = Evaluate(reference, resolving);
+                if (!referenced) throw std::runtime_error("'" + reference + "' isn't constant");
+                return referenced.value();
+            };
+
+            try {
+                value = Evaluator(resolve_reference).Evaluate(*expression);
+            } catch (...) {
+                // Refers to a label or an external name, or uses an operator that can't be evaluated.
+            }
+
+            resolving.pop_back();
+        }
+    } else if (!definition) {
+        for (auto& snapshot : options.equ_snapshots) {
+            if ((value = snapshot->ConstantValue(name))) break;
+        }
+    }
+
+    values.emplace(name, value);
+    return value;
+}
+
+const expression::Expression* SourceIndex::ParseOperands(const std::string& operands) const {
+    auto parsed = expressions.find(operands);
+    if (parsed == expressions.end()) {
+        std::shared_ptr<const Expression> expression {};
+        try {
+            assembler::ExpressionParser parser { assembler::ExpressionLexer(operands) };
+            expression = parser.Parse();
+        } catch (...) {
+            // Reported by analysis.
+        }
+
+        parsed = expressions.emplace(operands, std::move(expression)).first;
+    }
+
+    return parsed->second.get();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,620 @@
+#include <Linker.h>
+
+#include <BinarySectionWriter.h>
+#include <ModuleHeader.hpp>
+#include <ModuleUtils.hpp>
+#include <Rof15ObjectFile.h>
+#include <Rof15ObjectReader.h>
+#include <RofArchive.h>
+#include <Serialization.h>
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+namespace linker {
+
+namespace {
+
+constexpr std::size_t SectionAlignment = 4;
+constexpr std::size_t CrcSize = 4;
+constexpr uint32_t NoTrapHandler = 0xFFFFFFFF;
+
+// Relocatable values are relative to the start of the module (Code) or of the data area (Data).
+enum class Area {
+    Absolute,
+    Code,
+    Data
+};
+
+struct Value {
+    uint32_t value;
+    Area area;
+};
+
+struct ObjectLayout {
+    // Module offset of the object's code.
+    uint32_t code;
+
+    // Data area offsets of the object's data.
+    uint32_t initialized_data;
+    uint32_t uninitialized_data;
+};
+
+struct Layout {
+    std::vector<ObjectLayout> objects {};
+
+    std::size_t code_size = 0;
+    std::size_t initialized_data_size = 0;
+    std::size_t data_size = 0;
+
+    // Module offsets.
+    std::size_t name = 0;
+    std::size_t initialized_data_header = 0;
+    std::size_t initialized_data = 0;
+    std::size_t initialized_data_refs = 0;
+};
+
+struct Symbol {
+    Value value;
+    std::size_t object;
+};
+
+// A 32-bit pointer in initialized data which must be adjusted by the code or data base at load time.
+struct DataPointer {
+    Area area;
+    uint32_t offset;
+};
+
+/**
+ * Get the result of every task. All tasks finish before any exception is rethrown, since they
+ * refer to state owned by the caller.
+ */
+template<typename T>
+std::vector<T> GetAll(std::vector<std::future<T>>& futures) {
+    for (auto& future : futures) {
+        future.wait();
+    }
+
+    std::vector<T> results {};
+    results.reserve(futures.size());
+    for (auto& future : futures) {
+        results.push_back(future.get());
+    }
+
+    return results;
+}
+
+std::size_t Align(std::size_t value, std::size_t alignment = SectionAlignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+uint32_t CheckedOffset(std::size_t offset) {
+    if (offset > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Module is too large.");
+    }
+    return static_cast<uint32_t>(offset);
+}
+
+uint16_t SyncBytesFor(uint16_t cpu) {
+    switch (cpu) {
+        case 0x100: return 0x4AFC; // 68k
+        case 0x800: return 0x4DAD; // MIPS
+        default:
+            throw std::runtime_error("Unsupported target CPU for linking: " + std::to_string(cpu));
+    }
+}
+
+std::string ObjectName(const rof::Rof15ObjectReader& object) {
+    return object.Header().Name();
+}
+
+Layout GetLayout(const std::vector<std::shared_ptr<const rof::Rof15ObjectReader>>& objects, const std::string& name) {
+    Layout layout {};
+    layout.objects.resize(objects.size());
+
+    std::size_t code = 0;
+    std::size_t initialized_data = 0;
+    for (std::size_t i = 0; i < objects.size(); i++) {
+        auto header = objects[i]->Header();
+
+        if (header.RemoteInitializedDataSizeRequired() != 0 || header.RemoteStaticDataSizeRequired() != 0) {
+            throw std::runtime_error(ObjectName(*objects[i]) + ": remote data is not supported.");
+        }
+
+        code = Align(code);
+        initialized_data = Align(initialized_data);
+        layout.objects[i].code = CheckedOffset(sizeof(module::ModuleHeader) + code);
+        layout.objects[i].initialized_data = CheckedOffset(initialized_data);
+
+        code += header.CodeSize();
+        initialized_data += header.InitializedDataSize();
+    }
+
+    layout.code_size = code;
+    layout.initialized_data_size = initialized_data;
+
+    std::size_t data = Align(initialized_data);
+    for (std::size_t i = 0; i < objects.size(); i++) {
+        data = Align(data);
+        layout.objects[i].uninitialized_data = CheckedOffset(data);
+        data += objects[i]->Header().StaticDataSize();
+    }
+
+    layout.data_size = data;
+
+    layout.name = sizeof(module::ModuleHeader) + code;
+    layout.initialized_data_header = Align(layout.name + name.size() + 1);
+    layout.initialized_data = layout.initialized_data_header + sizeof(module::InitDataHeader);
+    layout.initialized_data_refs = Align(layout.initialized_data + initialized_data);
+
+    CheckedOffset(layout.initialized_data_refs);
+    CheckedOffset(layout.data_size);
+
+    return layout;
+}
+
+Value SymbolValue(uint16_t type, uint32_t value, const ObjectLayout& layout) {
+    constexpr auto code = static_cast<uint16_t>(rof::DefinitionType::Code);
+    constexpr uint16_t kind_mask = 0x3;
+
+    if (type & code) {
+        // Set and equ symbols carry their value in place of an offset.
+        if (type & kind_mask) {
+            return Value { value, Area::Absolute };
+        }
+        return Value { layout.code + value, Area::Code };
+    }
+
+    switch (static_cast<rof::DefinitionType>(type & kind_mask)) {
+        case rof::DefinitionType::Initialized:
+            return Value { layout.initialized_data + value, Area::Data };
+        case rof::DefinitionType::Uninitialized:
+            return Value { layout.uninitialized_data + value, Area::Data };
+        default:
+            throw std::runtime_error("Remote data symbols are not supported.");
+    }
+}
+
+class ExpressionEvaluator {
+public:
+    ExpressionEvaluator(const ObjectLayout& layout, const std::vector<Value>& extern_refs)
+        : layout(layout), extern_refs(extern_refs) {}
+
+    Value operator()(const rof::ExpressionTreeView& tree) const {
+        using rof::ExpressionOperator;
+
+        switch (tree.Op()) {
+            case ExpressionOperator::NumericConstant:
+                return Value { tree.Value(), Area::Absolute };
+            case ExpressionOperator::Reference: {
+                auto ref = tree.Ref();
+                if (ref.Flags() & rof::LocalReferenceFlag) {
+                    return SymbolValue(ref.Flags() & ~rof::LocalReferenceFlag, ref.Value(), layout);
+                }
+
+                if (ref.Value() >= extern_refs.size()) {
+                    throw std::runtime_error("Expression refers to a missing extern ref.");
+                }
+                return extern_refs[ref.Value()];
+            }
+            default:
+                break;
+        }
+
+        auto left = (*this)(tree.Operand1());
+        auto a = left.value;
+
+        switch (tree.Op()) {
+            case ExpressionOperator::Hi: return Absolute(((a + 0x8000U) >> 16U) & 0xFFFFU);
+            case ExpressionOperator::High: return Absolute(a >> 16U);
+            case ExpressionOperator::Lo: return Absolute(a & 0xFFFFU);
+            case ExpressionOperator::ArithmeticNegation: return Absolute(-a);
+            case ExpressionOperator::BitwiseNegation: return Absolute(~a);
+            default:
+                break;
+        }
+
+        auto right = (*this)(tree.Operand2());
+        auto b = right.value;
+
+        switch (tree.Op()) {
+            case ExpressionOperator::Addition:
+                return Value { a + b, left.area != Area::Absolute ? left.area : right.area };
+            case ExpressionOperator::Subtraction:
+                // The distance between two symbols in the same area is absolute.
+                return Value { a - b, left.area == right.area ? Area::Absolute : left.area };
+            case ExpressionOperator::BitwiseAnd: return Absolute(a & b);
+            case ExpressionOperator::BitwiseOr: return Absolute(a | b);
+            case ExpressionOperator::BitwiseXor: return Absolute(a ^ b);
+            case ExpressionOperator::Multiplication: return Absolute(a * b);
+            case ExpressionOperator::Division:
+                if (b == 0) throw std::runtime_error("Division by zero in expression.");
+                return Absolute(a / b);
+            case ExpressionOperator::LeftShift: return Absolute(b >= 32 ? 0 : a << b);
+            case ExpressionOperator::RightShift: return Absolute(b >= 32 ? 0 : a >> b);
+            case ExpressionOperator::ArithmeticRightShift:
+                return Absolute(static_cast<uint32_t>(static_cast<int32_t>(a) >> std::min(b, 31U)));
+            default:
+                throw std::runtime_error("Unknown expression operator.");
+        }
+    }
+
+private:
+    static Value Absolute(uint32_t value) {
+        return Value { value, Area::Absolute };
+    }
+
+    const ObjectLayout& layout;
+    const std::vector<Value>& extern_refs;
+};
+
+bool Fits(uint32_t value, unsigned int length, bool is_signed) {
+    if (length >= 32) return true;
+
+    auto as_signed = static_cast<int32_t>(value);
+    auto limit = static_cast<int32_t>(1U << (length - 1));
+    bool fits_signed = as_signed >= -limit && as_signed < limit;
+
+    // Unsigned fields also accept negative values, which the assembler allows for immediates.
+    return is_signed ? fits_signed : (value < (1U << length) || fits_signed);
+}
+
+/**
+ * Write value into a bit field. The field is bit_number bits from the least significant end of a
+ * big endian container, which starts at offset and is just wide enough to hold the field.
+ */
+void PatchField(char* section, std::size_t section_size, rof::Reference& ref, uint32_t value) {
+    unsigned int bit = ref.BitNumber();
+    unsigned int length = ref.FieldLength();
+
+    if (length == 0 || bit + length > 32) {
+        throw std::runtime_error("Unsupported reference field of " + std::to_string(length) + " bits at bit "
+            + std::to_string(bit) + ".");
+    }
+
+    std::size_t container = (bit + length + 7) / 8;
+    std::size_t offset = ref.LocalOffset();
+    if (offset > section_size || container > section_size - offset) {
+        throw std::runtime_error("Reference is outside of its section.");
+    }
+
+    bool is_signed = ref.LocationFlag() & static_cast<uint16_t>(rof::ReferenceFlags::Signed);
+    if (!Fits(value, length, is_signed)) {
+        throw std::runtime_error("Value " + std::to_string(value) + " does not fit in a "
+            + std::to_string(length) + " bit field.");
+    }
+
+    auto* bytes = reinterpret_cast<uint8_t*>(section + offset);
+
+    uint32_t word = 0;
+    for (std::size_t i = 0; i < container; i++) {
+        word = word << 8U | bytes[i];
+    }
+
+    uint32_t mask = (length == 32 ? 0xFFFFFFFFU : (1U << length) - 1) << bit;
+    word = (word & ~mask) | ((value << bit) & mask);
+
+    for (std::size_t i = container; i > 0; i--) {
+        bytes[i - 1] = static_cast<uint8_t>(word);
+        word >>= 8U;
+    }
+}
+
+/**
+ * Copy one section of an object into the module and apply the object's references to it.
+ * Returns the pointers which need adjusting at load time.
+ */
+std::vector<DataPointer> RelocateSection(const rof::Rof15ObjectReader& object, const ObjectLayout& layout,
+    const std::vector<Value>& extern_refs, bool code_section, char* destination, uint32_t data_area_offset) {
+    auto source = code_section ? object.Code() : object.InitializedData();
+    std::memcpy(destination, source.data(), source.size());
+
+    ExpressionEvaluator evaluate(layout, extern_refs);
+    std::vector<DataPointer> pointers {};
+
+    constexpr auto code_flag = static_cast<uint16_t>(rof::ReferenceFlags::Code);
+    constexpr auto remote_flag = static_cast<uint16_t>(rof::ReferenceFlags::Remote);
+
+    for (auto ref : object.References()) {
+        bool in_code = ref.LocationFlag() & code_flag;
+        if (in_code != code_section) continue;
+
+        if (ref.LocationFlag() & remote_flag) {
+            throw std::runtime_error("Remote data references are not supported.");
+        }
+
+        try {
+            auto value = evaluate(object.ExpressionTreeAt(ref.ExprTreeIndex()));
+            PatchField(destination, source.size(), ref, value.value);
+
+            if (!code_section && value.area != Area::Absolute && ref.BitNumber() == 0 && ref.FieldLength() == 32) {
+                pointers.push_back(DataPointer { value.area, data_area_offset + ref.LocalOffset() });
+            }
+        } catch (std::exception const& e) {
+            std::ostringstream message {};
+            message << ObjectName(object) << ": " << (code_section ? "code" : "data") << " offset 0x"
+                    << std::hex << ref.LocalOffset() << ": " << e.what();
+            throw std::runtime_error(message.str());
+        }
+    }
+
+    return pointers;
+}
+
+/**
+ * Serialize the initialized data reference lists: code pointers, then data pointers. Each list is
+ * a sequence of groups (MSW, count, count LSWs), terminated by a zero MSW and count.
+ */
+std::vector<char> GetDataReferenceLists(std::vector<DataPointer> pointers, support::Endian endian) {
+    std::sort(pointers.begin(), pointers.end(), [](const DataPointer& a, const DataPointer& b) {
+        return std::make_pair(a.area, a.offset) < std::make_pair(b.area, b.offset);
+    });
+
+    std::vector<uint16_t> words {};
+    for (auto area : { Area::Code, Area::Data }) {
+        auto itr = std::find_if(pointers.begin(), pointers.end(), [area](auto& p) { return p.area == area; });
+
+        while (itr != pointers.end() && itr->area == area) {
+            auto msw = static_cast<uint16_t>(itr->offset >> 16U);
+            auto group_end = std::find_if(itr, pointers.end(), [area, msw](auto& p) {
+                return p.area != area || (p.offset >> 16U) != msw;
+            });
+
+            words.push_back(msw);
+            words.push_back(static_cast<uint16_t>(group_end - itr));
+            for (; itr != group_end; ++itr) {
+                words.push_back(static_cast<uint16_t>(itr->offset));
+            }
+        }
+
+        words.push_back(0);
+        words.push_back(0);
+    }
+
+    std::vector<char> lists(words.size() * sizeof(uint16_t));
+    support::BinarySectionWriter writer(lists.data(), lists.size(), endian);
+    for (auto word : words) {
+        writer.Write(word);
+    }
+
+    return lists;
+}
+
+}
+
+Linker::Linker(unsigned int worker_count) : worker_count(std::max(worker_count, 1U)) {}
+
+void Linker::AddObject(std::shared_ptr<const rof::Rof15ObjectReader> object) {
+    objects.push_back(std::move(object));
+}
+
+void Linker::AddArchive(std::shared_ptr<const rof::RofArchive> archive) {
+    archives.push_back(std::move(archive));
+}
+
+std::vector<std::shared_ptr<const rof::Rof15ObjectReader>> Linker::GetObjectsToLink() const {
+    auto linked = objects;
+    if (archives.empty()) {
+        return linked;
+    }
+
+    std::unordered_set<std::string_view> defined {};
+    std::vector<std::string_view> wanted {};
+    auto add = [&](const rof::Rof15ObjectReader& object) {
+        for (auto def : object.ExternDefinitions()) {
+            defined.insert(def.name);
+        }
+        for (auto name : object.ExternRefs()) {
+            wanted.push_back(name);
+        }
+    };
+
+    for (auto& object : objects) {
+        add(*object);
+    }
+
+    // Pull in the member which defines each symbol that's still missing. Members bring their
+    // own extern refs, which are resolved in turn. Archives are searched in the order added.
+    std::set<std::pair<std::size_t, uint32_t>> pulled {};
+    for (std::size_t next = 0; next < wanted.size(); next++) {
+        auto name = wanted[next];
+        if (defined.count(name)) continue;
+
+        for (std::size_t i = 0; i < archives.size(); i++) {
+            auto member = archives[i]->FindSymbol(name);
+            if (!member) continue;
+
+            if (pulled.emplace(i, *member).second) {
+                std::shared_ptr<const rof::Rof15ObjectReader> object = archives[i]->OpenMember(*member);
+                add(*object);
+                linked.push_back(std::move(object));
+            }
+            break;
+        }
+    }
+
+    return linked;
+}
+
+std::vector<char> Linker::Link(const ModuleOptions& options) const {
+    auto objects = GetObjectsToLink();
+    if (objects.empty()) {
+        throw std::runtime_error("No objects to link.");
+    }
+
+    auto first_header = objects.front()->Header();
+    auto endian = objects.front()->Endian();
+    auto cpu = first_header.TargetCPU();
+
+    for (auto& object : objects) {
+        if (object->Header().TargetCPU() != cpu) {
+            throw std::runtime_error(ObjectName(*object) + ": target CPU differs from " + ObjectName(*objects.front()) + ".");
+        }
+    }
+
+    if (endian != support::big) {
+        throw std::runtime_error("Only big endian objects can be linked.");
+    }
+
+    auto module_name = options.name.value_or(first_header.Name());
+    auto layout = GetLayout(objects, module_name);
+
+    support::ThreadPool pool(std::min<std::size_t>(worker_count, objects.size()));
+    auto for_each_object = [&objects, &pool](auto task) {
+        std::vector<std::future<decltype(task(std::size_t {}))>> results {};
+        results.reserve(objects.size());
+        for (std::size_t i = 0; i < objects.size(); i++) {
+            results.push_back(pool.Submit([task, i]() { return task(i); }));
+        }
+        return GetAll(results);
+    };
+
+    // Build the global symbol table. Definitions are decoded concurrently, then merged in object order.
+    auto definitions = for_each_object([&objects, &layout](std::size_t i) {
+        std::vector<std::pair<std::string_view, Value>> result {};
+        auto defs = objects[i]->ExternDefinitions();
+        result.reserve(defs.Count());
+        for (auto def : defs) {
+            result.emplace_back(def.name, SymbolValue(def.type, def.symbol_value, layout.objects[i]));
+        }
+        return result;
+    });
+
+    std::unordered_map<std::string_view, Symbol> symbols {};
+    std::vector<std::string> errors {};
+    for (std::size_t i = 0; i < definitions.size(); i++) {
+        for (auto& [name, value] : definitions[i]) {
+            auto [existing, inserted] = symbols.try_emplace(name, Symbol { value, i });
+            if (!inserted) {
+                errors.push_back("Symbol '" + std::string(name) + "' is defined in both "
+                    + ObjectName(*objects[existing->second.object]) + " and " + ObjectName(*objects[i]) + ".");
+            }
+        }
+    }
+
+    // Resolve each object's extern refs against the symbol table.
+    auto resolved = for_each_object([&objects, &symbols](std::size_t i) {
+        std::pair<std::vector<Value>, std::vector<std::string>> result {};
+        auto& [values, undefined] = result;
+
+        for (auto name : objects[i]->ExternRefs()) {
+            auto symbol = symbols.find(name);
+            if (symbol == symbols.end()) {
+                undefined.emplace_back(name);
+                values.push_back(Value { 0, Area::Absolute });
+            } else {
+                values.push_back(symbol->second.value);
+            }
+        }
+
+        return result;
+    });
+
+    std::vector<std::vector<Value>> extern_refs(objects.size());
+    std::set<std::string> undefined {};
+    for (std::size_t i = 0; i < resolved.size(); i++) {
+        auto& result = resolved[i];
+        extern_refs[i] = std::move(result.first);
+        undefined.insert(result.second.begin(), result.second.end());
+    }
+
+    for (auto& name : undefined) {
+        errors.push_back("Undefined symbol '" + name + "'.");
+    }
+
+    if (!errors.empty()) {
+        std::string message = "Link failed:";
+        for (auto& error : errors) {
+            message += "\n  " + error;
+        }
+        throw std::runtime_error(message);
+    }
+
+    // Copy and relocate every object's code and initialized data. Each task writes a disjoint range.
+    std::vector<char> module(layout.initialized_data_refs, 0);
+
+    std::vector<std::future<std::vector<DataPointer>>> relocations {};
+    for (std::size_t i = 0; i < objects.size(); i++) {
+        auto& object_layout = layout.objects[i];
+        auto* code = module.data() + object_layout.code;
+        auto* data = module.data() + layout.initialized_data + object_layout.initialized_data;
+
+        for (bool code_section : { true, false }) {
+            relocations.push_back(pool.Submit([&, i, code_section, code, data]() {
+                return RelocateSection(*objects[i], object_layout, extern_refs[i], code_section,
+                    code_section ? code : data, object_layout.initialized_data);
+            }));
+        }
+    }
+
+    std::vector<DataPointer> pointers {};
+    for (auto& section_pointers : GetAll(relocations)) {
+        pointers.insert(pointers.end(), section_pointers.begin(), section_pointers.end());
+    }
+
+    auto reference_lists = GetDataReferenceLists(std::move(pointers), endian);
+    module.insert(module.end(), reference_lists.begin(), reference_lists.end());
+    module.resize(Align(module.size()) + CrcSize, 0);
+
+    std::memcpy(module.data() + layout.name, module_name.c_str(), module_name.size() + 1);
+
+    support::BinarySectionWriter init_data_header(module.data() + layout.initialized_data_header,
+        sizeof(module::InitDataHeader), endian);
+    init_data_header.Write(static_cast<uint32_t>(0));
+    init_data_header.Write(static_cast<uint32_t>(layout.initialized_data_size));
+
+    module::ModuleHeader header {};
+    header.SyncBytes() = SyncBytesFor(cpu);
+    header.SystemRevision() = 1;
+    header.Size() = CheckedOffset(module.size());
+    header.Owner() = 0;
+    header.OffsetToName() = CheckedOffset(layout.name);
+    header.Access() = options.access;
+    header.TypeLanguage() = first_header.TypeLanguage();
+    header.AttRev() = options.attributes_revision;
+    header.Edition() = options.edition.value_or(first_header.Edition());
+    header.OffsetToExec() = layout.objects.front().code + first_header.OffsetToEntry();
+    header.OffsetToExcept() = first_header.OffsetToUninitializedTrapHandler() == NoTrapHandler
+        ? 0 : layout.objects.front().code + first_header.OffsetToUninitializedTrapHandler();
+    header.SizeOfData() = CheckedOffset(layout.data_size);
+
+    std::size_t stack = options.extra_stack;
+    for (auto& object : objects) {
+        stack += object->Header().RequiredStackSize();
+    }
+    header.MinStackSize() = CheckedOffset(stack);
+
+    header.InitializedDataOffset() = CheckedOffset(layout.initialized_data_header);
+    header.InitDataRefOffset() = CheckedOffset(layout.initialized_data_refs);
+
+    std::ostringstream header_out {};
+    serializer::Serialize(static_cast<module::SerializableModuleHeader>(header), header_out, endian);
+    auto header_bytes = header_out.str();
+    std::memcpy(module.data(), header_bytes.data(), sizeof(module::ModuleHeader));
+
+    support::BinarySectionWriter parity(module.data() + sizeof(module::ModuleHeader) - sizeof(uint16_t),
+        sizeof(uint16_t), endian);
+    parity.Write(module::util::CalculateHeaderParity(module.data()));
+
+    // The first byte of the CRC field is unused, and is covered as a zero by the complement.
+    auto crc = module::util::CalculateCrcComplement(module.data(), module.size() - CrcSize);
+    auto* crc_field = reinterpret_cast<uint8_t*>(module.data() + module.size() - CrcSize);
+    crc_field[0] = 0;
+    crc_field[1] = static_cast<uint8_t>(crc >> 16U);
+    crc_field[2] = static_cast<uint8_t>(crc >> 8U);
+    crc_field[3] = static_cast<uint8_t>(crc);
+
+    return module;
+}
+
+}
\ No newline at end of file
@@ -27,49 +27,203 @@
 
 #include "CrcGenerator.hpp"
 
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <array>
+#include <future>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define MODULE_CRC_CLMUL
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 namespace module {
 
-// TODO: create constexpr table generator
-// TODO: rewrite history for this file
-static long crctable[256] =
-    {
-        0x000000, 0x800063, 0x8000a5, 0x0000c6, 0x800129, 0x00014a, 0x00018c, 0x8001ef,
-        0x800231, 0x000252, 0x000294, 0x8002f7, 0x000318, 0x80037b, 0x8003bd, 0x0003de,
-        0x800401, 0x000462, 0x0004a4, 0x8004c7, 0x000528, 0x80054b, 0x80058d, 0x0005ee,
-        0x000630, 0x800653, 0x800695, 0x0006f6, 0x800719, 0x00077a, 0x0007bc, 0x8007df,
-        0x800861, 0x000802, 0x0008c4, 0x8008a7, 0x000948, 0x80092b, 0x8009ed, 0x00098e,
-        0x000a50, 0x800a33, 0x800af5, 0x000a96, 0x800b79, 0x000b1a, 0x000bdc, 0x800bbf,
-        0x000c60, 0x800c03, 0x800cc5, 0x000ca6, 0x800d49, 0x000d2a, 0x000dec, 0x800d8f,
-        0x800e51, 0x000e32, 0x000ef4, 0x800e97, 0x000f78, 0x800f1b, 0x800fdd, 0x000fbe,
-        0x8010a1, 0x0010c2, 0x001004, 0x801067, 0x001188, 0x8011eb, 0x80112d, 0x00114e,
-        0x001290, 0x8012f3, 0x801235, 0x001256, 0x8013b9, 0x0013da, 0x00131c, 0x80137f,
-        0x0014a0, 0x8014c3, 0x801405, 0x001466, 0x801589, 0x0015ea, 0x00152c, 0x80154f,
-        0x801691, 0x0016f2, 0x001634, 0x801657, 0x0017b8, 0x8017db, 0x80171d, 0x00177e,
-        0x0018c0, 0x8018a3, 0x801865, 0x001806, 0x8019e9, 0x00198a, 0x00194c, 0x80192f,
-        0x801af1, 0x001a92, 0x001a54, 0x801a37, 0x001bd8, 0x801bbb, 0x801b7d, 0x001b1e,
-        0x801cc1, 0x001ca2, 0x001c64, 0x801c07, 0x001de8, 0x801d8b, 0x801d4d, 0x001d2e,
-        0x001ef0, 0x801e93, 0x801e55, 0x001e36, 0x801fd9, 0x001fba, 0x001f7c, 0x801f1f,
-        0x802121, 0x002142, 0x002184, 0x8021e7, 0x002008, 0x80206b, 0x8020ad, 0x0020ce,
-        0x002310, 0x802373, 0x8023b5, 0x0023d6, 0x802239, 0x00225a, 0x00229c, 0x8022ff,
-        0x002520, 0x802543, 0x802585, 0x0025e6, 0x802409, 0x00246a, 0x0024ac, 0x8024cf,
-        0x802711, 0x002772, 0x0027b4, 0x8027d7, 0x002638, 0x80265b, 0x80269d, 0x0026fe,
-        0x002940, 0x802923, 0x8029e5, 0x002986, 0x802869, 0x00280a, 0x0028cc, 0x8028af,
-        0x802b71, 0x002b12, 0x002bd4, 0x802bb7, 0x002a58, 0x802a3b, 0x802afd, 0x002a9e,
-        0x802d41, 0x002d22, 0x002de4, 0x802d87, 0x002c68, 0x802c0b, 0x802ccd, 0x002cae,
-        0x002f70, 0x802f13, 0x802fd5, 0x002fb6, 0x802e59, 0x002e3a, 0x002efc, 0x802e9f,
-        0x003180, 0x8031e3, 0x803125, 0x003146, 0x8030a9, 0x0030ca, 0x00300c, 0x80306f,
-        0x8033b1, 0x0033d2, 0x003314, 0x803377, 0x003298, 0x8032fb, 0x80323d, 0x00325e,
-        0x803581, 0x0035e2, 0x003524, 0x803547, 0x0034a8, 0x8034cb, 0x80340d, 0x00346e,
-        0x0037b0, 0x8037d3, 0x803715, 0x003776, 0x803699, 0x0036fa, 0x00363c, 0x80365f,
-        0x8039e1, 0x003982, 0x003944, 0x803927, 0x0038c8, 0x8038ab, 0x80386d, 0x00380e,
-        0x003bd0, 0x803bb3, 0x803b75, 0x003b16, 0x803af9, 0x003a9a, 0x003a5c, 0x803a3f,
-        0x003de0, 0x803d83, 0x803d45, 0x003d26, 0x803cc9, 0x003caa, 0x003c6c, 0x803c0f,
-        0x803fd1, 0x003fb2, 0x003f74, 0x803f17, 0x003ef8, 0x803e9b, 0x803e5d, 0x003e3e
-    };
+namespace {
+
+using Table = std::array<uint32_t, 256>;
+
+// The OS-9 module CRC is a 24-bit CRC, shifted MSB first.
+constexpr uint32_t Polynomial = 0x800063;
+
+constexpr Table MakeTable() {
+    Table table {};
+    for (uint32_t i = 0; i < table.size(); i++) {
+        uint32_t crc = i << 16U;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x800000U) ? (crc << 1U) ^ Polynomial : crc << 1U;
+        }
+        table[i] = crc & 0xffffffU;
+    }
+    return table;
+}
+
+/**
+ * Tables for slicing by 8. The CRC is kept in the top 24 bits of a 32-bit word, so that whole
+ * words of data can be folded in. Table k advances a byte through k further zero bytes.
+ */
+constexpr std::array<Table, 8> MakeSliceTables(const Table& crctable) {
+    std::array<Table, 8> tables {};
+    for (uint32_t i = 0; i < 256; i++) {
+        tables[0][i] = crctable[i] << 8U;
+    }
+
+    for (std::size_t k = 1; k < tables.size(); k++) {
+        for (uint32_t i = 0; i < 256; i++) {
+            auto previous = tables[k - 1][i];
+            tables[k][i] = (previous << 8U) ^ tables[0][previous >> 24U];
+        }
+    }
+    return tables;
+}
+
+constexpr Table crctable = MakeTable();
+constexpr std::array<Table, 8> slice_tables = MakeSliceTables(crctable);
+
+static_assert(crctable[1] == 0x800063 && crctable[128] == 0x802121 && crctable[255] == 0x003e3e,
+    "Generated CRC table doesn't match the OS-9 table.");
+
+inline uint32_t LoadBigEndian(const uint8_t* bytes) {
+    return uint32_t(bytes[0]) << 24U | uint32_t(bytes[1]) << 16U | uint32_t(bytes[2]) << 8U | bytes[3];
+}
+
+// Fold bytes into register, which holds the CRC in its top 24 bits.
+uint32_t Slice(const uint8_t* bytes, size_t size, uint32_t register_value) {
+    auto acc = register_value;
+
+    // Each 8 bytes are looked up independently, rather than through a chain of 8 dependent steps.
+    while (size >= 8) {
+        auto high = acc ^ LoadBigEndian(bytes);
+        auto low = LoadBigEndian(bytes + 4);
+
+        acc = slice_tables[7][high >> 24U] ^ slice_tables[6][(high >> 16U) & 0xffU]
+            ^ slice_tables[5][(high >> 8U) & 0xffU] ^ slice_tables[4][high & 0xffU]
+            ^ slice_tables[3][low >> 24U] ^ slice_tables[2][(low >> 16U) & 0xffU]
+            ^ slice_tables[1][(low >> 8U) & 0xffU] ^ slice_tables[0][low & 0xffU];
+
+        bytes += 8;
+        size -= 8;
+    }
+
+    while (size--) {
+        acc = (acc << 8U) ^ slice_tables[0][(acc >> 24U) ^ *bytes++];
+    }
+
+    return acc;
+}
+
+// a * b mod the polynomial, for 24-bit CRC values.
+uint32_t MultiplyMod(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+    for (int bit = 23; bit >= 0; bit--) {
+        product = (product & 0x800000U) ? ((product << 1U) ^ Polynomial) & 0xffffffU : product << 1U;
+        if ((b >> static_cast<unsigned int>(bit)) & 1U) product ^= a;
+    }
+    return product;
+}
+
+// Below this, a chunk isn't worth handing to another thread.
+constexpr size_t MinChunkSize = 1024 * 1024;
+
+#ifdef MODULE_CRC_CLMUL
+
+/**
+ * Folding with carry-less multiplication, 64 bytes at a time.
+ *
+ * The 32-bit register form of the CRC is a CRC over Q = x^32 + (Polynomial << 8). A 128-bit
+ * block X = H*x^64 + L followed by n more bits is congruent, mod Q, to
+ * H*(x^(n+64) mod Q) + L*(x^n mod Q), which fits in 96 bits. So blocks can be folded forward
+ * onto later ones without changing the CRC, until a single block is left for the tables.
+ */
+constexpr uint64_t RegisterPolynomial = (uint64_t(1) << 32U) | (uint64_t(Polynomial) << 8U);
+
+constexpr uint64_t XPowModQ(unsigned int n) {
+    uint64_t remainder = 1;
+    for (unsigned int i = 0; i < n; i++) {
+        remainder <<= 1U;
+        if (remainder & (uint64_t(1) << 32U)) remainder ^= RegisterPolynomial;
+    }
+    return remainder;
+}
+
+// Constants for folding a block 512 and 128 bits forward. Declaring them constexpr makes the
+// compiler evaluate them, rather than Fold looping to compute them on every call.
+constexpr uint64_t By512High = XPowModQ(512 + 64);
+constexpr uint64_t By512Low = XPowModQ(512);
+constexpr uint64_t By128High = XPowModQ(128 + 64);
+constexpr uint64_t By128Low = XPowModQ(128);
+
+// Below this, setting up the fold costs more than it saves.
+constexpr size_t FoldThreshold = 256;
+
+bool HasCarrylessMultiply() {
+    static const bool supported = []() {
+        unsigned int eax, ebx, ecx, edx;
+        return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL) && (ecx & bit_SSSE3);
+    }();
+    return supported;
+}
+
+// Reverses the bytes of a block, so that the first is the most significant, as the CRC is shifted MSB first.
+__attribute__((target("ssse3")))
+inline __m128i Reverse(__m128i block) {
+    return _mm_shuffle_epi8(block, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+__attribute__((target("ssse3")))
+inline __m128i Load(const uint8_t* block) {
+    return Reverse(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block)));
+}
+
+// Fold x forward onto next, with constants for the distance between them.
+__attribute__((target("pclmul")))
+inline __m128i FoldOnto(__m128i x, __m128i constants, __m128i next) {
+    auto high = _mm_clmulepi64_si128(x, constants, 0x11);
+    auto low = _mm_clmulepi64_si128(x, constants, 0x00);
+    return _mm_xor_si128(_mm_xor_si128(high, low), next);
+}
+
+__attribute__((target("pclmul,ssse3")))
+uint32_t Fold(const uint8_t*& bytes, size_t& size, uint32_t register_value) {
+    const __m128i by_512 = _mm_set_epi64x(static_cast<long long>(By512High), static_cast<long long>(By512Low));
+    const __m128i by_128 = _mm_set_epi64x(static_cast<long long>(By128High), static_cast<long long>(By128Low));
+
+    // Starting from register_value is the same as starting from zero with it added to the first bytes.
+    __m128i x0 = _mm_xor_si128(Load(bytes), _mm_set_epi32(static_cast<int>(register_value), 0, 0, 0));
+    __m128i x1 = Load(bytes + 16);
+    __m128i x2 = Load(bytes + 32);
+    __m128i x3 = Load(bytes + 48);
+    bytes += 64;
+    size -= 64;
+
+    while (size >= 64) {
+        x0 = FoldOnto(x0, by_512, Load(bytes));
+        x1 = FoldOnto(x1, by_512, Load(bytes + 16));
+        x2 = FoldOnto(x2, by_512, Load(bytes + 32));
+        x3 = FoldOnto(x3, by_512, Load(bytes + 48));
+        bytes += 64;
+        size -= 64;
+    }
+
+    x1 = FoldOnto(x0, by_128, x1);
+    x2 = FoldOnto(x1, by_128, x2);
+    x3 = FoldOnto(x2, by_128, x3);
+
+    alignas(16) uint8_t folded[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(folded), Reverse(x3));
+    return Slice(folded, sizeof(folded), 0);
+}
+
+#endif
+
+}
 
 #define UPDCRC(crc, i) (crctable[((crc) >> 16 ^ (i)) & 0xff] ^ (crc) << 8)
 
-void crc::Generate(const char* data, size_t size, uint32_t* crc) {
+void crc::GenerateBytewise(const char* data, size_t size, uint32_t* crc) {
     long acc = *crc;
 
     if (data)
@@ -80,4 +234,79 @@ void crc::Generate(const char* data, size_t size, uint32_t* crc) {
     *crc = acc | 0xff000000;
 }
 
+void crc::GeneratePortable(const char* data, size_t size, uint32_t* crc) {
+    if (!data) {
+        GenerateBytewise(data, size, crc);
+        return;
+    }
+
+    auto acc = Slice(reinterpret_cast<const uint8_t*>(data), size, (*crc & 0xffffffU) << 8U);
+    *crc = acc >> 8U | 0xff000000U;
+}
+
+void crc::Generate(const char* data, size_t size, uint32_t* crc) {
+#ifdef MODULE_CRC_CLMUL
+    if (data && size >= FoldThreshold && HasCarrylessMultiply()) {
+        auto bytes = reinterpret_cast<const uint8_t*>(data);
+        auto acc = Fold(bytes, size, (*crc & 0xffffffU) << 8U);
+        acc = Slice(bytes, size, acc);
+        *crc = acc >> 8U | 0xff000000U;
+        return;
+    }
+#endif
+
+    GeneratePortable(data, size, crc);
+}
+
+void crc::ShiftZeros(size_t size, uint32_t* crc) {
+    // Folding in a zero byte multiplies the CRC by x^8. So size of them multiply it by x^(8 * size).
+    uint32_t shift = 1;
+    uint32_t power = 0x100;
+    for (; size; size >>= 1U) {
+        if (size & 1U) shift = MultiplyMod(shift, power);
+        power = MultiplyMod(power, power);
+    }
+
+    *crc = MultiplyMod(*crc & 0xffffffU, shift) | 0xff000000U;
+}
+
+uint32_t crc::Combine(uint32_t crc_a, uint32_t crc_b, size_t size_b) {
+    // The CRC is linear: b's CRC from crc_a is b's CRC from zero, plus crc_a shifted past b.
+    ShiftZeros(size_b, &crc_a);
+    return (crc_a ^ crc_b) | 0xff000000U;
+}
+
+void crc::GenerateParallel(const char* data, size_t size, uint32_t* crc, unsigned int worker_count) {
+    auto chunk_count = std::min<size_t>(worker_count, size / MinChunkSize);
+    if (!data || size < ParallelThreshold || chunk_count <= 1) {
+        Generate(data, size, crc);
+        return;
+    }
+
+    auto chunk_size = (size + chunk_count - 1) / chunk_count;
+
+    // Every chunk but the first starts from zero, and is combined onto the CRC of those before it.
+    std::vector<std::future<uint32_t>> chunks {};
+    {
+        support::ThreadPool pool(chunk_count);
+        for (size_t begin = 0; begin < size; begin += chunk_size) {
+            auto length = std::min(chunk_size, size - begin);
+            uint32_t start = begin == 0 ? *crc : 0;
+            chunks.emplace_back(pool.Submit([data, begin, length, start]() {
+                auto chunk_crc = start;
+                Generate(data + begin, length, &chunk_crc);
+                return chunk_crc;
+            }));
+        }
+    }
+
+    auto combined = chunks.front().get();
+    for (size_t i = 1; i < chunks.size(); i++) {
+        auto length = std::min(chunk_size, size - i * chunk_size);
+        combined = Combine(combined, chunks[i].get(), length);
+    }
+
+    *crc = combined;
+}
+
 }
\ No newline at end of file
@@ -26,45 +26,106 @@
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cstdint>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <streambuf>
 
 #include "Module.hpp"
 #include "CrcGenerator.hpp"
 #include "ModuleUtils.hpp"
 #include "BinarySectionReader.hpp"
+#include "Serialization.h"
 
 namespace module {
 
 using BinarySectionReader = support::BinarySectionReader;
 
+namespace {
+
+// Reads straight out of a buffer, so the header can be deserialized without copying the module.
+class MemoryBuffer : public std::streambuf {
+public:
+    MemoryBuffer(const char* data, std::size_t size) {
+        auto* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+};
+
+ModuleHeaderView CheckedView(const char* data, std::size_t size) {
+    ModuleHeaderView view(data, size);
+    if (view.Size() < ModuleHeaderView::HeaderSize || view.Size() > size) {
+        throw std::runtime_error("Module header claims " + std::to_string(view.Size()) + " bytes, but "
+            + std::to_string(size) + " are available.");
+    }
+
+    return view;
+}
+
+}
+
+Module::Module(std::shared_ptr<ModuleHeader> header, std::unique_ptr<char[]> raw_module)
+    : header(std::move(header)), raw_module(std::move(raw_module)), data(this->raw_module.get()),
+      view(data, this->header->Size()) {}
+
+Module::Module(const char* data, std::size_t size) : data(data), view(CheckedView(data, size)) {}
+
+Module::Module(support::MappedFile file)
+    : mapping(std::move(file)), data(mapping->Data()), view(CheckedView(data, mapping->Size())) {}
+
+std::shared_ptr<ModuleHeader> Module::GetHeader() {
+    if (!header) {
+        MemoryBuffer buffer(data, ModuleHeaderView::HeaderSize);
+        std::istream stream(&buffer);
+
+        header = std::make_shared<ModuleHeader>();
+        serializer::Deserialize(*static_cast<SerializableModuleHeader*>(header.get()), stream, view.GetEndian());
+    }
+
+    return header;
+}
+
 std::string Module::GetName() {
-    return std::string(&raw_module.get()[header->OffsetToName()]);
+    auto offset = view.OffsetToName();
+    if (offset >= view.Size()) return {};
+
+    // The name may run up to the end of the module, but no further.
+    return std::string(data + offset, strnlen(data + offset, view.Size() - offset));
 }
 
 bool Module::IsBigEndian() {
-    return util::IsBigEndian(raw_module.get());
+    return view.GetEndian() == support::Endian::big;
 }
 
 bool Module::IsHeaderValid() {
-    return header->Parity() == util::CalculateHeaderParity(raw_module.get());
+    return view.Parity() == util::CalculateHeaderParity(data);
 }
 
-bool Module::IsCrcValid() {
+bool Module::IsCrcValid(unsigned int worker_count) {
     const uint32_t crc_constant = 0x800fe3;
 
     uint32_t crc = -1;
-    crc::Generate(raw_module.get(), header->Size(), &crc);
+    crc::GenerateParallel(data, view.Size(), &crc, worker_count);
 
     return (crc & 0xFFFFFF) == crc_constant;
 }
 
-// TODO: deduplicate
-support::Endian EndianOf(const char* header_data) {
-    return util::IsBigEndian(header_data) ? support::Endian::big : support::Endian::little;
+ModuleCheck CheckModuleFile(support::MappedFile file) {
+    Module module(std::move(file));
+
+    ModuleCheck check {};
+    check.name = module.GetName();
+    check.size = module.GetHeaderView().Size();
+    check.edition = module.GetHeaderView().Edition();
+    check.header_valid = module.IsHeaderValid();
+    check.crc_valid = module.IsCrcValid(1);
+
+    return check;
 }
 
 InitDataHeader Module::GetInitializationDataHeader() {
-    BinarySectionReader section(raw_module.get() + header->InitializedDataOffset(), sizeof(InitDataHeader),
-        EndianOf(raw_module.get()));
+    BinarySectionReader section(data + view.InitializedDataOffset(), sizeof(InitDataHeader),
+        view.GetEndian());
 
     InitDataHeader initDataHeader;
     section.ReadNext(&initDataHeader);
@@ -73,7 +134,7 @@ InitDataHeader Module::GetInitializationDataHeader() {
 }
 
 void Module::GetDataReferenceList(uint32_t* unadjusted_pointers) {
-    BinarySectionReader section(raw_module.get() + header->InitDataRefOffset(), EndianOf(raw_module.get()));
+    BinarySectionReader section(data + view.InitDataRefOffset(), view.GetEndian());
 }
 
 }
\ No newline at end of file
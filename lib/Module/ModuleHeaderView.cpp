@@ -0,0 +1,25 @@
+#include "ModuleHeaderView.hpp"
+
+#include "ModuleHeader.hpp"
+#include "ModuleUtils.hpp"
+
+#include <stdexcept>
+#include <string>
+
+namespace module {
+
+static_assert(sizeof(ModuleHeader) == ModuleHeaderView::HeaderSize, "The view's field offsets assume the 88-byte module header.");
+
+ModuleHeaderView::ModuleHeaderView(const char* data, std::size_t size) : data(data) {
+    if (size < HeaderSize) {
+        throw std::runtime_error("Too small to be an OS-9 module: " + std::to_string(size) + " bytes.");
+    }
+
+    if (!util::HasKnownSyncBytes(data)) {
+        throw std::runtime_error("Not an OS-9 module: unknown sync bytes.");
+    }
+
+    endian = util::IsBigEndian(data) ? support::Endian::big : support::Endian::little;
+}
+
+}
\ No newline at end of file
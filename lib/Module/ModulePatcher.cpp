@@ -0,0 +1,126 @@
+#include "ModulePatcher.hpp"
+
+#include "BinarySectionWriter.h"
+#include "CrcGenerator.hpp"
+#include "ModuleHeaderView.hpp"
+#include "ModuleUtils.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace module {
+
+namespace {
+
+constexpr std::size_t CrcSize = 4;
+
+using Header = ModuleHeaderView;
+
+}
+
+ModulePatcher::ModulePatcher(char* data, std::size_t size) : data(data) {
+    Header header(data, size);
+    if (size < Header::HeaderSize + CrcSize) {
+        throw std::runtime_error("Too small to be an OS-9 module.");
+    }
+
+    endian = header.GetEndian();
+    if (header.Size() < Header::HeaderSize + CrcSize || header.Size() > size) {
+        throw std::runtime_error("Module header claims " + std::to_string(header.Size()) + " bytes, but "
+            + std::to_string(size) + " are available.");
+    }
+
+    module_size = header.Size();
+}
+
+void ModulePatcher::CheckWritable(std::size_t offset, std::size_t count) const {
+    auto crc_offset = module_size - CrcSize;
+    if (offset > crc_offset || count > crc_offset - offset) {
+        throw std::out_of_range("Patch of " + std::to_string(count) + " bytes at " + std::to_string(offset)
+            + " overlaps the CRC or the end of the module.");
+    }
+
+    if (offset < Header::SizeOffset + sizeof(uint32_t) && offset + count > Header::SizeOffset) {
+        throw std::out_of_range("The module size can't be patched.");
+    }
+}
+
+void ModulePatcher::Write(std::size_t offset, const char* bytes, std::size_t count) {
+    CheckWritable(offset, count);
+    auto crc_offset = module_size - CrcSize;
+
+    std::vector<char> delta(count);
+    for (std::size_t i = 0; i < count; i++) {
+        delta[i] = static_cast<char>(data[offset + i] ^ bytes[i]);
+    }
+
+    // The CRC covers the rest of the module, then a zero in place of the CRC field's first byte.
+    uint32_t crc = 0;
+    crc::Generate(delta.data(), count, &crc);
+    crc::ShiftZeros(crc_offset + 1 - (offset + count), &crc);
+    crc_delta ^= crc & 0xffffffU;
+
+    std::memcpy(data + offset, bytes, count);
+}
+
+template<typename T>
+void ModulePatcher::WriteField(std::size_t offset, T value) {
+    char bytes[sizeof(T)];
+    support::BinarySectionWriter(bytes, sizeof(bytes), endian).Write(value);
+    Write(offset, bytes, sizeof(bytes));
+}
+
+void ModulePatcher::SetAccess(uint16_t access) {
+    WriteField(Header::AccessOffset, access);
+}
+
+void ModulePatcher::SetTypeLanguage(uint16_t type_language) {
+    WriteField(Header::TypeLanguageOffset, type_language);
+}
+
+void ModulePatcher::SetAttributesRevision(uint16_t attributes_revision) {
+    WriteField(Header::AttRevOffset, attributes_revision);
+}
+
+void ModulePatcher::SetEdition(uint16_t edition) {
+    WriteField(Header::EditionOffset, edition);
+}
+
+void ModulePatcher::SetMinStackSize(uint32_t stack_size) {
+    WriteField(Header::MinStackSizeOffset, stack_size);
+}
+
+uint32_t ModulePatcher::Commit() {
+    WriteField(Header::ParityOffset, util::CalculateHeaderParity(data));
+
+    // The field holds the complement of the CRC, which changes by the same delta.
+    auto* field = reinterpret_cast<uint8_t*>(data + module_size - CrcSize);
+    uint32_t complement = uint32_t(field[1]) << 16U | uint32_t(field[2]) << 8U | field[3];
+    complement ^= crc_delta;
+    crc_delta = 0;
+
+    field[1] = static_cast<uint8_t>(complement >> 16U);
+    field[2] = static_cast<uint8_t>(complement >> 8U);
+    field[3] = static_cast<uint8_t>(complement);
+    return complement;
+}
+
+uint32_t ModulePatcher::Rebuild() {
+    char parity[sizeof(uint16_t)];
+    support::BinarySectionWriter(parity, sizeof(parity), endian).Write(util::CalculateHeaderParity(data));
+    std::memcpy(data + Header::ParityOffset, parity, sizeof(parity));
+
+    auto complement = util::CalculateCrcComplement(data, module_size - CrcSize) & 0xffffffU;
+    crc_delta = 0;
+
+    auto* field = reinterpret_cast<uint8_t*>(data + module_size - CrcSize);
+    field[0] = 0;
+    field[1] = static_cast<uint8_t>(complement >> 16U);
+    field[2] = static_cast<uint8_t>(complement >> 8U);
+    field[3] = static_cast<uint8_t>(complement);
+    return complement;
+}
+
+}
\ No newline at end of file
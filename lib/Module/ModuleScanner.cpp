@@ -0,0 +1,127 @@
+#include "ModuleScanner.hpp"
+
+#include "Module.hpp"
+#include "ModuleHeaderView.hpp"
+#include "ModuleUtils.hpp"
+
+#include <ThreadPool.h>
+
+#include <algorithm>
+#include <future>
+
+#if defined(__SSE2__)
+#define MODULE_SCAN_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace module {
+
+namespace {
+
+// The CRC field follows the module's contents.
+constexpr std::size_t MinModuleSize = ModuleHeaderView::HeaderSize + 4;
+
+// The sync bytes recognized by util::HasKnownSyncBytes, as a first and second byte.
+constexpr uint8_t SyncBytes[][2] = {
+    { 0x4D, 0xAD },
+    { 0x4A, 0xFC },
+    { 0xFC, 0x4A }
+};
+
+bool IsSyncBytes(uint8_t first, uint8_t second) {
+    for (auto& sync : SyncBytes) {
+        if (first == sync[0] && second == sync[1]) return true;
+    }
+    return false;
+}
+
+// Size of the module at data if its header is intact and it fits in size bytes, or zero.
+std::size_t ConfirmModule(const char* data, std::size_t size) {
+    if (size < MinModuleSize) return 0;
+
+    ModuleHeaderView view(data, size);
+    if (view.Parity() != util::CalculateHeaderParity(data)) return 0;
+    if (view.Size() < MinModuleSize || view.Size() > size) return 0;
+
+    return view.Size();
+}
+
+}
+
+std::size_t FindSyncBytesPortable(const char* data, std::size_t size, std::size_t from) {
+    auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    for (auto i = from; i + 1 < size; i++) {
+        if (IsSyncBytes(bytes[i], bytes[i + 1])) return i;
+    }
+    return size;
+}
+
+std::size_t FindSyncBytes(const char* data, std::size_t size, std::size_t from) {
+#ifdef MODULE_SCAN_SSE2
+    __m128i first[3];
+    __m128i second[3];
+    for (std::size_t i = 0; i < 3; i++) {
+        first[i] = _mm_set1_epi8(static_cast<char>(SyncBytes[i][0]));
+        second[i] = _mm_set1_epi8(static_cast<char>(SyncBytes[i][1]));
+    }
+
+    // Each block tests 16 offsets, pairing each byte with the one after it, so it reads 17 bytes.
+    auto i = from;
+    for (; i + 17 <= size; i += 16) {
+        auto at = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        auto next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+
+        auto matches = _mm_setzero_si128();
+        for (std::size_t j = 0; j < 3; j++) {
+            matches = _mm_or_si128(matches,
+                _mm_and_si128(_mm_cmpeq_epi8(at, first[j]), _mm_cmpeq_epi8(next, second[j])));
+        }
+
+        auto mask = static_cast<unsigned int>(_mm_movemask_epi8(matches));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+
+    return FindSyncBytesPortable(data, size, i);
+#else
+    return FindSyncBytesPortable(data, size, from);
+#endif
+}
+
+std::vector<ScannedModule> ScanImage(const char* data, std::size_t size, unsigned int worker_count) {
+    std::vector<ScannedModule> modules {};
+
+    auto offset = FindSyncBytes(data, size, 0);
+    while (offset < size) {
+        auto module_size = ConfirmModule(data + offset, size - offset);
+        if (module_size != 0) {
+            modules.push_back(ScannedModule { offset, module_size, {}, false });
+        }
+
+        offset = FindSyncBytes(data, size, offset + std::max<std::size_t>(module_size, 1));
+    }
+
+    if (modules.empty()) return modules;
+
+    // A lone module gets every thread for its CRC. Otherwise, each CRC is generated on one.
+    auto crc_workers = modules.size() == 1 ? worker_count : 1;
+
+    std::vector<std::future<void>> checks {};
+    {
+        support::ThreadPool pool(std::min<std::size_t>(worker_count, modules.size()));
+        for (auto& scanned : modules) {
+            checks.push_back(pool.Submit([data, &scanned, crc_workers]() {
+                Module module(data + scanned.offset, scanned.size);
+                scanned.name = module.GetName();
+                scanned.crc_valid = module.IsCrcValid(crc_workers);
+            }));
+        }
+    }
+
+    for (auto& check : checks) {
+        check.get();
+    }
+
+    return modules;
+}
+
+}
\ No newline at end of file
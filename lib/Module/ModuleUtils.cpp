@@ -36,11 +36,17 @@ namespace module::util {
 
 using BinarySectionReader = support::BinarySectionReader;
 
-bool IsBigEndian(const char* header_data) {
-    uint8_t mips[2] = { 0x4D, 0xAD };
-    uint8_t _68k[2] = { 0x4A, 0xFC };
-    uint8_t i386[2] = { 0xFC, 0x4A };
+namespace {
+const uint8_t mips[2] = { 0x4D, 0xAD };
+const uint8_t _68k[2] = { 0x4A, 0xFC };
+const uint8_t i386[2] = { 0xFC, 0x4A };
+}
 
+bool HasKnownSyncBytes(const char* header_data) {
+    return memcmp(header_data, mips, 2) == 0 || memcmp(header_data, _68k, 2) == 0 || memcmp(header_data, i386, 2) == 0;
+}
+
+bool IsBigEndian(const char* header_data) {
     if (memcmp(header_data, mips, 2) == 0 ||
         memcmp(header_data, _68k, 2) == 0)
         return true;
@@ -89,7 +95,7 @@ uint16_t CalculateHeaderParity(const char* header_data) {
 
 uint32_t CalculateCrcComplement(const char* module_data, size_t size) {
     uint32_t crc = -1;
-    module::crc::Generate(module_data, size, &crc);
+    module::crc::GenerateParallel(module_data, size, &crc);
 
     // Add one zero byte to CRC to account for first unused byte of CRC 32-bit field
     const char zero[] = { 0 };
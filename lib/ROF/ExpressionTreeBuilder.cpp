@@ -4,6 +4,19 @@
 namespace rof {
     using namespace expression;
 
+    uint32_t ExternRefTable::IndexOf(const std::string& name) {
+        auto existing = index.find(name);
+        if (existing != index.end()) {
+            return existing->second;
+        }
+
+        auto new_index = static_cast<uint32_t>(names.size());
+        auto& interned = names.emplace_back(name);
+        index.emplace(interned, new_index);
+
+        return new_index;
+    }
+
     void ExpressionTreeBuilder::Visit(const NumericConstantExpression& expr) {
         result = std::make_unique<ExpressionTree>(ExpressionOperator::NumericConstant);
         result->operand1 = expr.value;
@@ -22,23 +35,15 @@ namespace rof {
             // local reference
             auto& symbol = sym_itr->second;
             reference.Flags() = static_cast<uint16_t>(GetDefinitionType(symbol.type));
-            reference.Flags() |= 0b1000000000000U; // local
+            reference.Flags() |= LocalReferenceFlag;
 
             // TODO: handle "common blocks" (from com directive) here (bit 8)
 
             // TODO: handle nullopt, or make sym val non-optional if NA
             reference.Value() = symbol.value.value();
         } else {
-            // external reference
-            auto extern_ref = std::find(extern_refs.begin(), extern_refs.end(), expr.Value());
-            if (extern_ref != extern_refs.end()) {
-                // reuse existing extern reference
-                reference.Value() = std::distance(extern_refs.begin(), extern_ref);
-            } else {
-                // new extern ref
-                reference.Value() = extern_refs.size();
-                extern_refs.emplace_back(expr.Value());
-            }
+            // external reference (reuses the existing index if the name was seen before)
+            reference.Value() = extern_refs.IndexOf(expr.Value());
             // TODO: implement alignment requirement support (bits 3-4) and relative ref (bit 7).
         }
 
@@ -134,7 +139,7 @@ namespace rof {
         return builder.Build(expr);
     }
 
-    ExpressionTreeBuilder::ExpressionTreeBuilder(const object::ObjectFile& object_file, std::vector<std::string>& extern_refs) :
+    ExpressionTreeBuilder::ExpressionTreeBuilder(const object::ObjectFile& object_file, ExternRefTable& extern_refs) :
         object_file(object_file), extern_refs(extern_refs) {}
 
     std::unique_ptr<ExpressionTree> ExpressionTreeBuilder::Build(const Expression& expression) {
@@ -0,0 +1,428 @@
+#include <Rof15ObjectReader.h>
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace rof {
+
+namespace {
+
+// Offset of the module name within an encoded header, which is otherwise fixed size.
+constexpr std::size_t HeaderNameOffset = 70;
+constexpr uint16_t MaxExpressionOperator = static_cast<uint16_t>(ExpressionOperator::High);
+
+// Guards decoding against stack exhaustion from (malicious) deeply nested trees.
+constexpr unsigned int MaxExpressionTreeDepth = 1024;
+
+[[noreturn]] void Malformed(const std::string& what) {
+    throw std::runtime_error("Malformed ROF: " + what);
+}
+
+void CheckRange(const RofBytes& rof, std::size_t offset, std::size_t length) {
+    if (offset > rof.size || length > rof.size - offset) {
+        Malformed("unexpected end of file.");
+    }
+}
+
+template<typename T>
+T ReadAt(const RofBytes& rof, std::size_t offset) {
+    CheckRange(rof, offset, sizeof(T));
+
+    T value;
+    std::memcpy(&value, rof.data + offset, sizeof(T));
+    if (rof.endian != support::ignore && rof.endian != support::HostEndian) {
+        support::EndianSwap(&value);
+    }
+
+    return value;
+}
+
+std::string_view ReadStringAt(const RofBytes& rof, std::size_t offset) {
+    CheckRange(rof, offset, 0);
+
+    auto* start = rof.data + offset;
+    auto* terminator = static_cast<const char*>(std::memchr(start, '\0', rof.size - offset));
+    if (!terminator) {
+        Malformed("unterminated string.");
+    }
+
+    return std::string_view(start, terminator - start);
+}
+
+ExpressionOperator ReadOperatorAt(const RofBytes& rof, std::size_t offset) {
+    auto op = ReadAt<uint16_t>(rof, offset);
+    if (op > MaxExpressionOperator) {
+        Malformed("unknown expression operator " + std::to_string(op) + ".");
+    }
+    return static_cast<ExpressionOperator>(op);
+}
+
+unsigned int SubtreeCountOf(ExpressionOperator op) {
+    switch (op) {
+        case ExpressionOperator::NumericConstant:
+        case ExpressionOperator::Reference:
+            return 0;
+        case ExpressionOperator::Hi:
+        case ExpressionOperator::Lo:
+        case ExpressionOperator::High:
+        case ExpressionOperator::ArithmeticNegation:
+        case ExpressionOperator::BitwiseNegation:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+std::size_t ExpressionTreeEnd(const RofBytes& rof, std::size_t offset, unsigned int depth = 0) {
+    if (depth > MaxExpressionTreeDepth) {
+        Malformed("expression tree is too deep.");
+    }
+
+    auto op = ReadOperatorAt(rof, offset);
+    offset += sizeof(uint16_t);
+
+    switch (op) {
+        case ExpressionOperator::NumericConstant:
+            CheckRange(rof, offset, sizeof(ExpressionVal));
+            return offset + sizeof(ExpressionVal);
+        case ExpressionOperator::Reference:
+            CheckRange(rof, offset, sizeof(uint16_t) + sizeof(uint32_t));
+            return offset + sizeof(uint16_t) + sizeof(uint32_t);
+        default:
+            for (auto i = SubtreeCountOf(op); i > 0; i--) {
+                offset = ExpressionTreeEnd(rof, offset, depth + 1);
+            }
+            return offset;
+    }
+}
+
+std::unique_ptr<ExpressionTree> DecodeExpressionTree(const ExpressionTreeView& view, unsigned int depth = 0) {
+    if (depth > MaxExpressionTreeDepth) {
+        Malformed("expression tree is too deep.");
+    }
+
+    auto tree = std::make_unique<ExpressionTree>(view.Op());
+    switch (tree->op) {
+        case ExpressionOperator::NumericConstant:
+            tree->operand1 = view.Value();
+            break;
+        case ExpressionOperator::Reference:
+            tree->operand1 = view.Ref();
+            break;
+        default:
+            tree->operand1 = DecodeExpressionTree(view.Operand1(), depth + 1);
+            if (view.SubtreeCount() == 2) {
+                tree->operand2 = DecodeExpressionTree(view.Operand2(), depth + 1);
+            }
+    }
+
+    return tree;
+}
+
+std::optional<support::Endian> EndianOfCPU(uint16_t cpu) {
+    switch (cpu) {
+        case 0x100: // 68k
+        case 0x300: // PowerPC
+        case 0x800: // MIPS
+        case 0xA00: // SPARC
+        case 0xB00: // ARM (big endian)
+            return support::big;
+        case 0x200: // x86
+        case 0x500: // ARM
+        case 0xB01: // ARMv5
+        case 0x400: // SH-5
+        case 0x900: // SH
+        case 0x901: // SH-4
+        case 0x902: // SH-4A
+        case 0x700: // RCE
+            return support::little;
+        default:
+            return std::nullopt;
+    }
+}
+
+template<typename T>
+void ReadHeaderField(const RofBytes& rof, std::size_t& offset, T& field) {
+    field = ReadAt<T>(rof, offset);
+    offset += sizeof(T);
+}
+
+template<typename T, std::size_t N>
+void ReadHeaderField(const RofBytes& rof, std::size_t& offset, std::array<T, N>& field) {
+    for (auto& element : field) {
+        ReadHeaderField(rof, offset, element);
+    }
+}
+
+// Reads the fixed size header fields between the sync bytes and the name.
+template<std::size_t ... I>
+void ReadHeaderFields(const RofBytes& rof, std::size_t& offset, Rof15Header& header, std::index_sequence<I...>) {
+    (ReadHeaderField(rof, offset, std::get<I + 1>(header)), ...);
+}
+
+template<typename F>
+std::size_t Resolve(std::once_flag& once, std::size_t& value, F compute) {
+    std::call_once(once, [&]() { value = compute(); });
+    return value;
+}
+
+}
+
+ExpressionTreeView::ExpressionTreeView(RofBytes rof, std::size_t offset) : rof(rof), offset(offset) {}
+
+ExpressionOperator ExpressionTreeView::Op() const {
+    return ReadOperatorAt(rof, offset);
+}
+
+unsigned int ExpressionTreeView::SubtreeCount() const {
+    return SubtreeCountOf(Op());
+}
+
+ExpressionVal ExpressionTreeView::Value() const {
+    if (Op() != ExpressionOperator::NumericConstant) {
+        throw std::logic_error("Expression tree is not a numeric constant.");
+    }
+    return ReadAt<ExpressionVal>(rof, offset + sizeof(uint16_t));
+}
+
+ExpressionRef ExpressionTreeView::Ref() const {
+    if (Op() != ExpressionOperator::Reference) {
+        throw std::logic_error("Expression tree is not a reference.");
+    }
+
+    ExpressionRef ref {};
+    ref.Flags() = ReadAt<uint16_t>(rof, offset + sizeof(uint16_t));
+    ref.Value() = ReadAt<uint32_t>(rof, offset + 2 * sizeof(uint16_t));
+    return ref;
+}
+
+ExpressionTreeView ExpressionTreeView::Operand1() const {
+    if (SubtreeCount() < 1) {
+        throw std::logic_error("Expression tree has no subtree operands.");
+    }
+    return ExpressionTreeView(rof, offset + sizeof(uint16_t));
+}
+
+ExpressionTreeView ExpressionTreeView::Operand2() const {
+    if (SubtreeCount() < 2) {
+        throw std::logic_error("Expression tree has no second subtree operand.");
+    }
+    return ExpressionTreeView(rof, ExpressionTreeEnd(rof, offset + sizeof(uint16_t)));
+}
+
+std::size_t ExpressionTreeView::EncodedSize() const {
+    return ExpressionTreeEnd(rof, offset) - offset;
+}
+
+std::unique_ptr<ExpressionTree> ExpressionTreeView::Decode() const {
+    return DecodeExpressionTree(*this);
+}
+
+ExternDefinitionView ExternDefinitionCodec::Decode(const RofBytes& rof, std::size_t offset) {
+    auto name = ReadStringAt(rof, offset);
+    offset += name.size() + 1;
+
+    ExternDefinitionView def {};
+    def.name = name;
+    def.type = ReadAt<uint16_t>(rof, offset);
+    def.symbol_value = ReadAt<uint32_t>(rof, offset + sizeof(uint16_t));
+    return def;
+}
+
+std::size_t ExternDefinitionCodec::Next(const RofBytes& rof, std::size_t offset) {
+    offset += ReadStringAt(rof, offset).size() + 1;
+    CheckRange(rof, offset, sizeof(uint16_t) + sizeof(uint32_t));
+    return offset + sizeof(uint16_t) + sizeof(uint32_t);
+}
+
+std::string_view ExternRefCodec::Decode(const RofBytes& rof, std::size_t offset) {
+    return ReadStringAt(rof, offset);
+}
+
+std::size_t ExternRefCodec::Next(const RofBytes& rof, std::size_t offset) {
+    return offset + ReadStringAt(rof, offset).size() + 1;
+}
+
+ExpressionTreeView ExpressionTreeCodec::Decode(const RofBytes& rof, std::size_t offset) {
+    return ExpressionTreeView(rof, offset);
+}
+
+std::size_t ExpressionTreeCodec::Next(const RofBytes& rof, std::size_t offset) {
+    return ExpressionTreeEnd(rof, offset);
+}
+
+Reference ReferenceCodec::Decode(const RofBytes& rof, std::size_t offset) {
+    CheckRange(rof, offset, EntrySize);
+
+    Reference ref {};
+    ref.BitNumber() = ReadAt<uint8_t>(rof, offset);
+    ref.FieldLength() = ReadAt<uint8_t>(rof, offset + 1);
+    ref.LocationFlag() = ReadAt<uint16_t>(rof, offset + 2);
+    ref.LocalOffset() = ReadAt<uint32_t>(rof, offset + 4);
+    ref.ExprTreeIndex() = ReadAt<uint32_t>(rof, offset + 8);
+    return ref;
+}
+
+std::size_t ReferenceCodec::Next(const RofBytes&, std::size_t offset) {
+    return offset + EntrySize;
+}
+
+Rof15ObjectReader::Rof15ObjectReader(const std::string& path, std::optional<support::Endian> endian)
+    : mapping(std::in_place, path) {
+    rof.data = mapping->Data();
+    rof.size = mapping->Size();
+    ReadHeader(endian);
+}
+
+Rof15ObjectReader::Rof15ObjectReader(const char* data, std::size_t size, std::optional<support::Endian> endian) {
+    rof.data = data;
+    rof.size = size;
+    ReadHeader(endian);
+}
+
+void Rof15ObjectReader::ReadHeader(std::optional<support::Endian> endian) {
+    CheckRange(rof, 0, HeaderNameOffset);
+
+    if (std::memcmp(rof.data, Rof15SyncBytes.data(), Rof15SyncBytes.size()) != 0) {
+        throw std::runtime_error("Not a ROF: bad sync bytes.");
+    }
+
+    if (endian) {
+        rof.endian = *endian;
+    } else {
+        // The CPU identifier is only recognizable in the endian the ROF was written in.
+        constexpr std::size_t CpuOffset = 64;
+        rof.endian = support::big;
+        auto detected = EndianOfCPU(ReadAt<uint16_t>(rof, CpuOffset));
+        if (!detected) {
+            rof.endian = support::little;
+            detected = EndianOfCPU(ReadAt<uint16_t>(rof, CpuOffset));
+        }
+        rof.endian = detected.value_or(support::big);
+    }
+
+    std::size_t offset = Rof15SyncBytes.size();
+    ReadHeaderFields(rof, offset, header, std::make_index_sequence<std::tuple_size_v<SerializableRof15Header> - 2>());
+
+    auto name = ReadStringAt(rof, offset);
+    header.Name() = std::string(name);
+    extern_defs_offset = offset + name.size() + 1;
+
+    section_sizes.code = header.CodeSize();
+    section_sizes.initialized_data = header.InitializedDataSize();
+    section_sizes.remote_initialized_data = header.RemoteInitializedDataSizeRequired();
+    section_sizes.debug_info = header.DebugInfoSize();
+}
+
+ExternDefinitionsView Rof15ObjectReader::ExternDefinitions() const {
+    return ExternDefinitionsView(rof, extern_defs_offset + sizeof(uint32_t), ReadAt<uint32_t>(rof, extern_defs_offset));
+}
+
+std::size_t Rof15ObjectReader::SectionsOffset() const {
+    return Resolve(sections_offset.once, sections_offset.value, [this]() {
+        auto defs = ExternDefinitions();
+        auto itr = defs.begin();
+        for (; itr != defs.end(); ++itr);
+        return itr.Offset();
+    });
+}
+
+std::string_view Rof15ObjectReader::Code() const {
+    auto offset = SectionsOffset();
+    auto size = section_sizes.code;
+    CheckRange(rof, offset, size);
+    return std::string_view(rof.data + offset, size);
+}
+
+std::string_view Rof15ObjectReader::InitializedData() const {
+    auto offset = SectionsOffset() + section_sizes.code;
+    auto size = section_sizes.initialized_data;
+    CheckRange(rof, offset, size);
+    return std::string_view(rof.data + offset, size);
+}
+
+std::string_view Rof15ObjectReader::RemoteInitializedData() const {
+    auto offset = SectionsOffset() + section_sizes.code + section_sizes.initialized_data;
+    auto size = section_sizes.remote_initialized_data;
+    CheckRange(rof, offset, size);
+    return std::string_view(rof.data + offset, size);
+}
+
+std::string_view Rof15ObjectReader::DebugInfo() const {
+    auto offset = SectionsOffset() + section_sizes.code + section_sizes.initialized_data
+        + section_sizes.remote_initialized_data;
+    auto size = section_sizes.debug_info;
+    CheckRange(rof, offset, size);
+    return std::string_view(rof.data + offset, size);
+}
+
+std::size_t Rof15ObjectReader::ExternRefsOffset() const {
+    auto debug_info = DebugInfo();
+    return debug_info.data() - rof.data + debug_info.size();
+}
+
+ExternRefsView Rof15ObjectReader::ExternRefs() const {
+    auto offset = ExternRefsOffset();
+    return ExternRefsView(rof, offset + sizeof(uint32_t), ReadAt<uint32_t>(rof, offset));
+}
+
+std::size_t Rof15ObjectReader::ExpressionTreesOffset() const {
+    return Resolve(expression_trees_offset.once, expression_trees_offset.value, [this]() {
+        auto refs = ExternRefs();
+        auto itr = refs.begin();
+        for (; itr != refs.end(); ++itr);
+        return itr.Offset();
+    });
+}
+
+ExpressionTreesView Rof15ObjectReader::ExpressionTrees() const {
+    auto offset = ExpressionTreesOffset();
+    return ExpressionTreesView(rof, offset + sizeof(uint32_t), ReadAt<uint32_t>(rof, offset));
+}
+
+std::size_t Rof15ObjectReader::ReferencesOffset() const {
+    return Resolve(references_offset.once, references_offset.value, [this]() {
+        auto trees = ExpressionTrees();
+        auto itr = trees.begin();
+        for (; itr != trees.end(); ++itr);
+        return itr.Offset();
+    });
+}
+
+ReferencesView Rof15ObjectReader::References() const {
+    auto offset = ReferencesOffset();
+    auto count = ReadAt<uint32_t>(rof, offset);
+    CheckRange(rof, offset + sizeof(uint32_t), static_cast<std::size_t>(count) * ReferenceCodec::EntrySize);
+    return ReferencesView(rof, offset + sizeof(uint32_t), count);
+}
+
+std::size_t Rof15ObjectReader::Size() const {
+    auto offset = ReferencesOffset();
+    auto count = ReadAt<uint32_t>(rof, offset);
+    auto size = offset + sizeof(uint32_t) + static_cast<std::size_t>(count) * ReferenceCodec::EntrySize;
+    CheckRange(rof, 0, size);
+    return size;
+}
+
+ExpressionTreeView Rof15ObjectReader::ExpressionTreeAt(uint32_t index) const {
+    std::call_once(tree_index_once, [this]() {
+        std::vector<std::size_t> offsets;
+        auto trees = ExpressionTrees();
+        offsets.reserve(std::min<std::size_t>(trees.Count(), rof.size));
+        for (auto itr = trees.begin(); itr != trees.end(); ++itr) {
+            offsets.push_back(itr.Offset());
+        }
+        tree_offsets = std::move(offsets);
+    });
+
+    if (index >= tree_offsets.size()) {
+        throw std::out_of_range("Expression tree index out of range.");
+    }
+
+    return ExpressionTreeView(rof, tree_offsets[index]);
+}
+
+}
\ No newline at end of file
@@ -4,9 +4,11 @@
 #include <Rof15ObjectFile.h>
 #include <Rof15ObjectWriter.h>
 #include <Serialization.h>
+#include <ThreadPool.h>
 
 #include <cassert>
 #include <chrono>
+#include <future>
 #include <limits>
 #include <string>
 #include <tuple>
@@ -53,16 +55,23 @@ uint16_t GetCPUIdentifier(object::CpuTarget cpu_target) {
     }
 }
 
-std::array<uint8_t, 6> GetDateTime(const std::time_t& time) {
+std::array<uint8_t, 6> GetDateTime(const std::time_t& time, bool utc) {
     std::array<uint8_t, 6> result {};
 
-    struct tm *parts = std::localtime(&time);
-    result[0] = parts->tm_year;
-    result[1] = parts->tm_mon;
-    result[2] = parts->tm_mday;
-    result[3] = parts->tm_hour;
-    result[4] = parts->tm_min;
-    result[5] = parts->tm_sec;
+    // Objects may be written concurrently, so avoid localtime's shared buffer.
+    // Fixed times are written in UTC, so that output doesn't depend on the machine's time zone.
+    struct tm parts {};
+    if (utc) {
+        gmtime_r(&time, &parts);
+    } else {
+        localtime_r(&time, &parts);
+    }
+    result[0] = parts.tm_year;
+    result[1] = parts.tm_mon;
+    result[2] = parts.tm_mday;
+    result[3] = parts.tm_hour;
+    result[4] = parts.tm_min;
+    result[5] = parts.tm_sec;
 
     return result;
 }
@@ -77,7 +86,7 @@ Rof15Header GetHeader(const object::ObjectFile& object_file) {
     header.AsmValid() = 0;
     header.AsmVersion() = object_file.assembler_version;
 
-    header.AsmDate() = GetDateTime(object_file.assembly_time);
+    header.AsmDate() = GetDateTime(object_file.assembly_time, object_file.fixed_assembly_time);
     header.Edition() = object_file.edition;
 
     header.StaticDataSize() = object_file.counter.uninitialized_data;
@@ -159,43 +168,134 @@ std::vector<uint8_t> GetRemoteInitializedData(const object::ObjectFile& object_f
 struct ReferenceInfo {
     std::vector<Reference> references {};
     std::vector<std::unique_ptr<ExpressionTree>> trees {};
-    std::vector<std::string> extern_refs {};
+    ExternRefTable extern_refs {};
+};
+
+// A single expression mapping within one of the psect's data maps, in the order it will be written.
+struct MappingJob {
+    object::local_offset offset;
+    const object::MemoryValue* memory;
+    const object::ExpressionMapping* mapping;
+    ReferenceFlags flags;
 };
 
-ReferenceInfo GetReferenceInfo(const object::ObjectFile& object_file) {
+std::vector<MappingJob> GetMappingJobs(const object::ObjectFile& object_file) {
+    std::vector<MappingJob> jobs {};
+
+    auto add_jobs = [&jobs](auto& data_map, ReferenceFlags flags) {
+        for (auto& [offset, memory] : data_map) {
+            for (auto& mapping : memory.expr_mappings) {
+                jobs.push_back(MappingJob { offset, &memory, &mapping, flags });
+            }
+        }
+    };
+
+    add_jobs(object_file.psect.code_data, ReferenceFlags::Code);
+    add_jobs(object_file.psect.initialized_data, ReferenceFlags::Data);
+    add_jobs(object_file.psect.remote_initialized_data, ReferenceFlags::Data | ReferenceFlags::Remote);
+
+    return jobs;
+}
+
+/**
+ * Build references and expression trees for jobs [begin, end).
+ *
+ * Each job produces exactly one tree, so the tree for job i is given index i. Extern ref
+ * indices within the resulting trees refer to the returned (chunk-local) extern ref table.
+ */
+ReferenceInfo BuildReferenceInfo(const object::ObjectFile& object_file, const std::vector<MappingJob>& jobs,
+    std::size_t begin, std::size_t end) {
     ReferenceInfo reference_info {};
     auto& references = reference_info.references;
     auto& trees = reference_info.trees;
-    auto& extern_refs = reference_info.extern_refs;
 
-    auto generate_trees = [&](auto& expr) {
-        auto index = trees.size();
-        ExpressionTreeBuilder builder(object_file, extern_refs);
-        trees.emplace_back(builder.Build(expr));
-        return index;
-    };
+    references.reserve(end - begin);
+    trees.reserve(end - begin);
 
-    auto generate_refs = [&](auto& data_map, ReferenceFlags flags) {
-        for (auto [offset, memory] : data_map) {
-            for (auto& mapping : memory.expr_mappings) {
-                // TODO: check this...
-                auto byte_index = (memory.size * 8 - (mapping.offset + mapping.bit_count)) / 8;
+    for (auto job_index = begin; job_index < end; job_index++) {
+        auto& [offset, memory, mapping, flags] = jobs[job_index];
 
-                Reference reference {};
-                reference.BitNumber() = mapping.offset;
-                reference.FieldLength() = mapping.bit_count;
-                reference.LocalOffset() = offset + byte_index;
-                reference.LocationFlag() = static_cast<uint16_t>(mapping.is_signed ? (flags | ReferenceFlags::Signed) : flags);
-                reference.ExprTreeIndex() = generate_trees(*mapping.expression);
+        // TODO: check this...
+        auto byte_index = (memory->size * 8 - (mapping->offset + mapping->bit_count)) / 8;
 
-                references.emplace_back(reference);
-            }
+        Reference reference {};
+        reference.BitNumber() = mapping->offset;
+        reference.FieldLength() = mapping->bit_count;
+        reference.LocalOffset() = offset + byte_index;
+        reference.LocationFlag() = static_cast<uint16_t>(mapping->is_signed ? (flags | ReferenceFlags::Signed) : flags);
+        reference.ExprTreeIndex() = job_index;
+
+        ExpressionTreeBuilder builder(object_file, reference_info.extern_refs);
+        trees.emplace_back(builder.Build(*mapping->expression));
+        references.emplace_back(reference);
+    }
+
+    return reference_info;
+}
+
+void RemapExternRefs(ExpressionTree& tree, const std::vector<uint32_t>& remap) {
+    if (tree.op == ExpressionOperator::Reference) {
+        auto& reference = std::get<ExpressionRef>(tree.operand1);
+        if (!(reference.Flags() & LocalReferenceFlag)) {
+            reference.Value() = remap[reference.Value()];
         }
-    };
+        return;
+    }
+
+    for (auto* operand : { &tree.operand1, &tree.operand2 }) {
+        if (auto subtree = std::get_if<std::unique_ptr<ExpressionTree>>(operand); subtree && *subtree) {
+            RemapExternRefs(**subtree, remap);
+        }
+    }
+}
+
+// Below this many mappings per worker, threading costs more than it saves.
+constexpr std::size_t MinJobsPerChunk = 256;
 
-    generate_refs(object_file.psect.code_data, ReferenceFlags::Code);
-    generate_refs(object_file.psect.initialized_data, ReferenceFlags::Data);
-    generate_refs(object_file.psect.remote_initialized_data, ReferenceFlags::Data | ReferenceFlags::Remote);
+ReferenceInfo GetReferenceInfo(const object::ObjectFile& object_file, unsigned int worker_count) {
+    auto jobs = GetMappingJobs(object_file);
+
+    auto chunk_count = std::min<std::size_t>(worker_count, jobs.size() / MinJobsPerChunk);
+    if (chunk_count <= 1) {
+        return BuildReferenceInfo(object_file, jobs, 0, jobs.size());
+    }
+
+    // Build each chunk into its own buffer, with its own extern ref table.
+    std::vector<std::future<ReferenceInfo>> chunks {};
+    {
+        support::ThreadPool pool(chunk_count);
+        auto chunk_size = (jobs.size() + chunk_count - 1) / chunk_count;
+        for (std::size_t begin = 0; begin < jobs.size(); begin += chunk_size) {
+            auto end = std::min(begin + chunk_size, jobs.size());
+            chunks.emplace_back(pool.Submit([&object_file, &jobs, begin, end]() {
+                return BuildReferenceInfo(object_file, jobs, begin, end);
+            }));
+        }
+    }
+
+    // Merge chunks in order. Assigning global extern ref indices chunk by chunk, in each chunk's
+    // first-seen order, yields the same first-seen order the serial builder would produce.
+    ReferenceInfo reference_info {};
+    reference_info.references.reserve(jobs.size());
+    reference_info.trees.reserve(jobs.size());
+
+    for (auto& chunk_future : chunks) {
+        auto chunk = chunk_future.get();
+
+        std::vector<uint32_t> remap {};
+        remap.reserve(chunk.extern_refs.Size());
+        for (auto& name : chunk.extern_refs.Names()) {
+            remap.push_back(reference_info.extern_refs.IndexOf(name));
+        }
+
+        for (auto& tree : chunk.trees) {
+            RemapExternRefs(*tree, remap);
+            reference_info.trees.emplace_back(std::move(tree));
+        }
+
+        reference_info.references.insert(reference_info.references.end(),
+            chunk.references.begin(), chunk.references.end());
+    }
 
     return reference_info;
 }
@@ -227,6 +327,7 @@ private:
 }
 
 Rof15ObjectWriter::Rof15ObjectWriter() = default;
+Rof15ObjectWriter::Rof15ObjectWriter(unsigned int worker_count) : worker_count(std::max(worker_count, 1U)) {}
 
 void Rof15ObjectWriter::Write(const object::ObjectFile& object_file, std::ostream& out) const {
     AssertValid(object_file);
@@ -269,13 +370,15 @@ void Rof15ObjectWriter::Write(const object::ObjectFile& object_file, std::ostrea
 
     // TODO: debug data would be serialized here, but it's not implemented.
 
-    auto [references, expression_trees, extern_refs] = GetReferenceInfo(object_file);
+    auto [references, expression_trees, extern_refs] = GetReferenceInfo(object_file, worker_count);
 
     // Write external ref count
-    serialize(static_cast<uint32_t>(extern_refs.size()));
+    serialize(static_cast<uint32_t>(extern_refs.Size()));
 
     // Write external references
-    serialize(extern_refs);
+    for (auto& name : extern_refs.Names()) {
+        serialize(name);
+    }
 
     // Write expression tree size (TODO: check bounds)
     serialize(static_cast<uint32_t>(expression_trees.size()));
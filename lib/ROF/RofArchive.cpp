@@ -0,0 +1,301 @@
+#include <RofArchive.h>
+#include <Rof15ObjectReader.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace rof {
+
+namespace {
+
+constexpr std::size_t HeaderSize = RofArchiveMagic.size() + 7 * sizeof(uint32_t);
+constexpr std::size_t MemberEntrySize = 4 * sizeof(uint32_t);
+constexpr std::size_t SymbolEntrySize = 3 * sizeof(uint32_t);
+constexpr std::size_t MemberAlignment = 4;
+
+[[noreturn]] void Malformed(const std::string& what) {
+    throw std::runtime_error("Malformed ROF archive: " + what);
+}
+
+void PutWord(std::string& out, uint32_t value) {
+    out.push_back(static_cast<char>(value >> 24U));
+    out.push_back(static_cast<char>(value >> 16U));
+    out.push_back(static_cast<char>(value >> 8U));
+    out.push_back(static_cast<char>(value));
+}
+
+uint32_t CheckedSize(std::size_t size) {
+    if (size > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("ROF archive is too large.");
+    }
+    return static_cast<uint32_t>(size);
+}
+
+}
+
+RofArchive::RofArchive(const std::string& path) : mapping(std::in_place, path) {
+    data = mapping->Data();
+    size = mapping->Size();
+    ReadHeader();
+}
+
+RofArchive::RofArchive(const char* data, std::size_t size) : data(data), size(size) {
+    ReadHeader();
+}
+
+bool RofArchive::IsArchive(const char* data, std::size_t size) {
+    return size >= RofArchiveMagic.size() && std::memcmp(data, RofArchiveMagic.data(), RofArchiveMagic.size()) == 0;
+}
+
+uint32_t RofArchive::ReadWord(std::size_t offset) const {
+    if (offset > size || size - offset < sizeof(uint32_t)) {
+        Malformed("unexpected end of file.");
+    }
+
+    auto* bytes = reinterpret_cast<const uint8_t*>(data + offset);
+    return uint32_t(bytes[0]) << 24U | uint32_t(bytes[1]) << 16U | uint32_t(bytes[2]) << 8U | bytes[3];
+}
+
+void RofArchive::ReadHeader() {
+    if (size < HeaderSize || !IsArchive(data, size)) {
+        throw std::runtime_error("Not a ROF archive.");
+    }
+
+    std::size_t offset = RofArchiveMagic.size();
+    auto next = [&]() {
+        auto word = ReadWord(offset);
+        offset += sizeof(uint32_t);
+        return word;
+    };
+
+    auto version = next();
+    if (version != RofArchiveVersion) {
+        throw std::runtime_error("Unsupported ROF archive version " + std::to_string(version) + ".");
+    }
+
+    member_count = next();
+    member_table = next();
+    symbol_count = next();
+    symbol_table = next();
+    string_table = next();
+    string_table_size = next();
+
+    auto check_table = [this](std::size_t offset, std::size_t length) {
+        if (offset > size || length > size - offset) {
+            Malformed("table extends past end of file.");
+        }
+    };
+
+    check_table(member_table, std::size_t(member_count) * MemberEntrySize);
+    check_table(symbol_table, std::size_t(symbol_count) * SymbolEntrySize);
+    check_table(string_table, string_table_size);
+}
+
+std::string_view RofArchive::String(uint32_t offset, std::optional<uint32_t> length) const {
+    if (offset >= string_table_size) {
+        Malformed("name is outside of the string table.");
+    }
+
+    auto* start = data + string_table + offset;
+    auto available = string_table_size - offset;
+
+    if (length) {
+        if (*length > available) Malformed("name is outside of the string table.");
+        return std::string_view(start, *length);
+    }
+
+    auto* terminator = static_cast<const char*>(std::memchr(start, '\0', available));
+    if (!terminator) {
+        Malformed("unterminated name.");
+    }
+    return std::string_view(start, terminator - start);
+}
+
+ArchiveMember RofArchive::Member(uint32_t index) const {
+    if (index >= member_count) {
+        throw std::out_of_range("Archive member index out of range.");
+    }
+
+    auto entry = member_table + std::size_t(index) * MemberEntrySize;
+    auto data_offset = ReadWord(entry + 4);
+    auto data_size = ReadWord(entry + 8);
+    if (data_offset > size || data_size > size - data_offset) {
+        Malformed("member extends past end of file.");
+    }
+
+    ArchiveMember member {};
+    member.name = String(ReadWord(entry));
+    member.data = std::string_view(data + data_offset, data_size);
+    member.modification_time = ReadWord(entry + 12);
+    return member;
+}
+
+std::optional<uint32_t> RofArchive::FindMember(std::string_view name) const {
+    for (uint32_t i = 0; i < member_count; i++) {
+        if (String(ReadWord(member_table + std::size_t(i) * MemberEntrySize)) == name) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+ArchiveSymbol RofArchive::Symbol(uint32_t index) const {
+    if (index >= symbol_count) {
+        throw std::out_of_range("Archive symbol index out of range.");
+    }
+
+    auto entry = symbol_table + std::size_t(index) * SymbolEntrySize;
+
+    ArchiveSymbol symbol {};
+    symbol.name = String(ReadWord(entry), ReadWord(entry + 4));
+    symbol.member_index = ReadWord(entry + 8);
+    return symbol;
+}
+
+std::optional<uint32_t> RofArchive::FindSymbol(std::string_view name) const {
+    uint32_t low = 0;
+    uint32_t high = symbol_count;
+
+    while (low < high) {
+        auto middle = low + (high - low) / 2;
+        auto symbol = Symbol(middle);
+
+        auto comparison = symbol.name.compare(name);
+        if (comparison == 0) {
+            return symbol.member_index;
+        }
+
+        if (comparison < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return std::nullopt;
+}
+
+std::unique_ptr<Rof15ObjectReader> RofArchive::OpenMember(uint32_t index) const {
+    auto member = Member(index);
+    return std::make_unique<Rof15ObjectReader>(member.data.data(), member.data.size());
+}
+
+void RofArchiveWriter::AddMember(const std::string& name, std::string rof, uint32_t modification_time) {
+    // Reject anything which isn't a ROF up front, rather than when the index is built.
+    Rof15ObjectReader(rof.data(), rof.size());
+
+    auto existing = std::find_if(members.begin(), members.end(), [&name](auto& member) { return member.name == name; });
+    if (existing != members.end()) {
+        existing->rof = std::move(rof);
+        existing->modification_time = modification_time;
+        return;
+    }
+
+    members.push_back(Member { name, std::move(rof), modification_time });
+}
+
+bool RofArchiveWriter::RemoveMember(const std::string& name) {
+    auto existing = std::find_if(members.begin(), members.end(), [&name](auto& member) { return member.name == name; });
+    if (existing == members.end()) {
+        return false;
+    }
+
+    members.erase(existing);
+    return true;
+}
+
+void RofArchiveWriter::AddMembers(const RofArchive& archive) {
+    for (uint32_t i = 0; i < archive.MemberCount(); i++) {
+        auto member = archive.Member(i);
+        AddMember(std::string(member.name), std::string(member.data), member.modification_time);
+    }
+}
+
+void RofArchiveWriter::Write(std::ostream& out) const {
+    struct IndexEntry {
+        std::string_view name;
+        uint32_t member_index;
+    };
+
+    // Readers must stay alive while the index refers to names within them.
+    std::vector<std::unique_ptr<Rof15ObjectReader>> readers {};
+    std::vector<IndexEntry> index {};
+    std::unordered_set<std::string_view> indexed {};
+
+    for (std::size_t i = 0; i < members.size(); i++) {
+        auto& rof = members[i].rof;
+        auto& reader = readers.emplace_back(std::make_unique<Rof15ObjectReader>(rof.data(), rof.size()));
+        for (auto def : reader->ExternDefinitions()) {
+            if (indexed.insert(def.name).second) {
+                index.push_back(IndexEntry { def.name, static_cast<uint32_t>(i) });
+            }
+        }
+    }
+
+    std::sort(index.begin(), index.end(), [](auto& a, auto& b) { return a.name < b.name; });
+
+    std::string strings {};
+    std::vector<uint32_t> member_names {};
+    for (auto& member : members) {
+        member_names.push_back(CheckedSize(strings.size()));
+        strings.append(member.name);
+        strings.push_back('\0');
+    }
+
+    std::vector<uint32_t> symbol_names {};
+    for (auto& entry : index) {
+        symbol_names.push_back(CheckedSize(strings.size()));
+        strings.append(entry.name);
+        strings.push_back('\0');
+    }
+
+    auto member_table = HeaderSize;
+    auto symbol_table = member_table + members.size() * MemberEntrySize;
+    auto string_table = symbol_table + index.size() * SymbolEntrySize;
+
+    std::string tables {};
+    tables.append(RofArchiveMagic.data(), RofArchiveMagic.size());
+    PutWord(tables, RofArchiveVersion);
+    PutWord(tables, CheckedSize(members.size()));
+    PutWord(tables, CheckedSize(member_table));
+    PutWord(tables, CheckedSize(index.size()));
+    PutWord(tables, CheckedSize(symbol_table));
+    PutWord(tables, CheckedSize(string_table));
+    PutWord(tables, CheckedSize(strings.size()));
+
+    auto data_offset = string_table + strings.size();
+    std::vector<std::size_t> member_offsets {};
+    for (std::size_t i = 0; i < members.size(); i++) {
+        data_offset = (data_offset + MemberAlignment - 1) / MemberAlignment * MemberAlignment;
+        member_offsets.push_back(data_offset);
+
+        PutWord(tables, member_names[i]);
+        PutWord(tables, CheckedSize(data_offset));
+        PutWord(tables, CheckedSize(members[i].rof.size()));
+        PutWord(tables, members[i].modification_time);
+
+        data_offset += members[i].rof.size();
+    }
+    CheckedSize(data_offset);
+
+    for (std::size_t i = 0; i < index.size(); i++) {
+        PutWord(tables, symbol_names[i]);
+        PutWord(tables, CheckedSize(index[i].name.size()));
+        PutWord(tables, index[i].member_index);
+    }
+
+    tables.append(strings);
+    out.write(tables.data(), tables.size());
+
+    auto written = tables.size();
+    for (std::size_t i = 0; i < members.size(); i++) {
+        out.write(std::string(member_offsets[i] - written, '\0').data(), member_offsets[i] - written);
+        out.write(members[i].rof.data(), members[i].rof.size());
+        written = member_offsets[i] + members[i].rof.size();
+    }
+}
+
+}
\ No newline at end of file
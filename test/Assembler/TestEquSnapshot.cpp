@@ -0,0 +1,104 @@
+#include <catch2/catch.hpp>
+
+#include <EquSnapshot.h>
+
+#include <AssemblerTypes.h>
+#include <AssemblyState.h>
+#include <ExpressionResolver.h>
+#include <InputFileParser.h>
+#include <ObjectFile.h>
+
+#include "ComparisonHelpers.h"
+#include "PrinterHelpers.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace assembler {
+
+namespace {
+std::vector<Entry> Parse(const std::string& source) {
+    std::istringstream input(source);
+
+    InputFileParser parser {};
+    parser.Parse(input);
+
+    return parser.GetListing();
+}
+}
+
+SCENARIO("Equ snapshots round trip", "[assembler]") {
+    GIVEN("a snapshot compiled from constant and symbolic equs") {
+        auto snapshot_data = EquSnapshot::Compile(Parse(
+            "* System definitions\n"
+            "Base equ $1000\n"
+            "Size equ 4*8\n"
+            "Limit: equ Base+Size-1\n"
+            "Mask equ ~(Size-1)\n"
+            "Remote equ extern+4\n"
+            "Split equ hi(extern)\n"));
+
+        EquSnapshot snapshot(snapshot_data.data(), snapshot_data.size());
+        REQUIRE(snapshot.Count() == 6);
+
+        THEN("equs resolvable at compile time are stored as constants") {
+            REQUIRE(snapshot.ConstantValue("Base") == 0x1000U);
+            REQUIRE(snapshot.ConstantValue("Size") == 32U);
+            REQUIRE(snapshot.ConstantValue("Limit") == 0x101FU);
+            REQUIRE(snapshot.ConstantValue("Mask") == ~31U);
+            REQUIRE_FALSE(snapshot.ConstantValue("Remote"));
+            REQUIRE_FALSE(snapshot.ConstantValue("Undefined"));
+        }
+
+        WHEN("the snapshot is loaded into an assembly state") {
+            AssemblyState state {};
+            snapshot.LoadInto(state);
+            ExpressionResolver resolver(state);
+
+            THEN("every equ is defined with its original operand text") {
+                REQUIRE(state.equs.size() == 6);
+                REQUIRE(state.equs.at("Limit")->AsString() == "Base+Size-1");
+                REQUIRE(state.equs.at("Size")->Resolve(resolver) == 32U);
+            }
+
+            THEN("symbolic equs keep their expression") {
+                auto remote = state.equs.at("Remote")->Move();
+                auto split = state.equs.at("Split")->Move();
+                REQUIRE(dynamic_cast<expression::AdditionExpression*>(remote.get()));
+                REQUIRE(dynamic_cast<expression::HiExpression*>(split.get()));
+            }
+
+            THEN("global equs are defined as symbols") {
+                REQUIRE(state.GetSymbol("Limit") == object::SymbolInfo { object::SymbolInfo::Type::Equ, true, 0x101F });
+                REQUIRE_FALSE(state.GetSymbol("Base"));
+            }
+        }
+    }
+
+    GIVEN("a listing containing something other than equs") {
+        THEN("compiling it fails") {
+            REQUIRE_THROWS_AS(EquSnapshot::Compile(Parse("Base equ 1\n nop\n")), std::runtime_error);
+        }
+    }
+
+    GIVEN("data which isn't a snapshot") {
+        std::string data = "!<roflb>";
+        data.resize(64);
+
+        THEN("reading it fails") {
+            REQUIRE_THROWS_AS(EquSnapshot(data.data(), data.size()), std::runtime_error);
+        }
+    }
+
+    GIVEN("a truncated snapshot") {
+        auto snapshot_data = EquSnapshot::Compile(Parse("Base equ 1\n"));
+        snapshot_data.resize(snapshot_data.size() - 4);
+
+        THEN("reading it fails") {
+            REQUIRE_THROWS_AS(EquSnapshot(snapshot_data.data(), snapshot_data.size()), std::runtime_error);
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,165 @@
+#include <catch2/catch.hpp>
+
+#include <IncludeCache.h>
+
+#include <Assembler.h>
+#include <AssemblerTypes.h>
+#include <InputFileParser.h>
+#include <MipsAssemblerTarget.h>
+#include <ObjectFile.h>
+#include <ThreadPool.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace assembler {
+
+namespace {
+std::filesystem::path MakeTempDirectory() {
+    auto directory = std::filesystem::temp_directory_path() / ("include-cache-test-" + std::to_string(getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+void WriteFile(const std::filesystem::path& path, const std::string& contents) {
+    std::ofstream out(path, std::ios::trunc);
+    out << contents;
+}
+
+std::vector<Entry> Parse(const std::string& source) {
+    std::istringstream input(source);
+
+    InputFileParser parser {};
+    parser.Parse(input);
+
+    return parser.GetListing();
+}
+
+// Reserves size bytes, so that its value can be observed in the result.
+std::vector<Entry> Reserve(const std::string& use, const std::string& size) {
+    return Parse(" use " + use + "\n psect test,0,0,0,0,0\n vsect\nbuf ds.b " + size + "\n ends\n ends\n");
+}
+
+std::unique_ptr<Assembler> MakeAssembler() {
+    return std::make_unique<Assembler>(15, std::make_unique<MipsAssemblerTarget>(support::Endian::big));
+}
+}
+
+SCENARIO("Included files are parsed once per cache", "[assembler]") {
+    auto directory = MakeTempDirectory();
+    auto defs = directory / "defs.d";
+    WriteFile(defs, "Base equ $1000\n");
+
+    GIVEN("an include cache") {
+        IncludeCache cache {};
+
+        WHEN("the same file is requested twice, by different paths") {
+            auto first = cache.Get(defs);
+            auto second = cache.Get(directory / "." / "defs.d");
+
+            THEN("it's parsed once, and both requests share the listing") {
+                REQUIRE(cache.ParseCount() == 1);
+                REQUIRE(first == second);
+                REQUIRE(first->size() == 1);
+                REQUIRE(first->front().operation == "equ");
+            }
+        }
+
+        WHEN("the file changes between requests") {
+            auto first = cache.Get(defs);
+            WriteFile(defs, "Base equ $1000\nSize equ 4\n");
+            auto second = cache.Get(defs);
+
+            THEN("it's parsed again") {
+                REQUIRE(cache.ParseCount() == 2);
+                REQUIRE(first->size() == 1);
+                REQUIRE(second->size() == 2);
+            }
+        }
+
+        WHEN("many threads request the same file at once") {
+            std::vector<std::future<std::shared_ptr<const IncludeCache::Listing>>> results {};
+            {
+                support::ThreadPool pool(8);
+                for (int i = 0; i < 64; i++) {
+                    results.push_back(pool.Submit([&cache, &defs]() { return cache.Get(defs); }));
+                }
+            }
+
+            THEN("it's parsed once") {
+                REQUIRE(cache.ParseCount() == 1);
+                for (auto& result : results) {
+                    REQUIRE(result.get()->size() == 1);
+                }
+            }
+        }
+
+        WHEN("the file doesn't exist") {
+            THEN("the request fails") {
+                REQUIRE_THROWS(cache.Get(directory / "missing.d"));
+            }
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+SCENARIO("The use directive includes another listing", "[assembler]") {
+    auto directory = MakeTempDirectory();
+    WriteFile(directory / "defs.d", "Base: equ $1000\n");
+    WriteFile(directory / "more.d", " use defs.d\nLimit: equ Base+$FF\n");
+    WriteFile(directory / "loop.d", " use loop.d\n");
+
+    GIVEN("assemblers sharing an include cache") {
+        auto cache = std::make_shared<IncludeCache>();
+        auto first = MakeAssembler();
+        auto second = MakeAssembler();
+        first->SetIncludeCache(cache);
+        second->SetIncludeCache(cache);
+        first->AddIncludeDirectory(directory);
+        second->AddIncludeDirectory(directory);
+
+        WHEN("both assemble sources using the same file") {
+            auto first_object = first->Process(Reserve("more.d", "Limit"));
+            auto second_object = second->Process(Reserve("defs.d", "Base+4"));
+
+            THEN("the definitions of included files are visible") {
+                REQUIRE(first_object->counter.uninitialized_data == 0x10FF);
+                REQUIRE(second_object->counter.uninitialized_data == 0x1004);
+                REQUIRE(first_object->psect.symbols.at("Limit").type == object::SymbolInfo::Type::Equ);
+            }
+
+            THEN("each file is parsed once") {
+                REQUIRE(cache->ParseCount() == 2);
+            }
+
+            THEN("the files included by each source are reported") {
+                auto defs = std::filesystem::canonical(directory / "defs.d");
+                auto more = std::filesystem::canonical(directory / "more.d");
+                REQUIRE(first->GetIncludedFiles() == std::vector<std::filesystem::path> { more, defs });
+                REQUIRE(second->GetIncludedFiles() == std::vector<std::filesystem::path> { defs });
+            }
+        }
+
+        WHEN("a file includes itself") {
+            THEN("assembly fails") {
+                REQUIRE_THROWS_AS(first->Process(Parse(" use loop.d\n")), OperationException);
+            }
+        }
+
+        WHEN("an included file doesn't exist") {
+            THEN("assembly fails") {
+                REQUIRE_THROWS_AS(first->Process(Parse(" use missing.d\n")), OperationException);
+            }
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+}
\ No newline at end of file
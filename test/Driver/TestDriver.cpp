@@ -0,0 +1,267 @@
+#include <catch2/catch.hpp>
+
+#include <Driver.h>
+
+#include <Rof15ObjectReader.h>
+
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <unistd.h>
+
+namespace driver {
+
+namespace {
+const std::string ValidSource =
+    "* A small module\n"
+    "Size equ 16\n"
+    " psect test,0,0,0,0,0\n"
+    " vsect\n"
+    "buf: ds.b Size\n"
+    " ends\n"
+    "start: addiu t0,zero,Size\n"
+    " ends\n";
+}
+
+SCENARIO("Sources are assembled in memory", "[driver]") {
+    AssembleOptions options {};
+    options.fixed_time = 0;
+
+    GIVEN("a valid source") {
+        auto result = Assemble(ValidSource, options);
+
+        THEN("a ROF is produced, with no diagnostics") {
+            REQUIRE(result.rof);
+            REQUIRE(result.diagnostics.empty());
+
+            rof::Rof15ObjectReader reader(result.rof->data(), result.rof->size());
+            REQUIRE(reader.Header().CodeSize() == 4);
+            REQUIRE(reader.Header().StaticDataSize() == 16);
+            REQUIRE(reader.ExternDefinitions().Count() == 2);
+        }
+
+        THEN("the same source and options produce the same ROF") {
+            REQUIRE(Assemble(ValidSource, options).rof == result.rof);
+        }
+    }
+
+    GIVEN("a fixed time, which falls on different dates in different time zones") {
+        options.fixed_time = 1700000000 + 23 * 3600;
+
+        WHEN("the source is assembled in two time zones") {
+            auto* original = std::getenv("TZ");
+            auto original_tz = original ? std::optional<std::string>(original) : std::nullopt;
+
+            auto assemble_in = [&options](const char* tz) {
+                setenv("TZ", tz, 1);
+                tzset();
+                return Assemble(ValidSource, options).rof;
+            };
+
+            auto utc = assemble_in("UTC0");
+            auto tokyo = assemble_in("JST-9");
+
+            if (original_tz) setenv("TZ", original_tz->c_str(), 1); else unsetenv("TZ");
+            tzset();
+
+            THEN("the ROFs are identical") {
+                REQUIRE(utc);
+                REQUIRE(utc == tokyo);
+            }
+        }
+    }
+
+    GIVEN("a source with an invalid instruction") {
+        auto result = Assemble(" psect test,0,0,0,0,0\n\n addiu t0,nothere,1\n ends\n", options);
+
+        THEN("an error is reported on its line") {
+            REQUIRE_FALSE(result.rof);
+            REQUIRE(result.diagnostics.size() == 1);
+            REQUIRE(result.diagnostics[0].severity == Diagnostic::Severity::Error);
+            REQUIRE(result.diagnostics[0].file.empty());
+            REQUIRE(result.diagnostics[0].line == 3);
+            REQUIRE(FormatDiagnostic(result.diagnostics[0], "gen.a").rfind("gen.a:3: error: ", 0) == 0);
+        }
+    }
+
+    GIVEN("a source which can't be parsed") {
+        auto result = Assemble("Size equ 1\n9bad equ 2\n", options);
+
+        THEN("an error is reported on its line") {
+            REQUIRE_FALSE(result.rof);
+            REQUIRE(result.diagnostics.size() == 1);
+            REQUIRE(result.diagnostics[0].line == 2);
+        }
+    }
+
+    GIVEN("a source using an included file with an error") {
+        auto directory = std::filesystem::temp_directory_path() / ("driver-test-" + std::to_string(getpid()));
+        std::filesystem::create_directories(directory);
+        std::ofstream(directory / "defs.d") << "Size equ 16\nBad equ (1\n";
+
+        options.include_directories.push_back(directory);
+        auto result = Assemble(" use defs.d\n", options);
+
+        THEN("the error is attributed to the included file") {
+            REQUIRE_FALSE(result.rof);
+            REQUIRE(result.diagnostics.size() == 1);
+            REQUIRE(result.diagnostics[0].file == std::filesystem::canonical(directory / "defs.d"));
+            REQUIRE(result.diagnostics[0].line == 2);
+            REQUIRE(result.included_files.size() == 1);
+        }
+
+        std::filesystem::remove_all(directory);
+    }
+
+    GIVEN("a file included from a working directory other than the process's") {
+        auto directory = std::filesystem::temp_directory_path() / ("driver-test-" + std::to_string(getpid()));
+        std::filesystem::create_directories(directory);
+        std::ofstream(directory / "workdir-defs.d") << "Size equ 16\n";
+        REQUIRE(std::filesystem::current_path() != directory);
+
+        WHEN("the working directory is given") {
+            options.working_directory = directory;
+            auto result = Assemble(" use workdir-defs.d\n", options);
+
+            THEN("the file is found there") {
+                REQUIRE(result.rof);
+                REQUIRE(result.included_files == std::vector { std::filesystem::canonical(directory / "workdir-defs.d") });
+            }
+        }
+
+        WHEN("it isn't") {
+            auto result = Assemble(" use workdir-defs.d\n", options);
+
+            THEN("the file isn't found") {
+                REQUIRE_FALSE(result.rof);
+            }
+        }
+
+        std::filesystem::remove_all(directory);
+    }
+}
+
+SCENARIO("Edited sources are reparsed incrementally", "[driver]") {
+    AssembleOptions options {};
+    options.fixed_time = 0;
+
+    GIVEN("a listing of a valid source") {
+        IncrementalListing listing {};
+        REQUIRE(listing.Update(ValidSource).empty());
+        // " ends" appears twice, but is parsed once.
+        REQUIRE(listing.LastParsedLineCount() == 7);
+
+        THEN("it assembles to the same ROF as the source") {
+            REQUIRE(Assemble(listing.Listing(), options).rof == Assemble(ValidSource, options).rof);
+        }
+
+        WHEN("one line is changed") {
+            std::string edited = ValidSource;
+            edited.replace(edited.find("Size equ 16"), 11, "Size equ 32");
+            REQUIRE(listing.Update(edited).empty());
+
+            THEN("only that line is reparsed") {
+                REQUIRE(listing.LastParsedLineCount() == 1);
+                REQUIRE(Assemble(listing.Listing(), options).rof == Assemble(edited, options).rof);
+            }
+        }
+
+        WHEN("lines are inserted above others") {
+            auto result = listing.Update("\n\n" + ValidSource);
+
+            THEN("the moved lines are reused and renumbered") {
+                REQUIRE(result.empty());
+                REQUIRE(listing.LastParsedLineCount() == 1);
+                REQUIRE(listing.Listing().back().line == 10);
+            }
+        }
+
+        WHEN("a line can't be parsed") {
+            auto result = listing.Update(ValidSource + "9bad equ 2\n");
+
+            THEN("an error is reported on its line") {
+                REQUIRE(result.size() == 1);
+                REQUIRE(result[0].line == 9);
+            }
+        }
+    }
+}
+
+SCENARIO("Edited listings are reassembled keeping their layout", "[driver]") {
+    AssembleOptions options {};
+    options.fixed_time = 0;
+
+    GIVEN("an assembled listing") {
+        IncrementalListing listing {};
+        IncrementalAssembly assembly {};
+        REQUIRE(listing.Update(ValidSource).empty());
+
+        auto first = assembly.Update(listing.Listing(), options);
+        REQUIRE_FALSE(assembly.LastKeptLayout());
+        REQUIRE(first.rof == Assemble(ValidSource, options).rof);
+
+        auto reassemble = [&](const std::string& find, const std::string& replace) {
+            std::string edited = ValidSource;
+            edited.replace(edited.find(find), find.size(), replace);
+            REQUIRE(listing.Update(edited).empty());
+
+            auto result = assembly.Update(listing.Listing(), options);
+            REQUIRE(result.rof == Assemble(edited, options).rof);
+            return result;
+        };
+
+        WHEN("only a comment changes") {
+            reassemble("* A small module", "* A smaller module");
+
+            THEN("nothing is encoded") {
+                REQUIRE(assembly.LastKeptLayout());
+                REQUIRE(assembly.LastEncodedCount() == 0);
+            }
+        }
+
+        WHEN("an instruction's operands change") {
+            reassemble("addiu t0,zero,Size", "addiu t1,t0,Size+1");
+
+            THEN("only that instruction is encoded") {
+                REQUIRE(assembly.LastKeptLayout());
+                REQUIRE(assembly.LastEncodedCount() == 1);
+            }
+        }
+
+        WHEN("a line which affects the layout changes") {
+            reassemble("Size equ 16", "Size equ 32");
+
+            THEN("the listing is assembled in full") {
+                REQUIRE_FALSE(assembly.LastKeptLayout());
+            }
+        }
+
+        WHEN("an instruction is added") {
+            reassemble("addiu t0,zero,Size", "addiu t0,zero,Size\n addu t1,t0,t0");
+
+            THEN("the listing is assembled in full") {
+                REQUIRE_FALSE(assembly.LastKeptLayout());
+            }
+        }
+
+        WHEN("an instruction's new operands are invalid") {
+            std::string edited = ValidSource;
+            edited.replace(edited.find("zero,Size"), 4, "nothere");
+            REQUIRE(listing.Update(edited).empty());
+
+            auto result = assembly.Update(listing.Listing(), options);
+
+            THEN("the full pass reports the error on its line") {
+                REQUIRE_FALSE(assembly.LastKeptLayout());
+                REQUIRE_FALSE(result.rof);
+                REQUIRE(result.diagnostics.size() == 1);
+                REQUIRE(result.diagnostics[0].line == 7);
+            }
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <SourceIndex.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+namespace driver {
+
+namespace {
+const std::string Source =
+    "Size equ 16\n"
+    "Double equ Size*2\n"
+    "Loop1 equ Loop2\n"
+    "Loop2 equ Loop1\n"
+    " psect test,0,0,0,0,0\n"
+    " vsect\n"
+    "buf: ds.b Size\n"
+    "buf2: ds.b Double\n"
+    " ends\n"
+    "start: addiu t0,zero,Size\n"
+    "next: addiu t0,zero,Double\n"
+    " ends\n";
+}
+
+SCENARIO("Sources are indexed for queries", "[driver]") {
+    SourceIndex index {};
+
+    GIVEN("a source which has been updated, but not analyzed") {
+        index.Update(Source);
+
+        THEN("its definitions are indexed") {
+            REQUIRE(index.Definitions().size() == 8);
+            REQUIRE_FALSE(index.IsAnalyzed());
+
+            auto definition = index.FindDefinition("Double");
+            REQUIRE(definition);
+            REQUIRE(definition->kind == Definition::Kind::Equ);
+            REQUIRE(definition->line == 2);
+            REQUIRE(definition->file.empty());
+
+            REQUIRE(index.FindDefinition("next")->line == 11);
+            REQUIRE_FALSE(index.FindDefinition("missing"));
+        }
+
+        THEN("equs are evaluated") {
+            REQUIRE(index.Value("Size") == 16U);
+            REQUIRE(index.Value("Double") == 32U);
+        }
+
+        THEN("equs which refer to each other have no value") {
+            REQUIRE_FALSE(index.Value("Loop1"));
+            REQUIRE_FALSE(index.Value("start"));
+        }
+
+        WHEN("it's analyzed") {
+            index.Analyze();
+
+            THEN("its counters are laid out") {
+                REQUIRE(index.IsAnalyzed());
+                REQUIRE(index.Diagnostics().empty());
+                REQUIRE(index.GetLayout());
+
+                auto& layout = index.GetLayout().value();
+                REQUIRE(layout.symbols.at("buf2").value == 16U);
+                REQUIRE(layout.symbols.at("next").type == object::SymbolInfo::Code);
+                REQUIRE(layout.symbols.at("next").value == 4U);
+                REQUIRE(layout.counter.code == 8);
+            }
+        }
+
+        WHEN("an equ is edited") {
+            std::string edited = Source;
+            edited.replace(edited.find("Size equ 16"), 11, "Size equ 8");
+            index.Update(edited);
+
+            THEN("only its line is reparsed, and values follow it") {
+                REQUIRE(index.LastParsedLineCount() == 1);
+                REQUIRE(index.Value("Double") == 16U);
+            }
+        }
+
+        WHEN("a line can't be parsed") {
+            index.Update(Source + "9bad equ 2\n");
+
+            THEN("the parse error is reported without analysis") {
+                REQUIRE(index.Diagnostics().size() == 1);
+                REQUIRE(index.Diagnostics()[0].line == 13);
+            }
+        }
+    }
+
+    GIVEN("a source which uses a file") {
+        auto directory = std::filesystem::temp_directory_path() / ("index-test-" + std::to_string(getpid()));
+        std::filesystem::create_directories(directory);
+        std::ofstream(directory / "defs.d") << "* Definitions\nBase equ 4\n";
+
+        AssembleOptions options {};
+        options.include_directories.push_back(directory);
+        SourceIndex used(options);
+        used.Update(" use defs.d\nTotal equ Base+1\n");
+
+        THEN("the file's definitions are indexed once analyzed") {
+            REQUIRE_FALSE(used.FindDefinition("Base"));
+
+            used.Analyze();
+            auto definition = used.FindDefinition("Base");
+            REQUIRE(definition);
+            REQUIRE(definition->file == std::filesystem::canonical(directory / "defs.d"));
+            REQUIRE(definition->line == 2);
+            REQUIRE(used.Value("Total") == 5U);
+        }
+
+        std::filesystem::remove_all(directory);
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include <catch2/catch.hpp>
+
+#include <Linker.h>
+#include <Module.hpp>
+#include <ModuleHeader.hpp>
+#include <Rof15ObjectReader.h>
+#include <Rof15ObjectWriter.h>
+#include <RofArchive.h>
+#include <Serialization.h>
+
+#include <Expression.h>
+
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace linker {
+
+namespace {
+object::MemoryValue Word(uint32_t value) {
+    object::MemoryValue memory {};
+    memory.size = 4;
+    memory.data.u32 = value;
+    return memory;
+}
+
+// Keeps the ROF bytes alive alongside the reader which borrows them.
+struct OwnedObject {
+    std::string bytes;
+    std::shared_ptr<rof::Rof15ObjectReader> reader;
+};
+
+std::shared_ptr<OwnedObject> ToObject(const object::ObjectFile& object_file) {
+    auto owned = std::make_shared<OwnedObject>();
+
+    std::stringstream out;
+    rof::Rof15ObjectWriter().Write(object_file, out);
+    owned->bytes = out.str();
+    owned->reader = std::make_shared<rof::Rof15ObjectReader>(owned->bytes.data(), owned->bytes.size());
+
+    return owned;
+}
+
+object::ObjectFile MakeObjectFile(const std::string& name) {
+    object::ObjectFile object_file {};
+    object_file.name = name;
+    object_file.tylan = 0x0101;
+    object_file.edition = 3;
+    object_file.cpu_target = object::CpuTarget::os9k_mips;
+    object_file.endian = support::Endian::big;
+    object_file.assembly_time = 0;
+    object_file.trap_handler_offset = 0xFFFFFFFF;
+    return object_file;
+}
+
+uint32_t ReadBigEndian(const std::vector<char>& bytes, std::size_t offset) {
+    uint32_t value = 0;
+    for (std::size_t i = 0; i < 4; i++) {
+        value = value << 8U | static_cast<uint8_t>(bytes[offset + i]);
+    }
+    return value;
+}
+
+module::Module ToModule(const std::vector<char>& bytes) {
+    auto header = std::make_shared<module::ModuleHeader>();
+    std::istringstream in(std::string(bytes.data(), bytes.size()));
+    serializer::Deserialize<support::Endian::big>(*static_cast<module::SerializableModuleHeader*>(header.get()), in);
+
+    auto raw = std::make_unique<char[]>(bytes.size());
+    std::memcpy(raw.get(), bytes.data(), bytes.size());
+    return module::Module(header, std::move(raw));
+}
+}
+
+SCENARIO("ROFs are linked into a valid module", "[linker]") {
+    using namespace expression;
+
+    GIVEN("a main object which refers to a helper defined in a second object") {
+        auto main_file = MakeObjectFile("main");
+        main_file.psect.symbols["main"] = object::SymbolInfo { object::SymbolInfo::Type::Code, true, 0 };
+
+        auto call = Word(0x24020000);
+        call.expr_mappings.emplace_back(0, 16, false, std::make_shared<LoExpression>(nullptr,
+            std::make_unique<ReferenceExpression>("helper")));
+        main_file.psect.code_data[0] = call;
+        main_file.psect.code_data[4] = Word(0x03e00008);
+        main_file.counter.code = 8;
+
+        auto pointer = Word(0);
+        pointer.expr_mappings.emplace_back(0, 32, false, std::make_shared<ReferenceExpression>("helper"));
+        main_file.psect.initialized_data[0] = pointer;
+        main_file.counter.initialized_data = 4;
+
+        auto helper_file = MakeObjectFile("helper");
+        helper_file.psect.symbols["helper"] = object::SymbolInfo { object::SymbolInfo::Type::Code, true, 4 };
+        helper_file.psect.code_data[0] = Word(0);
+        helper_file.psect.code_data[4] = Word(0x03e00008);
+        helper_file.counter.code = 8;
+
+        auto main_object = ToObject(main_file);
+        auto helper_object = ToObject(helper_file);
+
+        WHEN("the objects are linked") {
+            Linker linker {};
+            linker.AddObject(main_object->reader);
+            linker.AddObject(helper_object->reader);
+
+            ModuleOptions options {};
+            options.name = "prog";
+            auto bytes = linker.Link(options);
+            auto linked = ToModule(bytes);
+
+            auto code = sizeof(module::ModuleHeader);
+            auto helper = code + 8 + 4;
+
+            THEN("the header parity and CRC are valid") {
+                REQUIRE(linked.GetHeader()->Size() == bytes.size());
+                REQUIRE(linked.IsHeaderValid());
+                REQUIRE(linked.IsCrcValid());
+                REQUIRE(linked.GetName() == "prog");
+                REQUIRE(linked.GetHeader()->Edition() == 3);
+                REQUIRE(linked.GetHeader()->OffsetToExec() == code);
+            }
+
+            THEN("references to the helper are resolved") {
+                REQUIRE(ReadBigEndian(bytes, code) == (0x24020000 | helper));
+
+                auto init_data = linked.GetInitializationDataHeader();
+                REQUIRE(init_data.GetByteCount() == 4);
+                REQUIRE(ReadBigEndian(bytes, linked.GetHeader()->InitializedDataOffset() + 8) == helper);
+            }
+
+            THEN("the pointer to code is listed in the initialized data references") {
+                auto refs = linked.GetHeader()->InitDataRefOffset();
+                REQUIRE(ReadBigEndian(bytes, refs) == 1); // msw 0, count 1
+                REQUIRE(ReadBigEndian(bytes, refs + 4) >> 16U == 0); // lsw 0
+            }
+        }
+
+        WHEN("the objects are linked on several threads") {
+            Linker serial {};
+            Linker parallel(4);
+            for (auto* object : { &main_object, &helper_object }) {
+                serial.AddObject((*object)->reader);
+                parallel.AddObject((*object)->reader);
+            }
+
+            THEN("the module is identical") {
+                REQUIRE(serial.Link({}) == parallel.Link({}));
+            }
+        }
+
+        WHEN("the helper object is missing") {
+            Linker linker {};
+            linker.AddObject(main_object->reader);
+
+            THEN("linking fails with an undefined symbol") {
+                REQUIRE_THROWS_WITH(linker.Link({}), Catch::Contains("Undefined symbol 'helper'"));
+            }
+        }
+
+        WHEN("the helper is defined twice") {
+            Linker linker {};
+            linker.AddObject(main_object->reader);
+            linker.AddObject(helper_object->reader);
+            linker.AddObject(helper_object->reader);
+
+            THEN("linking fails with a duplicate symbol") {
+                REQUIRE_THROWS_WITH(linker.Link({}), Catch::Contains("'helper' is defined in both"));
+            }
+        }
+
+        WHEN("the helper is linked from an archive") {
+            rof::RofArchiveWriter writer {};
+            auto unused_file = MakeObjectFile("unused");
+            unused_file.psect.symbols["unused"] = object::SymbolInfo { object::SymbolInfo::Type::Code, true, 0 };
+            writer.AddMember("unused.r", ToObject(unused_file)->bytes);
+            writer.AddMember("helper.r", helper_object->bytes);
+
+            std::stringstream archive_out;
+            writer.Write(archive_out);
+            auto archive_bytes = archive_out.str();
+
+            Linker from_archive {};
+            from_archive.AddObject(main_object->reader);
+            from_archive.AddArchive(std::make_shared<rof::RofArchive>(archive_bytes.data(), archive_bytes.size()));
+
+            Linker direct {};
+            direct.AddObject(main_object->reader);
+            direct.AddObject(helper_object->reader);
+
+            THEN("only the needed member is linked") {
+                REQUIRE(from_archive.Link({}) == direct.Link({}));
+            }
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#include "ModuleHelpers.h"
+
+#include <ModuleHeaderView.hpp>
+#include <ModulePatcher.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace module {
+
+std::string MakeModule(std::size_t size, const std::string& name, const std::function<char()>& fill) {
+    auto body = ModuleHeaderView::HeaderSize + name.size() + 1;
+    if (size < body + sizeof(uint32_t)) {
+        throw std::invalid_argument("Module is too small for its header and name.");
+    }
+
+    std::string module(size, '\0');
+    for (auto i = body; i < size; i++) {
+        module[i] = fill();
+    }
+
+    module[0] = static_cast<char>(0x4D);
+    module[1] = static_cast<char>(0xAD);
+    module[4] = static_cast<char>(size >> 24U);
+    module[5] = static_cast<char>(size >> 16U);
+    module[6] = static_cast<char>(size >> 8U);
+    module[7] = static_cast<char>(size);
+
+    // The name follows the header.
+    module[15] = static_cast<char>(ModuleHeaderView::HeaderSize);
+    std::memcpy(module.data() + ModuleHeaderView::HeaderSize, name.c_str(), name.size() + 1);
+
+    ModulePatcher(module.data(), module.size()).Rebuild();
+    return module;
+}
+
+std::string MakeModule(std::size_t size, const std::string& name, char fill) {
+    return MakeModule(size, name, [fill]() { return fill; });
+}
+
+}
\ No newline at end of file
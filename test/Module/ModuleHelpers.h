@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace module {
+
+/**
+ * A big endian module of size bytes, with a valid parity and CRC. The header is zeroed apart
+ * from its sync bytes, size and name offset. name follows the header, and every later byte but
+ * the CRC comes from fill.
+ */
+std::string MakeModule(std::size_t size, const std::string& name, const std::function<char()>& fill);
+
+// As above, with every byte after the name set to fill.
+std::string MakeModule(std::size_t size, const std::string& name = "demo", char fill = '\0');
+
+}
\ No newline at end of file
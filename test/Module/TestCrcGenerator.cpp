@@ -0,0 +1,163 @@
+#include <catch2/catch.hpp>
+
+#include <CrcGenerator.hpp>
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+namespace module {
+
+namespace {
+std::string RandomBytes(std::size_t size, std::mt19937& random) {
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    std::string bytes(size, '\0');
+    for (auto& c : bytes) c = static_cast<char>(byte(random));
+    return bytes;
+}
+}
+
+SCENARIO("The module CRC is generated 8 bytes at a time", "[module]") {
+    std::mt19937 random(0x05C9);
+
+    GIVEN("buffers of every length up to a few words, at every alignment") {
+        auto bytes = RandomBytes(64 + 8, random);
+
+        THEN("the CRC matches the bytewise reference") {
+            for (std::size_t offset = 0; offset < 8; offset++) {
+                for (std::size_t size = 0; size <= 64; size++) {
+                    uint32_t expected = -1;
+                    crc::GenerateBytewise(bytes.data() + offset, size, &expected);
+
+                    uint32_t actual = -1;
+                    crc::Generate(bytes.data() + offset, size, &actual);
+                    REQUIRE(actual == expected);
+                }
+            }
+        }
+    }
+
+    GIVEN("a large buffer, generated in pieces") {
+        auto bytes = RandomBytes(1 << 20, random);
+
+        THEN("the CRC matches the bytewise reference over the whole buffer") {
+            uint32_t expected = -1;
+            crc::GenerateBytewise(bytes.data(), bytes.size(), &expected);
+
+            uint32_t actual = -1;
+            crc::Generate(bytes.data(), 12345, &actual);
+            crc::Generate(bytes.data() + 12345, bytes.size() - 12345, &actual);
+            REQUIRE(actual == expected);
+        }
+    }
+
+    GIVEN("random buffers, offsets and starting CRCs") {
+        auto bytes = RandomBytes(8192 + 16, random);
+        std::uniform_int_distribution<std::size_t> size(0, 8192);
+        std::uniform_int_distribution<std::size_t> offset(0, 15);
+        std::uniform_int_distribution<uint32_t> start;
+
+        THEN("the CRC matches the bytewise reference, whichever kernel the CPU gets") {
+            for (int i = 0; i < 500; i++) {
+                auto data = bytes.data() + offset(random);
+                auto length = size(random);
+                auto initial = start(random);
+
+                uint32_t expected = initial;
+                crc::GenerateBytewise(data, length, &expected);
+
+                uint32_t portable = initial;
+                crc::GeneratePortable(data, length, &portable);
+
+                uint32_t actual = initial;
+                crc::Generate(data, length, &actual);
+
+                REQUIRE(portable == expected);
+                REQUIRE(actual == expected);
+            }
+        }
+    }
+
+    GIVEN("a null buffer") {
+        THEN("a single zero byte is folded in, as before") {
+            uint32_t expected = 0x123456;
+            const char zero[1] = { 0 };
+            crc::GenerateBytewise(zero, 1, &expected);
+
+            uint32_t actual = 0x123456;
+            crc::Generate(nullptr, 10, &actual);
+            REQUIRE(actual == expected);
+        }
+    }
+
+    GIVEN("a module followed by its CRC complement") {
+        // The first byte of the CRC field is covered as a zero.
+        auto module = RandomBytes(1000, random) + '\0';
+
+        uint32_t crc = -1;
+        crc::Generate(module.data(), module.size(), &crc);
+        crc = ~crc;
+        module += static_cast<char>(crc >> 16U);
+        module += static_cast<char>(crc >> 8U);
+        module += static_cast<char>(crc);
+
+        THEN("the CRC over everything is the OS-9 check value") {
+            uint32_t check = -1;
+            crc::Generate(module.data(), module.size(), &check);
+            REQUIRE((check & 0xffffffU) == 0x800fe3U);
+        }
+    }
+}
+
+SCENARIO("Module CRCs are combined and generated in parallel", "[module]") {
+    std::mt19937 random(0x0F0E);
+
+    GIVEN("a CRC and a run of zero bytes") {
+        std::string zeros(100003, '\0');
+
+        THEN("shifting the CRC matches generating over the zeros") {
+            uint32_t expected = 0x00abcdef;
+            crc::Generate(zeros.data(), zeros.size(), &expected);
+
+            uint32_t actual = 0x00abcdef;
+            crc::ShiftZeros(zeros.size(), &actual);
+            REQUIRE(actual == expected);
+        }
+    }
+
+    GIVEN("a buffer split in two") {
+        auto bytes = RandomBytes(5000, random);
+
+        THEN("the CRCs of the halves combine to the CRC of the whole") {
+            for (std::size_t split : { 0, 1, 7, 2500, 4999, 5000 }) {
+                uint32_t expected = -1;
+                crc::Generate(bytes.data(), bytes.size(), &expected);
+
+                uint32_t first = -1;
+                crc::Generate(bytes.data(), split, &first);
+                uint32_t second = 0;
+                crc::Generate(bytes.data() + split, bytes.size() - split, &second);
+
+                REQUIRE(crc::Combine(first, second, bytes.size() - split) == expected);
+            }
+        }
+    }
+
+    GIVEN("a buffer above the parallel threshold") {
+        auto bytes = RandomBytes(crc::ParallelThreshold * 2 + 12345, random);
+
+        THEN("generating it in parallel matches generating it serially") {
+            uint32_t expected = 0x00123456;
+            crc::Generate(bytes.data(), bytes.size(), &expected);
+
+            for (unsigned int workers : { 1, 2, 3, 8 }) {
+                uint32_t actual = 0x00123456;
+                crc::GenerateParallel(bytes.data(), bytes.size(), &actual, workers);
+                REQUIRE(actual == expected);
+            }
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include <catch2/catch.hpp>
+
+#include "ModuleHelpers.h"
+
+#include <MappedFile.h>
+#include <Module.hpp>
+#include <ModuleHeaderView.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace module {
+
+SCENARIO("Modules are read in place", "[module]") {
+    auto bytes = MakeModule(256);
+
+    GIVEN("a buffer holding a module") {
+        WHEN("the module is viewed without copying") {
+            Module module(bytes.data(), bytes.size());
+
+            THEN("its header and contents are read from the buffer") {
+                REQUIRE(module.GetHeader()->Size() == 256);
+                REQUIRE(module.GetName() == "demo");
+                REQUIRE(module.IsBigEndian());
+                REQUIRE(module.IsHeaderValid());
+                REQUIRE(module.IsCrcValid());
+            }
+        }
+
+        WHEN("the buffer is shorter than the module claims") {
+            THEN("the module is rejected") {
+                REQUIRE_THROWS_AS(Module(bytes.data(), bytes.size() - 1), std::runtime_error);
+                REQUIRE_THROWS_AS(Module(bytes.data(), sizeof(ModuleHeader) - 1), std::runtime_error);
+            }
+        }
+
+        WHEN("the sync bytes are unknown") {
+            bytes[0] = 0;
+
+            THEN("the module is rejected") {
+                REQUIRE_THROWS_AS(Module(bytes.data(), bytes.size()), std::runtime_error);
+            }
+        }
+    }
+
+    GIVEN("a file holding a module followed by other data") {
+        auto path = std::filesystem::temp_directory_path() / ("module-test-" + std::to_string(getpid()));
+        std::ofstream(path, std::ios::binary) << bytes << "trailing";
+
+        WHEN("the file is mapped") {
+            Module module(support::MappedFile(path.string()));
+
+            THEN("the module is read from the mapping, which it keeps alive") {
+                REQUIRE(module.GetHeader()->Size() == 256);
+                REQUIRE(module.GetName() == "demo");
+                REQUIRE(module.IsCrcValid());
+            }
+        }
+
+        WHEN("the file is checked") {
+            auto check = CheckModuleFile(support::MappedFile(path.string()));
+
+            THEN("the module is described and found valid") {
+                REQUIRE(check.name == "demo");
+                REQUIRE(check.size == 256);
+                REQUIRE(check.header_valid);
+                REQUIRE(check.crc_valid);
+            }
+        }
+
+        WHEN("the file is checked through a descriptor, which is left open") {
+            int fd = open(path.c_str(), O_RDONLY);
+            auto check = CheckModuleFile(support::MappedFile(fd, path.string()));
+
+            THEN("the module is found valid, and the descriptor still reads the file") {
+                char sync = 0;
+                REQUIRE(check.crc_valid);
+                REQUIRE(pread(fd, &sync, 1, 0) == 1);
+                REQUIRE(sync == 0x4D);
+            }
+
+            close(fd);
+        }
+
+        std::filesystem::remove(path);
+    }
+}
+
+SCENARIO("Header fields are decoded in place", "[module]") {
+    GIVEN("a big endian module") {
+        auto bytes = MakeModule(256);
+        bytes[23] = 7;
+        Module module(bytes.data(), bytes.size());
+
+        THEN("the view agrees with the deserialized header") {
+            auto& view = module.GetHeaderView();
+            auto header = module.GetHeader();
+
+            REQUIRE(view.GetEndian() == support::Endian::big);
+            REQUIRE(view.SyncBytes() == header->SyncBytes());
+            REQUIRE(view.Size() == header->Size());
+            REQUIRE(view.OffsetToName() == header->OffsetToName());
+            REQUIRE(view.Edition() == header->Edition());
+            REQUIRE(view.Edition() == 7);
+            REQUIRE(view.LinkIdent() == header->LinkIdent());
+            REQUIRE(view.Parity() == header->Parity());
+        }
+    }
+
+    GIVEN("a little endian module") {
+        std::string bytes(256, '\0');
+        bytes[0] = static_cast<char>(0xFC);
+        bytes[1] = static_cast<char>(0x4A);
+        bytes[5] = 1;
+        bytes[22] = 7;
+        ModuleHeaderView view(bytes.data(), bytes.size());
+
+        THEN("its fields are decoded as little endian") {
+            REQUIRE(view.GetEndian() == support::Endian::little);
+            REQUIRE(view.SyncBytes() == 0x4AFC);
+            REQUIRE(view.Size() == 256);
+            REQUIRE(view.Edition() == 7);
+            REQUIRE(Module(bytes.data(), bytes.size()).GetHeader()->Size() == 256);
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+#include <catch2/catch.hpp>
+
+#include "ModuleHelpers.h"
+
+#include <Module.hpp>
+#include <ModulePatcher.hpp>
+
+#include <random>
+#include <string>
+
+namespace module {
+
+SCENARIO("Modules are patched in place", "[module]") {
+    std::mt19937 random(0xF1);
+    std::uniform_int_distribution<int> byte(0, 255);
+    auto module = MakeModule(4096, "patched", [&]() { return static_cast<char>(byte(random)); });
+
+    auto is_crc_valid = [&module]() { return Module(module.data(), module.size()).IsCrcValid(); };
+    auto is_parity_valid = [&module]() { return Module(module.data(), module.size()).IsHeaderValid(); };
+
+    GIVEN("a module with a valid CRC and parity") {
+        REQUIRE(is_crc_valid());
+        REQUIRE(is_parity_valid());
+
+        WHEN("header fields and data bytes are patched") {
+            ModulePatcher patcher(module.data(), module.size());
+            patcher.SetEdition(42);
+            patcher.SetMinStackSize(0x2000);
+            patcher.SetAttributesRevision(0x8001);
+            patcher.Write(1000, "patched", 7);
+            patcher.Write(1003, "PATCH", 5);
+            auto complement = patcher.Commit();
+
+            THEN("the CRC and parity are valid, and match a full rebuild") {
+                REQUIRE(module[23] == 42);
+                REQUIRE(module.substr(1000, 8) == "patPATCH");
+                REQUIRE(is_crc_valid());
+                REQUIRE(is_parity_valid());
+
+                auto rebuilt = module;
+                REQUIRE(ModulePatcher(rebuilt.data(), rebuilt.size()).Rebuild() == complement);
+                REQUIRE(rebuilt == module);
+            }
+        }
+
+        WHEN("bytes right before the CRC are patched") {
+            ModulePatcher patcher(module.data(), module.size());
+            patcher.Write(module.size() - 5, "x", 1);
+            patcher.Commit();
+
+            THEN("the CRC is valid") {
+                REQUIRE(is_crc_valid());
+            }
+        }
+
+        THEN("the CRC field and the module size can't be patched") {
+            ModulePatcher patcher(module.data(), module.size());
+            REQUIRE_THROWS_AS(patcher.Write(module.size() - 4, "x", 1), std::out_of_range);
+            REQUIRE_THROWS_AS(patcher.Write(module.size() - 5, "xy", 2), std::out_of_range);
+            REQUIRE_THROWS_AS(patcher.Write(6, "x", 1), std::out_of_range);
+        }
+    }
+
+    GIVEN("a module whose header claims more bytes than there are") {
+        THEN("it's rejected") {
+            REQUIRE_THROWS(ModulePatcher(module.data(), module.size() - 1));
+        }
+    }
+}
+
+}
\ No newline at end of file
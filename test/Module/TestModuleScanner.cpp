@@ -0,0 +1,90 @@
+#include <catch2/catch.hpp>
+
+#include "ModuleHelpers.h"
+
+#include <ModuleScanner.hpp>
+
+#include <random>
+#include <string>
+
+namespace module {
+
+SCENARIO("Sync bytes are found at any offset", "[module]") {
+    GIVEN("random data with sync bytes planted at every alignment") {
+        std::mt19937 random(0x5CA9);
+        std::uniform_int_distribution<int> byte(0, 255);
+
+        std::string data(4096, '\0');
+        for (auto& c : data) c = static_cast<char>(byte(random));
+        for (std::size_t i = 0; i < 64; i++) {
+            auto offset = i * 61 + i % 16;
+            data[offset] = static_cast<char>(0x4A);
+            data[offset + 1] = static_cast<char>(0xFC);
+        }
+
+        THEN("FindSyncBytes agrees with the portable search everywhere") {
+            for (std::size_t from = 0; from < data.size(); from++) {
+                REQUIRE(FindSyncBytes(data.data(), data.size(), from)
+                    == FindSyncBytesPortable(data.data(), data.size(), from));
+            }
+        }
+
+        THEN("sync bytes split by the end of the data aren't found") {
+            data[data.size() - 1] = static_cast<char>(0x4D);
+            auto from = data.size() - 1;
+            REQUIRE(FindSyncBytes(data.data(), data.size(), from) == data.size());
+        }
+    }
+}
+
+SCENARIO("Modules are found within an image", "[module]") {
+    GIVEN("modules separated by padding, and a false candidate") {
+        auto first = MakeModule(200, "first", '\x11');
+        auto second = MakeModule(300, "second", '\x11');
+
+        // Sync bytes without a valid header in front of them.
+        std::string padding(37, '\0');
+        padding[5] = static_cast<char>(0xFC);
+        padding[6] = static_cast<char>(0x4A);
+
+        auto image = padding + first + second + padding;
+
+        WHEN("the image is scanned") {
+            auto modules = ScanImage(image.data(), image.size());
+
+            THEN("each module is found at its offset, with a valid CRC") {
+                REQUIRE(modules.size() == 2);
+                REQUIRE(modules[0].offset == padding.size());
+                REQUIRE(modules[0].size == first.size());
+                REQUIRE(modules[0].name == "first");
+                REQUIRE(modules[0].crc_valid);
+                REQUIRE(modules[1].offset == padding.size() + first.size());
+                REQUIRE(modules[1].name == "second");
+                REQUIRE(modules[1].crc_valid);
+            }
+        }
+
+        WHEN("a module's contents are corrupted") {
+            image[padding.size() + first.size() + 150] ^= 1;
+            auto modules = ScanImage(image.data(), image.size());
+
+            THEN("it's still found, but its CRC is invalid") {
+                REQUIRE(modules.size() == 2);
+                REQUIRE(modules[0].crc_valid);
+                REQUIRE_FALSE(modules[1].crc_valid);
+            }
+        }
+
+        WHEN("the image ends partway through a module") {
+            image.resize(padding.size() + first.size() + 100);
+            auto modules = ScanImage(image.data(), image.size());
+
+            THEN("only the whole module is found") {
+                REQUIRE(modules.size() == 1);
+                REQUIRE(modules[0].name == "first");
+            }
+        }
+    }
+}
+
+}
\ No newline at end of file
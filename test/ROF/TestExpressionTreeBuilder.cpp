@@ -0,0 +1,71 @@
+#include <catch2/catch.hpp>
+
+#include <Expression.h>
+#include <ExpressionTreeBuilder.h>
+#include <ObjectFile.h>
+#include <Rof15ObjectFile.h>
+
+#include <memory>
+#include <string>
+#include <variant>
+
+namespace rof {
+
+using namespace expression;
+
+namespace {
+std::unique_ptr<Expression> Sum(const std::string& left, const std::string& right) {
+    return std::make_unique<AdditionExpression>(
+        std::make_unique<ReferenceExpression>(left),
+        std::make_unique<ReferenceExpression>(right));
+}
+
+ExpressionRef RefOperand(const ExpressionTreeOperand& operand) {
+    auto& subtree = std::get<std::unique_ptr<ExpressionTree>>(operand);
+    REQUIRE(subtree->op == ExpressionOperator::Reference);
+    return std::get<ExpressionRef>(subtree->operand1);
+}
+}
+
+SCENARIO("External references are assigned indices in first-seen order", "[rof]") {
+    GIVEN("an object file with a single local symbol") {
+        object::ObjectFile object_file {};
+        object_file.psect.symbols["local"] = object::SymbolInfo { object::SymbolInfo::Type::Code, false, 0x20 };
+
+        ExternRefTable extern_refs {};
+
+        WHEN("trees referencing external names are built") {
+            ExpressionTreeBuilder first_builder(object_file, extern_refs);
+            auto first = first_builder.Build(*Sum("beta", "alpha"));
+
+            ExpressionTreeBuilder second_builder(object_file, extern_refs);
+            auto second = second_builder.Build(*Sum("alpha", "local"));
+
+            ExpressionTreeBuilder third_builder(object_file, extern_refs);
+            auto third = third_builder.Build(*Sum("gamma", "beta"));
+
+            THEN("each distinct name is recorded once, in the order it was first referenced") {
+                REQUIRE(extern_refs.Size() == 3);
+                REQUIRE(extern_refs.Names()[0] == "beta");
+                REQUIRE(extern_refs.Names()[1] == "alpha");
+                REQUIRE(extern_refs.Names()[2] == "gamma");
+            }
+
+            THEN("references reuse the index of a previously seen name") {
+                REQUIRE(RefOperand(first->operand1).Value() == 0);
+                REQUIRE(RefOperand(first->operand2).Value() == 1);
+                REQUIRE(RefOperand(second->operand1).Value() == 1);
+                REQUIRE(RefOperand(third->operand1).Value() == 2);
+                REQUIRE(RefOperand(third->operand2).Value() == 0);
+            }
+
+            THEN("local symbols are not added to the table") {
+                auto local = RefOperand(second->operand2);
+                REQUIRE(local.Value() == 0x20);
+                REQUIRE((local.Flags() & LocalReferenceFlag) != 0);
+            }
+        }
+    }
+}
+
+}
\ No newline at end of file
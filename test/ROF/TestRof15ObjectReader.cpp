@@ -0,0 +1,166 @@
+#include <catch2/catch.hpp>
+
+#include <Rof15ObjectFile.h>
+#include <Rof15ObjectReader.h>
+#include <Rof15ObjectWriter.h>
+
+#include <Expression.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace rof {
+
+namespace {
+object::MemoryValue Word(uint32_t value) {
+    object::MemoryValue memory {};
+    memory.size = 4;
+    memory.data.u32 = value;
+    return memory;
+}
+
+std::string WriteRof(const object::ObjectFile& object_file) {
+    std::stringstream out;
+    Rof15ObjectWriter().Write(object_file, out);
+    return out.str();
+}
+}
+
+SCENARIO("ROF sections are read back in place", "[rof]") {
+    using namespace expression;
+
+    GIVEN("a ROF written from an ObjectFile with definitions, data and references") {
+        object::ObjectFile object_file {};
+        object_file.name = "reader";
+        object_file.cpu_target = object::CpuTarget::os9k_mips;
+        object_file.endian = support::Endian::big;
+        object_file.edition = 7;
+        object_file.assembly_time = 0;
+
+        object_file.psect.symbols["entry"] = object::SymbolInfo { object::SymbolInfo::Type::Code, true, 4 };
+        object_file.psect.symbols["table"] = object::SymbolInfo { object::SymbolInfo::Type::InitData, true, 0 };
+
+        auto code = Word(0x3c080000);
+        code.expr_mappings.emplace_back(0, 16, false, std::make_shared<HiExpression>(nullptr,
+            std::make_unique<AdditionExpression>(
+                std::make_unique<ReferenceExpression>("external"),
+                std::make_unique<NumericConstantExpression>(8))));
+        object_file.psect.code_data[0] = code;
+        object_file.psect.code_data[4] = Word(0x03e00008);
+        object_file.counter.code = 8;
+
+        auto data = Word(0);
+        data.expr_mappings.emplace_back(0, 32, false, std::make_shared<ReferenceExpression>("entry"));
+        object_file.psect.initialized_data[0] = data;
+        object_file.counter.initialized_data = 4;
+
+        auto rof_bytes = WriteRof(object_file);
+
+        WHEN("the ROF is read from memory") {
+            Rof15ObjectReader reader(rof_bytes.data(), rof_bytes.size());
+
+            THEN("the header is decoded in the endian of the target CPU") {
+                auto header = reader.Header();
+                REQUIRE(reader.Endian() == support::Endian::big);
+                REQUIRE(header.TargetCPU() == 0x800);
+                REQUIRE(header.Edition() == 7);
+                REQUIRE(header.CodeSize() == 8);
+                REQUIRE(header.InitializedDataSize() == 4);
+                REQUIRE(header.Name() == "reader");
+                REQUIRE(reader.Size() == rof_bytes.size());
+            }
+
+            THEN("external definitions are visited in order") {
+                auto defs = reader.ExternDefinitions();
+                REQUIRE(defs.Count() == 2);
+
+                auto itr = defs.begin();
+                REQUIRE((*itr).name == "entry");
+                REQUIRE((*itr).type == static_cast<uint16_t>(DefinitionType::Code));
+                REQUIRE((*itr).symbol_value == 4);
+                ++itr;
+                REQUIRE((*itr).name == "table");
+                REQUIRE(++itr == defs.end());
+            }
+
+            THEN("sections refer to the ROF's own memory") {
+                auto code_section = reader.Code();
+                REQUIRE(code_section.size() == 8);
+                REQUIRE(code_section.data() > rof_bytes.data());
+                REQUIRE(code_section.data() < rof_bytes.data() + rof_bytes.size());
+                REQUIRE(static_cast<uint8_t>(code_section[0]) == 0x3c);
+                REQUIRE(static_cast<uint8_t>(code_section[7]) == 0x08);
+
+                REQUIRE(reader.InitializedData().size() == 4);
+                REQUIRE(reader.RemoteInitializedData().empty());
+            }
+
+            THEN("extern refs, trees and references decode") {
+                auto refs = reader.ExternRefs();
+                REQUIRE(refs.Count() == 1);
+                REQUIRE(*refs.begin() == "external");
+
+                REQUIRE(reader.ExpressionTrees().Count() == 2);
+
+                auto references = reader.References();
+                REQUIRE(references.Count() == 2);
+                REQUIRE(references.At(0).FieldLength() == 16);
+                REQUIRE(references.At(1).FieldLength() == 32);
+
+                auto hi = reader.ExpressionTreeAt(references.At(0).ExprTreeIndex());
+                REQUIRE(hi.Op() == ExpressionOperator::Hi);
+                REQUIRE(hi.SubtreeCount() == 1);
+
+                auto sum = hi.Operand1();
+                REQUIRE(sum.Op() == ExpressionOperator::Addition);
+                REQUIRE(sum.Operand1().Op() == ExpressionOperator::Reference);
+                REQUIRE(sum.Operand1().Ref().Value() == 0);
+                REQUIRE(sum.Operand2().Value() == 8);
+
+                auto local = reader.ExpressionTreeAt(references.At(1).ExprTreeIndex()).Decode();
+                REQUIRE(local->op == ExpressionOperator::Reference);
+                auto& ref = std::get<ExpressionRef>(local->operand1);
+                REQUIRE((ref.Flags() & LocalReferenceFlag) != 0);
+                REQUIRE(ref.Value() == 4);
+            }
+        }
+
+        WHEN("the ROF is read from a file") {
+            auto path = (std::filesystem::temp_directory_path() / "test-rof15-object-reader.r").string();
+            std::ofstream(path, std::ios::binary) << rof_bytes;
+
+            Rof15ObjectReader reader(path);
+            auto name = reader.Header().Name();
+            auto tree_count = reader.ExpressionTrees().Count();
+            std::remove(path.c_str());
+
+            THEN("it decodes the same as from memory") {
+                REQUIRE(name == "reader");
+                REQUIRE(tree_count == 2);
+            }
+        }
+
+        WHEN("the ROF is truncated") {
+            Rof15ObjectReader reader(rof_bytes.data(), rof_bytes.size() - 3);
+
+            THEN("reading past the end throws") {
+                REQUIRE_NOTHROW(reader.Code());
+                REQUIRE_THROWS_AS(reader.References(), std::runtime_error);
+            }
+        }
+    }
+
+    GIVEN("bytes which are not a ROF") {
+        std::string garbage(128, 'x');
+
+        THEN("the reader rejects them") {
+            REQUIRE_THROWS_AS(Rof15ObjectReader(garbage.data(), garbage.size()), std::runtime_error);
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -6,8 +6,12 @@
 #include <Rof15ObjectWriter.h>
 #include <Serialization.h>
 
+#include <Expression.h>
+
 #include <chrono>
+#include <memory>
 #include <sstream>
+#include <string>
 
 namespace rof {
 
@@ -83,4 +87,64 @@ SCENARIO("ROF header is written correctly", "[serializer][rof]") {
     }
 }
 
+SCENARIO("Parallel reference generation matches the serial writer", "[rof]") {
+
+    GIVEN("an ObjectFile with many expression mappings across its sections") {
+        using namespace expression;
+
+        object::ObjectFile object_file {};
+        object_file.name = "many_refs";
+        object_file.cpu_target = object::CpuTarget::os9k_mips;
+        object_file.endian = support::Endian::big;
+        object_file.assembly_time = 0;
+
+        // Reference a mix of local symbols and external names, so that each chunk sees both
+        // names first seen in an earlier chunk and names of its own.
+        object_file.psect.symbols["local"] = object::SymbolInfo { object::SymbolInfo::Type::Code, false, 0 };
+        auto make_expression = [](std::size_t i) -> std::shared_ptr<Expression> {
+            auto external = std::make_unique<ReferenceExpression>("ext" + std::to_string((i * 7) % 61));
+            if (i % 3 == 0) {
+                return std::make_shared<AdditionExpression>(std::move(external), std::make_unique<ReferenceExpression>("local"));
+            }
+
+            if (i % 3 == 1) {
+                return std::make_shared<HiExpression>(nullptr, std::move(external));
+            }
+
+            return std::make_shared<SubtractionExpression>(std::move(external),
+                std::make_unique<ReferenceExpression>("late" + std::to_string(i / 500)));
+        };
+
+        auto fill = [&make_expression](auto& data_map, std::size_t count, std::size_t& counter, std::size_t& next) {
+            for (std::size_t i = 0; i < count; i++) {
+                object::MemoryValue value {};
+                value.size = 4;
+                value.data.u32 = i;
+                value.expr_mappings.emplace_back(0, 16, i % 2 == 0, make_expression(next++));
+
+                data_map[counter] = std::move(value);
+                counter += 4;
+            }
+        };
+
+        std::size_t next = 0;
+        fill(object_file.psect.code_data, 3000, object_file.counter.code, next);
+        fill(object_file.psect.initialized_data, 700, object_file.counter.initialized_data, next);
+        fill(object_file.psect.remote_initialized_data, 300, object_file.counter.remote_initialized_data, next);
+
+        WHEN("the ROF is written serially and in parallel") {
+            std::stringstream serial_out;
+            Rof15ObjectWriter().Write(object_file, serial_out);
+
+            std::stringstream parallel_out;
+            Rof15ObjectWriter(8).Write(object_file, parallel_out);
+
+            THEN("the output is byte-identical") {
+                REQUIRE(serial_out.str().size() > 0);
+                REQUIRE(serial_out.str() == parallel_out.str());
+            }
+        }
+    }
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,110 @@
+#include <catch2/catch.hpp>
+
+#include <Rof15ObjectReader.h>
+#include <Rof15ObjectWriter.h>
+#include <RofArchive.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace rof {
+
+namespace {
+std::string MakeRof(const std::string& name, const std::vector<std::string>& definitions) {
+    object::ObjectFile object_file {};
+    object_file.name = name;
+    object_file.cpu_target = object::CpuTarget::os9k_mips;
+    object_file.endian = support::Endian::big;
+    object_file.assembly_time = 0;
+
+    uint32_t value = 0;
+    for (auto& definition : definitions) {
+        object_file.psect.symbols[definition] = object::SymbolInfo { object::SymbolInfo::Type::Code, true, value += 4 };
+    }
+
+    std::stringstream out;
+    Rof15ObjectWriter().Write(object_file, out);
+    return out.str();
+}
+
+std::string WriteArchive(const RofArchiveWriter& writer) {
+    std::stringstream out;
+    writer.Write(out);
+    return out.str();
+}
+}
+
+SCENARIO("ROF archives index the definitions of their members", "[rof][archive]") {
+
+    GIVEN("an archive of two ROFs") {
+        RofArchiveWriter writer {};
+        writer.AddMember("strings.r", MakeRof("strings", { "strlen", "strcpy", "memcpy" }), 42);
+        writer.AddMember("math.r", MakeRof("math", { "abs", "div", "memcpy" }));
+
+        auto bytes = WriteArchive(writer);
+        RofArchive archive(bytes.data(), bytes.size());
+
+        THEN("the members are stored in order, intact") {
+            REQUIRE(archive.MemberCount() == 2);
+            REQUIRE(archive.Member(0).name == "strings.r");
+            REQUIRE(archive.Member(0).modification_time == 42);
+            REQUIRE(archive.Member(1).name == "math.r");
+            REQUIRE(archive.OpenMember(1)->Header().Name() == "math");
+            REQUIRE(archive.FindMember("math.r") == 1U);
+            REQUIRE_FALSE(archive.FindMember("missing.r"));
+        }
+
+        THEN("symbols are found in the index") {
+            REQUIRE(archive.SymbolCount() == 5);
+            REQUIRE(archive.FindSymbol("strcpy") == 0U);
+            REQUIRE(archive.FindSymbol("div") == 1U);
+            REQUIRE(archive.FindSymbol("abs") == 1U);
+            REQUIRE_FALSE(archive.FindSymbol("printf"));
+            REQUIRE_FALSE(archive.FindSymbol("str"));
+        }
+
+        THEN("a symbol defined by several members refers to the first") {
+            REQUIRE(archive.FindSymbol("memcpy") == 0U);
+        }
+
+        THEN("the index is sorted") {
+            for (uint32_t i = 1; i < archive.SymbolCount(); i++) {
+                REQUIRE(archive.Symbol(i - 1).name < archive.Symbol(i).name);
+            }
+        }
+
+        WHEN("a member is replaced") {
+            RofArchiveWriter updated {};
+            updated.AddMembers(archive);
+            updated.AddMember("strings.r", MakeRof("strings", { "strcat" }));
+
+            auto updated_bytes = WriteArchive(updated);
+            RofArchive updated_archive(updated_bytes.data(), updated_bytes.size());
+
+            THEN("it keeps its position and its symbols are reindexed") {
+                REQUIRE(updated_archive.MemberCount() == 2);
+                REQUIRE(updated_archive.Member(0).name == "strings.r");
+                REQUIRE(updated_archive.FindSymbol("strcat") == 0U);
+                REQUIRE_FALSE(updated_archive.FindSymbol("strlen"));
+                REQUIRE(updated_archive.FindSymbol("memcpy") == 1U);
+            }
+        }
+
+        WHEN("the archive is truncated") {
+            THEN("opening it fails") {
+                REQUIRE_THROWS_AS(RofArchive(bytes.data(), 40), std::runtime_error);
+            }
+        }
+    }
+
+    GIVEN("a member which is not a ROF") {
+        RofArchiveWriter writer {};
+
+        THEN("it is rejected") {
+            REQUIRE_THROWS_AS(writer.AddMember("junk.r", std::string(100, 'x')), std::runtime_error);
+        }
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#include <catch2/catch.hpp>
+
+#include <FileCopy.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace support {
+
+namespace {
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents {};
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+std::string Describe(CopyMethod method) {
+    switch (method) {
+        case CopyMethod::CopyFileRange: return "copy_file_range";
+        case CopyMethod::SendFile: return "sendfile";
+        case CopyMethod::Buffered: return "a buffered copy";
+    }
+    return {};
+}
+}
+
+SCENARIO("File ranges are copied between offsets", "[support]") {
+    auto directory = std::filesystem::temp_directory_path() / ("file-copy-test-" + std::to_string(getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    // Larger than the buffered copy's buffer, so it takes several reads.
+    std::string source(3U << 20U, '\0');
+    for (std::size_t i = 0; i < source.size(); i++) {
+        source[i] = static_cast<char>(i * 7 + i / 251);
+    }
+    std::ofstream(directory / "in", std::ios::binary) << source;
+
+    auto method = GENERATE(CopyMethod::CopyFileRange, CopyMethod::SendFile, CopyMethod::Buffered);
+
+    GIVEN("an input and an output which already holds data, starting with " + Describe(method)) {
+        std::ofstream(directory / "out", std::ios::binary) << std::string(16, 'x');
+
+        int in = open((directory / "in").c_str(), O_RDONLY);
+        int out = open((directory / "out").c_str(), O_RDWR);
+        REQUIRE(in >= 0);
+        REQUIRE(out >= 0);
+        REQUIRE(lseek(in, 11, SEEK_SET) == 11);
+        REQUIRE(lseek(out, 3, SEEK_SET) == 3);
+
+        WHEN("a range is copied from a nonzero offset to one past the output's end") {
+            const off_t in_offset = 1000;
+            const off_t out_offset = 100;
+            const std::size_t count = source.size() - 2000;
+
+            CopyFileRange(in, in_offset, out, out_offset, count, method);
+
+            THEN("the range lands at the offset, after a hole, and the rest is untouched") {
+                auto copied = ReadFile(directory / "out");
+                REQUIRE(copied.size() == out_offset + count);
+                REQUIRE(copied.substr(0, 16) == std::string(16, 'x'));
+                REQUIRE(copied.substr(16, out_offset - 16) == std::string(out_offset - 16, '\0'));
+                REQUIRE(copied.substr(out_offset) == source.substr(in_offset, count));
+            }
+
+            THEN("neither descriptor's position moves") {
+                REQUIRE(lseek(in, 0, SEEK_CUR) == 11);
+                REQUIRE(lseek(out, 0, SEEK_CUR) == 3);
+            }
+        }
+
+        WHEN("more is requested than the input holds past the offset") {
+            THEN("the copy fails at the end of the input") {
+                REQUIRE_THROWS_WITH(CopyFileRange(in, source.size() - 10, out, 4, 20, method),
+                    Catch::Contains("unexpected end of file"));
+            }
+        }
+
+        WHEN("nothing is requested") {
+            CopyFileRange(in, 0, out, 4, 0, method);
+
+            THEN("the output is unchanged") {
+                REQUIRE(ReadFile(directory / "out") == std::string(16, 'x'));
+            }
+        }
+
+        close(in);
+        close(out);
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+}
\ No newline at end of file
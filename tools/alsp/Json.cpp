@@ -0,0 +1,312 @@
+#include "Json.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+
+namespace alsp::json {
+
+namespace {
+
+// Guards parsing against stack exhaustion from deeply nested input.
+constexpr unsigned int MaxDepth = 256;
+
+class Parser {
+public:
+    explicit Parser(std::string_view text) : text(text) {}
+
+    Value ParseDocument() {
+        auto value = ParseValue(0);
+        SkipWhitespace();
+        if (position != text.size()) Fail("unexpected text after value");
+        return value;
+    }
+
+private:
+    [[noreturn]] void Fail(const std::string& what) const {
+        throw std::runtime_error("Malformed JSON at " + std::to_string(position) + ": " + what + ".");
+    }
+
+    void SkipWhitespace() {
+        while (position < text.size() && (text[position] == ' ' || text[position] == '\t'
+            || text[position] == '\n' || text[position] == '\r')) {
+            position++;
+        }
+    }
+
+    bool Consume(char c) {
+        SkipWhitespace();
+        if (position < text.size() && text[position] == c) {
+            position++;
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(char c) {
+        if (!Consume(c)) Fail(std::string("expected '") + c + "'");
+    }
+
+    bool ConsumeWord(std::string_view word) {
+        if (text.substr(position, word.size()) == word) {
+            position += word.size();
+            return true;
+        }
+        return false;
+    }
+
+    Value ParseValue(unsigned int depth) {
+        if (depth > MaxDepth) Fail("too deeply nested");
+
+        SkipWhitespace();
+        if (position >= text.size()) Fail("expected a value");
+
+        switch (text[position]) {
+            case '{': return ParseObject(depth);
+            case '[': return ParseArray(depth);
+            case '"': return ParseString();
+            default: break;
+        }
+
+        if (ConsumeWord("true")) return true;
+        if (ConsumeWord("false")) return false;
+        if (ConsumeWord("null")) return nullptr;
+        return ParseNumber();
+    }
+
+    Value ParseObject(unsigned int depth) {
+        Expect('{');
+        auto object = Value::Object();
+        if (Consume('}')) return object;
+
+        do {
+            SkipWhitespace();
+            if (position >= text.size() || text[position] != '"') Fail("expected a member name");
+            auto name = ParseString();
+            Expect(':');
+            object[name] = ParseValue(depth + 1);
+        } while (Consume(','));
+
+        Expect('}');
+        return object;
+    }
+
+    Value ParseArray(unsigned int depth) {
+        Expect('[');
+        auto array = Value::Array();
+        if (Consume(']')) return array;
+
+        do {
+            array.Push(ParseValue(depth + 1));
+        } while (Consume(','));
+
+        Expect(']');
+        return array;
+    }
+
+    uint32_t ParseHex4() {
+        if (text.size() - position < 4) Fail("truncated escape");
+        uint32_t code = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = text[position++];
+            code <<= 4U;
+            if (c >= '0' && c <= '9') code |= c - '0';
+            else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+            else Fail("invalid escape");
+        }
+        return code;
+    }
+
+    static void AppendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | code >> 6U));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3FU)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | code >> 12U));
+            out.push_back(static_cast<char>(0x80 | (code >> 6U & 0x3FU)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3FU)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | code >> 18U));
+            out.push_back(static_cast<char>(0x80 | (code >> 12U & 0x3FU)));
+            out.push_back(static_cast<char>(0x80 | (code >> 6U & 0x3FU)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3FU)));
+        }
+    }
+
+    std::string ParseString() {
+        position++;
+
+        std::string out {};
+        while (true) {
+            if (position >= text.size()) Fail("unterminated string");
+
+            char c = text[position++];
+            if (c == '"') return out;
+            if (c != '\\') {
+                out.push_back(c);
+                continue;
+            }
+
+            if (position >= text.size()) Fail("unterminated string");
+            switch (text[position++]) {
+                case '"': out.push_back('"'); break;
+                case '\\': out.push_back('\\'); break;
+                case '/': out.push_back('/'); break;
+                case 'b': out.push_back('\b'); break;
+                case 'f': out.push_back('\f'); break;
+                case 'n': out.push_back('\n'); break;
+                case 'r': out.push_back('\r'); break;
+                case 't': out.push_back('\t'); break;
+                case 'u': {
+                    auto code = ParseHex4();
+                    if (code >= 0xD800 && code < 0xDC00 && ConsumeWord("\\u")) {
+                        auto low = ParseHex4();
+                        code = 0x10000 + ((code - 0xD800) << 10U) + (low - 0xDC00);
+                    }
+                    AppendUtf8(out, code);
+                    break;
+                }
+                default:
+                    Fail("invalid escape");
+            }
+        }
+    }
+
+    Value ParseNumber() {
+        auto start = position;
+        while (position < text.size() && std::string_view("+-0123456789.eE").find(text[position]) != std::string_view::npos) {
+            position++;
+        }
+        if (start == position) Fail("expected a value");
+
+        std::string number(text.substr(start, position - start));
+        char* end = nullptr;
+        auto value = std::strtod(number.c_str(), &end);
+        if (end != number.c_str() + number.size()) Fail("invalid number");
+        return value;
+    }
+
+    std::string_view text;
+    std::size_t position = 0;
+};
+
+void DumpString(std::string& out, const std::string& string) {
+    out.push_back('"');
+    for (char c : string) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escape[8];
+                    std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+                    out += escape;
+                } else {
+                    out.push_back(c);
+                }
+        }
+    }
+    out.push_back('"');
+}
+
+const Value& Null() {
+    static const Value null {};
+    return null;
+}
+
+}
+
+Value Value::Parse(std::string_view text) {
+    return Parser(text).ParseDocument();
+}
+
+std::string Value::Dump() const {
+    std::string out {};
+    Dump(out);
+    return out;
+}
+
+void Value::Dump(std::string& out) const {
+    switch (type) {
+        case Type::Null:
+            out += "null";
+            break;
+        case Type::Bool:
+            out += boolean ? "true" : "false";
+            break;
+        case Type::Number:
+            // Protocol numbers are nearly all integers, e.g. ids and positions.
+            if (std::isfinite(number) && std::trunc(number) == number && std::fabs(number) < 1e15) {
+                out += std::to_string(static_cast<long long>(number));
+            } else {
+                char formatted[32];
+                std::snprintf(formatted, sizeof(formatted), "%.17g", std::isfinite(number) ? number : 0);
+                out += formatted;
+            }
+            break;
+        case Type::String:
+            DumpString(out, string);
+            break;
+        case Type::Array:
+            out.push_back('[');
+            for (std::size_t i = 0; i < items.size(); i++) {
+                if (i) out.push_back(',');
+                items[i].Dump(out);
+            }
+            out.push_back(']');
+            break;
+        case Type::Object:
+            out.push_back('{');
+            for (auto member = members.begin(); member != members.end(); ++member) {
+                if (member != members.begin()) out.push_back(',');
+                DumpString(out, member->first);
+                out.push_back(':');
+                member->second.Dump(out);
+            }
+            out.push_back('}');
+            break;
+    }
+}
+
+const Value& Value::operator[](const std::string& key) const {
+    if (type != Type::Object) return Null();
+
+    auto member = members.find(key);
+    return member != members.end() ? member->second : Null();
+}
+
+Value& Value::operator[](const std::string& key) {
+    if (type == Type::Null) type = Type::Object;
+    if (type != Type::Object) throw std::runtime_error("JSON value is not an object.");
+    return members[key];
+}
+
+void Value::Push(Value value) {
+    if (type == Type::Null) type = Type::Array;
+    if (type != Type::Array) throw std::runtime_error("JSON value is not an array.");
+    items.push_back(std::move(value));
+}
+
+bool Value::AsBool() const {
+    if (type != Type::Bool) throw std::runtime_error("Expected a JSON boolean.");
+    return boolean;
+}
+
+double Value::AsNumber() const {
+    if (type != Type::Number) throw std::runtime_error("Expected a JSON number.");
+    return number;
+}
+
+const std::string& Value::AsString() const {
+    if (type != Type::String) throw std::runtime_error("Expected a JSON string.");
+    return string;
+}
+
+}
\ No newline at end of file
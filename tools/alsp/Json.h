@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace alsp::json {
+
+/**
+ * A JSON value, just enough for the language server protocol.
+ */
+class Value {
+public:
+    enum class Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Value() = default;
+    Value(std::nullptr_t) {}
+    Value(bool value) : type(Type::Bool), boolean(value) {}
+    Value(const char* value) : type(Type::String), string(value) {}
+    Value(std::string value) : type(Type::String), string(std::move(value)) {}
+
+    template<typename T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    Value(T value) : type(Type::Number), number(static_cast<double>(value)) {}
+
+    static Value Array() { Value value {}; value.type = Type::Array; return value; }
+    static Value Object() { Value value {}; value.type = Type::Object; return value; }
+
+    /**
+     * Parse text, which must hold exactly one value. Throws std::runtime_error if it's malformed.
+     */
+    static Value Parse(std::string_view text);
+
+    std::string Dump() const;
+
+    Type GetType() const { return type; }
+    bool IsNull() const { return type == Type::Null; }
+    bool Has(const std::string& key) const { return type == Type::Object && members.count(key); }
+
+    // Members of objects. Missing members and members of other types are null.
+    const Value& operator[](const std::string& key) const;
+    Value& operator[](const std::string& key);
+
+    // Elements of arrays. Empty for other types.
+    const std::vector<Value>& Items() const { return items; }
+    void Push(Value value);
+
+    // Throw std::runtime_error if the value has another type.
+    bool AsBool() const;
+    double AsNumber() const;
+    const std::string& AsString() const;
+
+private:
+    void Dump(std::string& out) const;
+
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0;
+    std::string string {};
+    std::vector<Value> items {};
+    std::map<std::string, Value> members {};
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,616 @@
+#include "Json.h"
+
+#include <Driver.h>
+#include <EquSnapshot.h>
+#include <IncludeCache.h>
+#include <SourceIndex.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <poll.h>
+#include <unistd.h>
+
+using alsp::json::Value;
+
+namespace {
+
+// Guards against a corrupt header exhausting memory.
+constexpr std::size_t MaxMessageSize = 256 * 1024 * 1024;
+
+enum class ErrorCode {
+    ParseError = -32700,
+    InvalidRequest = -32600,
+    MethodNotFound = -32601,
+    InvalidParams = -32602,
+    InternalError = -32603
+};
+
+enum class SymbolKind {
+    Function = 12,
+    Variable = 13,
+    Constant = 14
+};
+
+struct Options {
+    std::vector<std::string> include_directories {};
+    std::vector<std::string> equ_paths {};
+
+    // How long edits must pause before a document is reassembled.
+    int settle_ms = 150;
+};
+
+[[noreturn]] void Usage(const std::string& error) {
+    std::cerr << error << std::endl;
+    std::cerr << "usage: alsp [options]" << std::endl
+              << "Serves the language server protocol on standard input and output." << std::endl
+              << "  -I <dir>          search <dir> for files named by use, after the document's directory" << std::endl
+              << "  --equ <snapshot>  define the equs in a snapshot made by amips --make-equ" << std::endl
+              << "  --settle <ms>     reassemble documents once edits pause for <ms> (default: 150)" << std::endl;
+    exit(1);
+}
+
+Options ParseArguments(int argc, const char* argv[]) {
+    Options options {};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) Usage("Missing value for " + arg + ".");
+            return argv[++i];
+        };
+
+        if (arg == "-I") {
+            options.include_directories.push_back(value());
+        } else if (arg.rfind("-I", 0) == 0) {
+            options.include_directories.push_back(arg.substr(2));
+        } else if (arg == "--equ") {
+            options.equ_paths.push_back(value());
+        } else if (arg == "--settle") {
+            try {
+                options.settle_ms = std::stoi(value());
+            } catch (std::exception const&) {
+                Usage("--settle must be a number.");
+            }
+        } else if (arg == "--stdio") {
+            // The only transport. Accepted because clients commonly pass it.
+        } else {
+            Usage("Unknown option: " + arg);
+        }
+    }
+
+    return options;
+}
+
+/**
+ * Messages framed by a Content-Length header, as the protocol sends them over stdio.
+ */
+class Connection {
+public:
+    /**
+     * The next message, or nothing if none arrived within timeout_ms (-1 to wait indefinitely)
+     * or the input was closed.
+     */
+    std::optional<std::string> Read(int timeout_ms) {
+        while (true) {
+            if (auto message = TakeMessage()) {
+                return message;
+            }
+
+            pollfd poll_fd { STDIN_FILENO, POLLIN, 0 };
+            auto ready = poll(&poll_fd, 1, timeout_ms);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready < 0) throw std::runtime_error(std::string("Failed to poll input: ") + std::strerror(errno));
+            if (ready == 0) return std::nullopt;
+
+            char chunk[64 * 1024];
+            auto count = read(STDIN_FILENO, chunk, sizeof(chunk));
+            if (count < 0 && errno == EINTR) continue;
+            if (count <= 0) {
+                closed = true;
+                return std::nullopt;
+            }
+
+            buffer.append(chunk, count);
+        }
+    }
+
+    void Write(const Value& message) {
+        auto body = message.Dump();
+        auto framed = "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+
+        std::size_t written = 0;
+        while (written < framed.size()) {
+            auto count = write(STDOUT_FILENO, framed.data() + written, framed.size() - written);
+            if (count < 0 && errno == EINTR) continue;
+            if (count < 0) throw std::runtime_error(std::string("Failed to write output: ") + std::strerror(errno));
+            written += count;
+        }
+    }
+
+    bool Closed() const { return closed; }
+
+private:
+    std::optional<std::string> TakeMessage() {
+        auto header_end = buffer.find("\r\n\r\n");
+        if (header_end == std::string::npos) return std::nullopt;
+
+        std::optional<std::size_t> length {};
+        std::istringstream headers(buffer.substr(0, header_end));
+        for (std::string header; std::getline(headers, header);) {
+            auto colon = header.find(':');
+            if (colon == std::string::npos) continue;
+
+            std::string name = header.substr(0, colon);
+            for (auto& c : name) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            if (name == "content-length") {
+                try {
+                    length = std::stoul(header.substr(colon + 1));
+                } catch (std::exception const&) {
+                    throw std::runtime_error("Malformed Content-Length header.");
+                }
+            }
+        }
+
+        if (!length || length.value() > MaxMessageSize) {
+            throw std::runtime_error("Missing or oversized Content-Length header.");
+        }
+
+        auto body_start = header_end + 4;
+        if (buffer.size() - body_start < length.value()) return std::nullopt;
+
+        auto message = buffer.substr(body_start, length.value());
+        buffer.erase(0, body_start + length.value());
+        return message;
+    }
+
+    std::string buffer {};
+    bool closed = false;
+};
+
+std::filesystem::path PathFromUri(const std::string& uri) {
+    constexpr std::string_view scheme = "file://";
+    if (uri.compare(0, scheme.size(), scheme) != 0) {
+        throw std::runtime_error("Only file URIs are supported: " + uri);
+    }
+
+    std::string path {};
+    for (std::size_t i = scheme.size(); i < uri.size(); i++) {
+        if (uri[i] == '%' && i + 2 < uri.size()) {
+            path.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+            i += 2;
+        } else {
+            path.push_back(uri[i]);
+        }
+    }
+
+    return path;
+}
+
+std::string UriFromPath(const std::filesystem::path& path) {
+    std::string uri = "file://";
+    for (unsigned char c : path.string()) {
+        if (std::isalnum(c) || std::strchr("/-._~", c)) {
+            uri.push_back(static_cast<char>(c));
+        } else {
+            char escape[4];
+            std::snprintf(escape, sizeof(escape), "%%%02X", c);
+            uri += escape;
+        }
+    }
+    return uri;
+}
+
+Value MakePosition(std::size_t line, std::size_t character) {
+    Value position {};
+    position["line"] = line;
+    position["character"] = character;
+    return position;
+}
+
+// A range over a 1-based line, or the first line if it's 0.
+Value MakeRange(std::size_t line, std::size_t start = 0, std::size_t end = 0) {
+    auto zero_based = line ? line - 1 : 0;
+
+    Value range {};
+    range["start"] = MakePosition(zero_based, start);
+    range["end"] = MakePosition(zero_based, end);
+    return range;
+}
+
+std::string Hex(uint32_t value) {
+    std::ostringstream out {};
+    out << "0x" << std::hex << value;
+    return out.str();
+}
+
+std::string DescribeCounter(object::SymbolInfo::Type type) {
+    switch (type) {
+        case object::SymbolInfo::Code: return "code";
+        case object::SymbolInfo::InitData: return "initialized data";
+        case object::SymbolInfo::UninitData: return "uninitialized data";
+        case object::SymbolInfo::RemoteInitData: return "remote initialized data";
+        case object::SymbolInfo::RemoteUninitData: return "remote uninitialized data";
+        default: return "";
+    }
+}
+
+bool IsSymbolCharacter(char c) {
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '@' || c == '$' || c == '.';
+}
+
+struct Document {
+    Document(const std::filesystem::path& path, driver::AssembleOptions options) : path(path), index(std::move(options)) {}
+
+    std::string_view Line(std::size_t line) const {
+        std::size_t start = 0;
+        for (std::size_t i = 0; i < line; i++) {
+            start = text.find('\n', start);
+            if (start == std::string::npos) return {};
+            start++;
+        }
+
+        auto end = text.find('\n', start);
+        return std::string_view(text).substr(start, end == std::string::npos ? std::string::npos : end - start);
+    }
+
+    // The symbol under a 0-based position, if any.
+    std::string SymbolAt(std::size_t line, std::size_t character) const {
+        auto text = Line(line);
+        if (character > text.size()) return {};
+
+        auto start = character;
+        while (start > 0 && IsSymbolCharacter(text[start - 1])) start--;
+        auto end = character;
+        while (end < text.size() && IsSymbolCharacter(text[end])) end++;
+
+        auto symbol = std::string(text.substr(start, end - start));
+
+        // Symbols can't start with a digit or a period, e.g. in 16 or .b.
+        auto first = symbol.find_first_not_of("0123456789.");
+        return first == std::string::npos ? std::string {} : symbol.substr(first);
+    }
+
+    std::filesystem::path path;
+    std::string text {};
+    driver::SourceIndex index;
+
+    // Whether the index has been updated since it was last analyzed.
+    bool dirty = false;
+    bool showing_parse_errors = false;
+};
+
+class LanguageServer {
+public:
+    LanguageServer(Options options, Connection& connection) : options(std::move(options)), connection(connection) {
+        include_cache = std::make_shared<assembler::IncludeCache>();
+
+        for (auto& path : this->options.equ_paths) {
+            snapshots.push_back(std::make_shared<const assembler::EquSnapshot>(path));
+        }
+    }
+
+    // Returns the exit status, once the client has asked the server to exit.
+    int Run() {
+        while (!exit_status) {
+            auto waiting = std::any_of(documents.begin(), documents.end(), [](auto& document) {
+                return document.second.dirty;
+            });
+
+            auto message = connection.Read(waiting ? options.settle_ms : -1);
+            if (message) {
+                Handle(message.value());
+            } else if (connection.Closed()) {
+                return 1;
+            } else {
+                AnalyzeDirtyDocuments();
+            }
+        }
+
+        return exit_status.value();
+    }
+
+private:
+    void Handle(const std::string& text) {
+        Value parsed {};
+        try {
+            parsed = Value::Parse(text);
+        } catch (std::exception const& e) {
+            SendError(nullptr, ErrorCode::ParseError, e.what());
+            return;
+        }
+
+        const auto& message = parsed;
+
+        auto& id = message["id"];
+        auto& method = message["method"];
+        if (method.GetType() != Value::Type::String) {
+            // A response to a request from the server. None are sent.
+            if (!message.Has("id")) SendError(nullptr, ErrorCode::InvalidRequest, "Missing method.");
+            return;
+        }
+
+        try {
+            auto result = Dispatch(method.AsString(), message["params"]);
+            if (message.Has("id")) {
+                if (!result) {
+                    SendError(id, ErrorCode::MethodNotFound, "Unsupported method: " + method.AsString());
+                } else {
+                    Value response {};
+                    response["jsonrpc"] = "2.0";
+                    response["id"] = id;
+                    response["result"] = std::move(result.value());
+                    connection.Write(response);
+                }
+            }
+        } catch (std::exception const& e) {
+            if (message.Has("id")) SendError(id, ErrorCode::InternalError, e.what());
+        }
+    }
+
+    // The result of a request or nothing if the method isn't supported. Notifications return null.
+    std::optional<Value> Dispatch(const std::string& method, const Value& params) {
+        if (method == "initialize") return Initialize();
+        if (method == "initialized") return Value {};
+        if (method == "shutdown") {
+            shutdown = true;
+            return Value {};
+        }
+        if (method == "exit") {
+            exit_status = shutdown ? 0 : 1;
+            return Value {};
+        }
+
+        if (method == "textDocument/didOpen") {
+            auto& document = params["textDocument"];
+            auto uri = document["uri"].AsString();
+            documents.erase(uri);
+            documents.try_emplace(uri, PathFromUri(uri), DocumentOptions(PathFromUri(uri)));
+            Change(uri, document["text"].AsString());
+            return Value {};
+        }
+
+        if (method == "textDocument/didChange") {
+            // Changes are full documents, as the server advertises.
+            auto& changes = params["contentChanges"].Items();
+            if (!changes.empty()) {
+                Change(params["textDocument"]["uri"].AsString(), changes.back()["text"].AsString());
+            }
+            return Value {};
+        }
+
+        if (method == "textDocument/didClose") {
+            auto uri = params["textDocument"]["uri"].AsString();
+            documents.erase(uri);
+            PublishDiagnostics(uri, {});
+            return Value {};
+        }
+
+        if (method == "textDocument/definition") return Definition(params);
+        if (method == "textDocument/hover") return Hover(params);
+        if (method == "textDocument/documentSymbol") return DocumentSymbols(params);
+
+        // Other notifications, e.g. $/cancelRequest, are ignored.
+        return method.rfind("$/", 0) == 0 ? std::optional<Value>(Value {}) : std::nullopt;
+    }
+
+    Value Initialize() {
+        Value capabilities {};
+        capabilities["textDocumentSync"]["openClose"] = true;
+        capabilities["textDocumentSync"]["change"] = 1;
+        capabilities["definitionProvider"] = true;
+        capabilities["hoverProvider"] = true;
+        capabilities["documentSymbolProvider"] = true;
+
+        Value result {};
+        result["capabilities"] = std::move(capabilities);
+        result["serverInfo"]["name"] = "alsp";
+        return result;
+    }
+
+    driver::AssembleOptions DocumentOptions(const std::filesystem::path& path) const {
+        driver::AssembleOptions assemble_options {};
+        assemble_options.fixed_time = 0;
+        assemble_options.include_cache = include_cache;
+        assemble_options.equ_snapshots = snapshots;
+
+        assemble_options.include_directories.push_back(path.parent_path());
+        for (auto& directory : options.include_directories) {
+            assemble_options.include_directories.emplace_back(directory);
+        }
+
+        return assemble_options;
+    }
+
+    Document& Find(const std::string& uri) {
+        auto document = documents.find(uri);
+        if (document == documents.end()) {
+            throw std::runtime_error("Document isn't open: " + uri);
+        }
+        return document->second;
+    }
+
+    void Change(const std::string& uri, std::string text) {
+        auto& document = Find(uri);
+        document.text = std::move(text);
+        document.index.Update(document.text);
+        document.dirty = true;
+
+        // Parse errors are reported at once. Others wait for the next analysis.
+        if (document.index.HasParseErrors() || document.showing_parse_errors) {
+            document.showing_parse_errors = document.index.HasParseErrors();
+            PublishDiagnostics(uri, document);
+        }
+    }
+
+    void AnalyzeDirtyDocuments() {
+        for (auto& [uri, document] : documents) {
+            if (!document.dirty) continue;
+
+            document.dirty = false;
+            document.showing_parse_errors = document.index.HasParseErrors();
+            document.index.Analyze();
+            PublishDiagnostics(uri, document);
+        }
+    }
+
+    void PublishDiagnostics(const std::string& uri, const Document& document) {
+        auto diagnostics = Value::Array();
+        for (auto& diagnostic : document.index.Diagnostics()) {
+            Value published {};
+            published["severity"] = diagnostic.severity == driver::Diagnostic::Severity::Error ? 1 : 2;
+            published["source"] = "alsp";
+
+            if (diagnostic.file.empty()) {
+                published["range"] = MakeRange(diagnostic.line, 0, document.Line(diagnostic.line ? diagnostic.line - 1 : 0).size());
+                published["message"] = diagnostic.message;
+            } else {
+                // Errors in used files are shown at the top of the document, naming the file.
+                published["range"] = MakeRange(0);
+                published["message"] = driver::FormatDiagnostic(diagnostic, document.path.string());
+            }
+
+            diagnostics.Push(std::move(published));
+        }
+
+        PublishDiagnostics(uri, std::move(diagnostics));
+    }
+
+    void PublishDiagnostics(const std::string& uri, Value diagnostics) {
+        Value notification {};
+        notification["jsonrpc"] = "2.0";
+        notification["method"] = "textDocument/publishDiagnostics";
+        notification["params"]["uri"] = uri;
+        notification["params"]["diagnostics"] = diagnostics.IsNull() ? Value::Array() : std::move(diagnostics);
+        connection.Write(notification);
+    }
+
+    std::pair<Document&, std::string> SymbolAt(const Value& params) {
+        auto& document = Find(params["textDocument"]["uri"].AsString());
+        auto& position = params["position"];
+        auto symbol = document.SymbolAt(position["line"].AsNumber(), position["character"].AsNumber());
+        return { document, symbol };
+    }
+
+    Value Definition(const Value& params) {
+        auto [document, symbol] = SymbolAt(params);
+        auto definition = document.index.FindDefinition(symbol);
+        if (!definition) return Value {};
+
+        Value location {};
+        location["uri"] = UriFromPath(definition->file.empty() ? document.path : definition->file);
+        location["range"] = MakeRange(definition->line, 0, definition->name.size());
+        return location;
+    }
+
+    Value Hover(const Value& params) {
+        auto [document, symbol] = SymbolAt(params);
+        auto definition = document.index.FindDefinition(symbol);
+        if (!definition) return Value {};
+
+        std::ostringstream text {};
+        if (definition->kind == driver::Definition::Kind::Label) {
+            text << definition->name;
+
+            if (auto& layout = document.index.GetLayout()) {
+                auto laid_out = layout->symbols.find(definition->name);
+                if (laid_out != layout->symbols.end() && laid_out->second.value) {
+                    text << ": " << DescribeCounter(laid_out->second.type) << " + " << Hex(laid_out->second.value.value());
+                }
+            }
+        } else {
+            text << definition->name << (definition->kind == driver::Definition::Kind::Equ ? " equ " : " set ")
+                 << definition->operands;
+
+            if (auto value = document.index.Value(definition->name)) {
+                text << " = " << value.value() << " (" << Hex(value.value()) << ")";
+            }
+        }
+
+        if (!definition->file.empty()) {
+            text << "\n\nDefined in " << definition->file.string() << ":" << definition->line;
+        }
+
+        Value hover {};
+        hover["contents"]["kind"] = "plaintext";
+        hover["contents"]["value"] = text.str();
+        return hover;
+    }
+
+    Value DocumentSymbols(const Value& params) {
+        auto& document = Find(params["textDocument"]["uri"].AsString());
+        auto& layout = document.index.GetLayout();
+
+        auto symbols = Value::Array();
+        for (auto& definition : document.index.Definitions()) {
+            auto kind = SymbolKind::Function;
+            if (definition.kind == driver::Definition::Kind::Equ) {
+                kind = SymbolKind::Constant;
+            } else if (definition.kind == driver::Definition::Kind::Set) {
+                kind = SymbolKind::Variable;
+            } else if (layout) {
+                auto laid_out = layout->symbols.find(definition.name);
+                if (laid_out != layout->symbols.end() && laid_out->second.type != object::SymbolInfo::Code) {
+                    kind = SymbolKind::Variable;
+                }
+            }
+
+            Value symbol {};
+            symbol["name"] = definition.name;
+            symbol["kind"] = static_cast<int>(kind);
+            symbol["range"] = MakeRange(definition.line, 0, document.Line(definition.line - 1).size());
+            symbol["selectionRange"] = MakeRange(definition.line, 0, definition.name.size());
+            symbols.Push(std::move(symbol));
+        }
+
+        return symbols;
+    }
+
+    void SendError(const Value& id, ErrorCode code, const std::string& message) {
+        Value response {};
+        response["jsonrpc"] = "2.0";
+        response["id"] = id;
+        response["error"]["code"] = static_cast<int>(code);
+        response["error"]["message"] = message;
+        connection.Write(response);
+    }
+
+    Options options;
+    Connection& connection;
+    std::shared_ptr<assembler::IncludeCache> include_cache;
+    std::vector<std::shared_ptr<const assembler::EquSnapshot>> snapshots {};
+    std::map<std::string, Document> documents {};
+
+    bool shutdown = false;
+    std::optional<int> exit_status {};
+};
+
+}
+
+int main(int argc, const char* argv[]) {
+    auto options = ParseArguments(argc, argv);
+
+    try {
+        Connection connection {};
+        LanguageServer server(options, connection);
+        return server.Run();
+    } catch (std::exception const& e) {
+        std::cerr << "alsp: " << e.what() << std::endl;
+        return 1;
+    }
+}
\ No newline at end of file
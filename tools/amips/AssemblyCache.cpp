@@ -0,0 +1,118 @@
+#include "AssemblyCache.h"
+#include "amips.h"
+
+#include <Sha256.h>
+
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <unistd.h>
+
+namespace amips {
+
+AssemblyCache::AssemblyCache(std::filesystem::path directory) : directory(std::move(directory)) {}
+
+std::string AssemblyCache::Key(std::string_view source, std::string_view options,
+        const std::filesystem::path& working_directory) {
+    support::Sha256 hash {};
+
+    // Lengths are hashed ahead of variable-length fields, so distinct inputs can't collide by concatenation.
+    auto update_field = [&hash](std::string_view field) {
+        uint64_t size = field.size();
+        hash.Update(&size, sizeof(size));
+        hash.Update(field);
+    };
+
+    update_field("amips-cache");
+    update_field(std::to_string(constants::AssemblerVersion));
+    update_field(options);
+    update_field(working_directory.string());
+    update_field(source);
+
+    return support::Sha256::ToHex(hash.Finish());
+}
+
+std::optional<std::string> AssemblyCache::DependentKey(const std::string& key, const std::vector<std::filesystem::path>& dependencies) {
+    std::string manifest = key;
+
+    for (auto& dependency : dependencies) {
+        std::ifstream in(dependency, std::ios::binary);
+        if (!in.is_open()) {
+            return std::nullopt;
+        }
+
+        std::ostringstream contents {};
+        contents << in.rdbuf();
+
+        support::Sha256 hash {};
+        hash.Update(contents.str());
+        manifest += "\n" + dependency.string() + "\t" + support::Sha256::ToHex(hash.Finish());
+    }
+
+    return Key(manifest, "dependencies", {});
+}
+
+std::filesystem::path AssemblyCache::EntryPath(const std::string& key, const std::string& extension) const {
+    // Fan out by the first byte of the key to keep directories small.
+    return directory / key.substr(0, 2) / (key + extension);
+}
+
+std::optional<std::filesystem::path> AssemblyCache::Lookup(const std::string& key) const {
+    auto path = EntryPath(key);
+
+    std::error_code error {};
+    if (std::filesystem::is_regular_file(path, error)) {
+        return path;
+    }
+
+    return std::nullopt;
+}
+
+void AssemblyCache::Store(const std::string& key, std::string_view rof) const {
+    WriteEntry(EntryPath(key), rof);
+}
+
+std::optional<std::vector<std::filesystem::path>> AssemblyCache::LookupDependencies(const std::string& key) const {
+    std::ifstream in(EntryPath(key, ".d"));
+    if (!in.is_open()) {
+        return std::nullopt;
+    }
+
+    std::vector<std::filesystem::path> dependencies {};
+    for (std::string line; std::getline(in, line);) {
+        dependencies.emplace_back(line);
+    }
+
+    return dependencies;
+}
+
+void AssemblyCache::StoreDependencies(const std::string& key, const std::vector<std::filesystem::path>& dependencies) const {
+    std::string contents {};
+    for (auto& dependency : dependencies) {
+        contents += dependency.string() + "\n";
+    }
+
+    WriteEntry(EntryPath(key, ".d"), contents);
+}
+
+void AssemblyCache::WriteEntry(const std::filesystem::path& path, std::string_view contents) const {
+    std::filesystem::create_directories(path.parent_path());
+
+    // Unique per process and per write, since jobs in one process may store identical sources at once.
+    static std::atomic<uint64_t> write_count {};
+    auto temp_path = path;
+    temp_path += ".tmp" + std::to_string(getpid()) + "." + std::to_string(write_count++);
+
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), contents.size());
+        if (!out) {
+            throw std::runtime_error("Failed to write cache entry: " + temp_path.string());
+        }
+    }
+
+    std::filesystem::rename(temp_path, path);
+}
+
+}
\ No newline at end of file
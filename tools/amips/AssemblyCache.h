@@ -0,0 +1,57 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace amips {
+
+/**
+ * On-disk cache of assembled ROFs, content-addressed by a hash of everything that
+ * determines the output: the source bytes, the assembler version, the options string (target,
+ * timestamp, include directories and symbol snapshots), and the working directory.
+ *
+ * Files included by a source aren't known until it's assembled, so they're recorded per
+ * source key, which covers everything that decides how 'use' paths resolve. A lookup
+ * rehashes the recorded files and looks for the ROF under the combined key, so editing an
+ * included file invalidates every source using it.
+ *
+ * Entries are written to a temporary file and renamed into place, so concurrent
+ * assemblers sharing a cache directory never observe partial entries.
+ */
+class AssemblyCache {
+public:
+    explicit AssemblyCache(std::filesystem::path directory);
+
+    /**
+     * @param source the complete source text.
+     * @param options a stable description of all options which affect output (including the timestamp).
+     * @param working_directory the directory relative 'use' paths fall back to. The same source can
+     *        include different files from different directories, so it's keyed apart.
+     */
+    static std::string Key(std::string_view source, std::string_view options,
+        const std::filesystem::path& working_directory);
+
+    /**
+     * Combine key with the current contents of the files it depends on.
+     * Returns nullopt if any of them can no longer be read.
+     */
+    static std::optional<std::string> DependentKey(const std::string& key, const std::vector<std::filesystem::path>& dependencies);
+
+    std::optional<std::filesystem::path> Lookup(const std::string& key) const;
+    void Store(const std::string& key, std::string_view rof) const;
+
+    // The files recorded for key by StoreDependencies, if any.
+    std::optional<std::vector<std::filesystem::path>> LookupDependencies(const std::string& key) const;
+    void StoreDependencies(const std::string& key, const std::vector<std::filesystem::path>& dependencies) const;
+
+private:
+    std::filesystem::path EntryPath(const std::string& key, const std::string& extension = ".r") const;
+    void WriteEntry(const std::filesystem::path& path, std::string_view contents) const;
+
+    std::filesystem::path directory;
+};
+
+}
\ No newline at end of file
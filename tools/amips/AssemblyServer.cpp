@@ -0,0 +1,347 @@
+#include "AssemblyServer.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace amips {
+
+namespace {
+
+constexpr auto ProtocolVersion = "amips-server-1";
+
+// Guards against clients (or strays) sending nonsense lengths.
+constexpr uint32_t MaxMessageSize = 256U * 1024U * 1024U;
+
+// The write end of the serving AssemblyServer's wake pipe, for the signal handler.
+std::atomic<int> signal_pipe = -1;
+
+void OnSignal(int) {
+    int fd = signal_pipe.load();
+    if (fd >= 0) {
+        char byte = 0;
+        (void) !write(fd, &byte, 1);
+    }
+}
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+sockaddr_un SocketAddress(const std::filesystem::path& path) {
+    sockaddr_un address {};
+    address.sun_family = AF_UNIX;
+
+    auto name = path.string();
+    if (name.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path is too long: " + name);
+    }
+    std::memcpy(address.sun_path, name.c_str(), name.size() + 1);
+
+    return address;
+}
+
+void WriteAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        auto written = send(fd, data, size, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            ThrowErrno("Failed to write to socket");
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void ReadAll(int fd, char* data, std::size_t size) {
+    while (size > 0) {
+        auto count = read(fd, data, size);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            ThrowErrno("Failed to read from socket");
+        }
+        if (count == 0) {
+            throw std::runtime_error("Connection closed mid-message.");
+        }
+        data += count;
+        size -= count;
+    }
+}
+
+void PutWord(std::string& out, uint32_t value) {
+    out.push_back(static_cast<char>(value >> 24U));
+    out.push_back(static_cast<char>(value >> 16U));
+    out.push_back(static_cast<char>(value >> 8U));
+    out.push_back(static_cast<char>(value));
+}
+
+uint32_t GetWord(const char* data) {
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    return uint32_t(bytes[0]) << 24U | uint32_t(bytes[1]) << 16U | uint32_t(bytes[2]) << 8U | bytes[3];
+}
+
+void SendMessage(int fd, const std::vector<std::string>& fields) {
+    std::string payload {};
+    for (auto& field : fields) {
+        PutWord(payload, field.size());
+        payload.append(field);
+    }
+
+    if (payload.size() > MaxMessageSize) {
+        throw std::runtime_error("Message is too large.");
+    }
+
+    std::string frame {};
+    PutWord(frame, payload.size());
+    frame.append(payload);
+    WriteAll(fd, frame.data(), frame.size());
+}
+
+std::vector<std::string> ReceiveMessage(int fd) {
+    char size_bytes[4];
+    ReadAll(fd, size_bytes, sizeof(size_bytes));
+
+    auto size = GetWord(size_bytes);
+    if (size > MaxMessageSize) {
+        throw std::runtime_error("Message is too large.");
+    }
+
+    std::string payload(size, '\0');
+    ReadAll(fd, payload.data(), payload.size());
+
+    std::vector<std::string> fields {};
+    std::size_t offset = 0;
+    while (offset < payload.size()) {
+        if (payload.size() - offset < 4) throw std::runtime_error("Malformed message.");
+        auto length = GetWord(payload.data() + offset);
+        offset += 4;
+
+        if (length > payload.size() - offset) throw std::runtime_error("Malformed message.");
+        fields.emplace_back(payload, offset, length);
+        offset += length;
+    }
+
+    return fields;
+}
+
+// Request: version, working directory, environment count, environment names and values,
+// whether stdin follows, [stdin], args...
+std::vector<std::string> EncodeRequest(const ServerRequest& request) {
+    std::vector<std::string> fields { ProtocolVersion, request.working_directory, std::to_string(request.environment.size()) };
+    for (auto& [name, value] : request.environment) {
+        fields.push_back(name);
+        fields.push_back(value);
+    }
+
+    fields.emplace_back(request.standard_input ? "1" : "0");
+    if (request.standard_input) {
+        fields.push_back(request.standard_input.value());
+    }
+
+    fields.insert(fields.end(), request.args.begin(), request.args.end());
+    return fields;
+}
+
+ServerRequest DecodeRequest(const std::vector<std::string>& fields) {
+    if (fields.size() < 4 || fields[0] != ProtocolVersion) {
+        throw std::runtime_error("Unsupported client version.");
+    }
+
+    ServerRequest request {};
+    request.working_directory = fields[1];
+
+    std::size_t next = 3;
+    auto environment_count = std::stoul(fields[2]);
+    if (environment_count > (fields.size() - next) / 2) throw std::runtime_error("Malformed request.");
+    for (std::size_t i = 0; i < environment_count; i++, next += 2) {
+        request.environment.emplace_back(fields[next], fields[next + 1]);
+    }
+
+    if (next >= fields.size()) throw std::runtime_error("Malformed request.");
+    if (fields[next++] == "1") {
+        if (next >= fields.size()) throw std::runtime_error("Malformed request.");
+        request.standard_input = fields[next++];
+    }
+
+    request.args.assign(fields.begin() + next, fields.end());
+    return request;
+}
+
+struct FileDescriptor {
+    explicit FileDescriptor(int fd) : fd(fd) {}
+    ~FileDescriptor() { if (fd >= 0) close(fd); }
+
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+    int fd;
+};
+
+}
+
+AssemblyServer::AssemblyServer(std::filesystem::path socket_path, std::size_t connection_count, Handler handler)
+    : socket_path(std::move(socket_path)), handler(std::move(handler)), connections(connection_count) {
+    auto address = SocketAddress(this->socket_path);
+
+    if (pipe2(wake_pipe, O_CLOEXEC) != 0) {
+        ThrowErrno("Failed to create pipe");
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        ThrowErrno("Failed to create socket");
+    }
+
+    // A socket left behind by a server that didn't shut down cleanly would block bind. Anything
+    // else at the path is left alone: a file named by mistake, or a live server's socket.
+    struct stat existing {};
+    if (lstat(this->socket_path.c_str(), &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            throw std::runtime_error(this->socket_path.string() + " exists and isn't a socket.");
+        }
+
+        FileDescriptor probe(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+        if (probe.fd >= 0 && connect(probe.fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+            throw std::runtime_error(this->socket_path.string() + " is already in use.");
+        }
+
+        unlink(this->socket_path.c_str());
+    }
+
+    // Requests name files for the server to write, so only its own user may connect.
+    auto mask = umask(077);
+    auto bound = bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    umask(mask);
+
+    if (bound != 0) {
+        ThrowErrno("Failed to bind " + this->socket_path.string());
+    }
+
+    struct stat created {};
+    if (lstat(this->socket_path.c_str(), &created) == 0) {
+        socket_id = std::make_pair(created.st_dev, created.st_ino);
+    }
+
+    if (listen(listener, SOMAXCONN) != 0) {
+        ThrowErrno("Failed to listen on " + this->socket_path.string());
+    }
+}
+
+AssemblyServer::~AssemblyServer() {
+    if (listener >= 0) {
+        close(listener);
+
+        // Only remove the socket if it's still ours, rather than one a newer server replaced it with.
+        struct stat current {};
+        if (socket_id && lstat(socket_path.c_str(), &current) == 0
+            && std::make_pair(current.st_dev, current.st_ino) == socket_id) {
+            unlink(socket_path.c_str());
+        }
+    }
+
+    int serving = wake_pipe[1];
+    signal_pipe.compare_exchange_strong(serving, -1);
+    for (int fd : wake_pipe) {
+        if (fd >= 0) close(fd);
+    }
+}
+
+void AssemblyServer::Serve() {
+    signal_pipe = wake_pipe[1];
+
+    struct sigaction action {};
+    action.sa_handler = OnSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    while (!stopping) {
+        pollfd fds[2] = {
+            { listener, POLLIN, 0 },
+            { wake_pipe[0], POLLIN, 0 }
+        };
+
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            ThrowErrno("Failed to wait for connections");
+        }
+
+        if (fds[1].revents) {
+            break;
+        }
+
+        int connection = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (connection < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == ECONNABORTED) continue;
+            ThrowErrno("Failed to accept connection");
+        }
+
+        connections.Submit([this, connection]() { HandleConnection(connection); });
+    }
+}
+
+void AssemblyServer::Stop() {
+    stopping = true;
+
+    char byte = 0;
+    (void) !write(wake_pipe[1], &byte, 1);
+}
+
+void AssemblyServer::HandleConnection(int connection) {
+    FileDescriptor fd(connection);
+
+    ServerResponse response {};
+    try {
+        ucred peer {};
+        socklen_t peer_size = sizeof(peer);
+        if (getsockopt(fd.fd, SOL_SOCKET, SO_PEERCRED, &peer, &peer_size) != 0) {
+            ThrowErrno("Failed to identify client");
+        }
+
+        if (peer.uid != geteuid()) {
+            throw std::runtime_error("permission denied: clients must run as the server's user");
+        }
+
+        response = handler(DecodeRequest(ReceiveMessage(fd.fd)));
+    } catch (std::exception const& e) {
+        response = ServerResponse { 1, std::string("amips server: ") + e.what() + "\n" };
+    }
+
+    try {
+        SendMessage(fd.fd, { std::to_string(response.status), response.errors });
+    } catch (std::exception const&) {
+        // The client went away. Nothing more to do.
+    }
+}
+
+std::optional<ServerResponse> ForwardToServer(const std::filesystem::path& socket_path, const ServerRequest& request) {
+    auto address = SocketAddress(socket_path);
+
+    FileDescriptor fd(socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0));
+    if (fd.fd < 0) {
+        ThrowErrno("Failed to create socket");
+    }
+
+    if (connect(fd.fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        return std::nullopt;
+    }
+
+    SendMessage(fd.fd, EncodeRequest(request));
+    auto fields = ReceiveMessage(fd.fd);
+    if (fields.size() != 2) {
+        throw std::runtime_error("Malformed response from server.");
+    }
+
+    return ServerResponse { std::stoi(fields[0]), fields[1] };
+}
+
+}
\ No newline at end of file
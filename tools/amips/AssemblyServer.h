@@ -0,0 +1,85 @@
+#pragma once
+
+#include <ThreadPool.h>
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace amips {
+
+/**
+ * An amips invocation, as forwarded from a client to the server.
+ * Paths in args are relative to working_directory.
+ */
+struct ServerRequest {
+    std::vector<std::string> args {};
+    std::string working_directory {};
+    std::vector<std::pair<std::string, std::string>> environment {};
+
+    // The client's standard input, for a source named '-'.
+    std::optional<std::string> standard_input {};
+};
+
+struct ServerResponse {
+    int status = 0;
+    std::string errors {};
+};
+
+/**
+ * Serves assembly requests on a Unix domain socket, so that clients skip process startup
+ * and share warm caches.
+ *
+ * Each connection carries one request and its response, both framed as a length-prefixed
+ * list of length-prefixed strings (big endian). Connections are handled concurrently.
+ */
+class AssemblyServer {
+public:
+    using Handler = std::function<ServerResponse(const ServerRequest&)>;
+
+    /**
+     * Listen on socket_path, replacing any stale socket there. Throws if something other
+     * than a socket is there, or if another server is listening on it.
+     *
+     * The socket is only accessible to the current user, and connections from other users
+     * are refused.
+     */
+    AssemblyServer(std::filesystem::path socket_path, std::size_t connection_count, Handler handler);
+    ~AssemblyServer();
+
+    AssemblyServer(const AssemblyServer&) = delete;
+    AssemblyServer& operator=(const AssemblyServer&) = delete;
+
+    // Serve requests until Stop is called, or SIGINT or SIGTERM is received.
+    void Serve();
+
+    // Safe to call from any thread.
+    void Stop();
+
+private:
+    void HandleConnection(int connection);
+
+    std::filesystem::path socket_path;
+
+    // The device and inode of the socket this server created, so it isn't mistaken for a replacement.
+    std::optional<std::pair<dev_t, ino_t>> socket_id {};
+    Handler handler;
+    int listener = -1;
+    int wake_pipe[2] = { -1, -1 };
+    std::atomic<bool> stopping = false;
+    support::ThreadPool connections;
+};
+
+/**
+ * Send request to the server listening on socket_path.
+ * Returns nullopt if no server is listening. Throws if the server fails mid-request.
+ */
+std::optional<ServerResponse> ForwardToServer(const std::filesystem::path& socket_path, const ServerRequest& request);
+
+}
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "FileWatcher.h"
+
+#include <cerrno>
+#include <system_error>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace amips {
+
+namespace {
+
+constexpr uint32_t WatchedEvents = IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | IN_MOVED_TO | IN_MOVED_FROM;
+
+[[noreturn]] void ThrowErrno(const std::string& what) {
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+}
+
+FileWatcher::FileWatcher() {
+    fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (fd < 0) {
+        ThrowErrno("Failed to initialize inotify");
+    }
+}
+
+FileWatcher::~FileWatcher() {
+    close(fd);
+}
+
+void FileWatcher::SetFiles(const std::vector<std::filesystem::path>& paths) {
+    std::set<std::filesystem::path> wanted_directories {};
+    files.clear();
+
+    for (auto& path : paths) {
+        auto absolute = std::filesystem::absolute(path).lexically_normal();
+        files.insert(absolute);
+        wanted_directories.insert(absolute.parent_path());
+    }
+
+    for (auto watch = directories.begin(); watch != directories.end();) {
+        if (wanted_directories.erase(watch->second) == 0) {
+            inotify_rm_watch(fd, watch->first);
+            watch = directories.erase(watch);
+        } else {
+            ++watch;
+        }
+    }
+
+    for (auto& directory : wanted_directories) {
+        int watch = inotify_add_watch(fd, directory.c_str(), WatchedEvents);
+        if (watch < 0) {
+            ThrowErrno("Failed to watch " + directory.string());
+        }
+        directories[watch] = directory;
+    }
+}
+
+bool FileWatcher::ReadEvents() {
+    alignas(inotify_event) char buffer[16 * 1024];
+    bool relevant = false;
+
+    while (true) {
+        auto count = read(fd, buffer, sizeof(buffer));
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN) return relevant;
+            ThrowErrno("Failed to read file events");
+        }
+
+        for (char* next = buffer; next < buffer + count;) {
+            auto event = reinterpret_cast<inotify_event*>(next);
+            next += sizeof(inotify_event) + event->len;
+
+            auto directory = directories.find(event->wd);
+            if (directory != directories.end() && event->len > 0) {
+                relevant |= files.count(directory->second / event->name) > 0;
+            }
+        }
+    }
+}
+
+void FileWatcher::WaitForChange(std::chrono::milliseconds settle_time) {
+    pollfd events { fd, POLLIN, 0 };
+
+    bool changed = false;
+    while (!changed) {
+        if (poll(&events, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            ThrowErrno("Failed to wait for file events");
+        }
+        changed = ReadEvents();
+    }
+
+    while (poll(&events, 1, static_cast<int>(settle_time.count())) > 0) {
+        ReadEvents();
+    }
+}
+
+}
\ No newline at end of file
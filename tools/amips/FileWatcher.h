@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace amips {
+
+/**
+ * Waits for changes to a set of files, using inotify.
+ *
+ * The directories containing the files are watched rather than the files themselves, so
+ * that editors which save by replacing a file are still noticed.
+ */
+class FileWatcher {
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Replace the set of watched files.
+    void SetFiles(const std::vector<std::filesystem::path>& files);
+
+    /**
+     * Block until a watched file is written, replaced or removed, then until events have
+     * stopped arriving for settle_time, so that a burst of writes is seen as one change.
+     */
+    void WaitForChange(std::chrono::milliseconds settle_time = std::chrono::milliseconds(5));
+
+private:
+    // Reads the pending events. Returns true if any concerned a watched file.
+    bool ReadEvents();
+
+    int fd = -1;
+    std::map<int, std::filesystem::path> directories {};
+    std::set<std::filesystem::path> files {};
+};
+
+}
\ No newline at end of file
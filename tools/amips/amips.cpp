@@ -1,46 +1,790 @@
 #include <iostream>
 #include <fstream>
+#include <sstream>
 
 #include "amips.h"
+#include "AssemblyCache.h"
+#include "AssemblyServer.h"
 
-#include <Assembler.h>
-#include <MipsAssemblerTarget.h>
+#include <Driver.h>
+#include <EquSnapshot.h>
+#include <IncludeCache.h>
 #include "InputFileParser.h"
-#include "Rof15ObjectFile.h"
-#include "Rof15ObjectWriter.h"
-#include "Endian.h"
+#include "MappedFile.h"
+#include "Sha256.h"
+#include "ThreadPool.h"
+#include "FileWatcher.h"
 
-int main(int argc, const char* argv[]) {
-    std::fstream in_file;
-    in_file.exceptions(std::fstream::badbit);
-    in_file.open(argv[1], std::fstream::in);
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+// How amips was run: locally, or forwarded by a client to the server.
+struct Invocation {
+    std::vector<std::string> args {};
+    std::filesystem::path working_directory {};
+    std::optional<std::string> source_date_epoch {};
+    std::optional<std::string> cache_dir {};
+    std::optional<std::string> server_socket {};
+    std::optional<std::string> standard_input {};
+};
+
+struct UsageError : std::runtime_error {
+    using runtime_error::runtime_error;
+};
+
+// Carries diagnostics which already name the file and line.
+struct AssemblyFailed : std::runtime_error {
+    using runtime_error::runtime_error;
+};
+
+struct Job {
+    std::string input_path {};
+    std::string output_path {};
+
+    // When set, a Makefile rule listing everything the ROF was built from is written here.
+    std::optional<std::string> dependency_path {};
+};
+
+struct Options {
+    std::vector<Job> jobs {};
+
+    // Relative paths are resolved against this, rather than the process's working directory.
+    std::filesystem::path working_directory {};
+    std::optional<std::string> standard_input {};
+
+    std::size_t worker_count = support::ThreadPool::DefaultThreadCount();
+
+    // When set, output is stamped with this time rather than the current time.
+    std::optional<std::time_t> fixed_time {};
+    std::optional<std::string> cache_dir {};
+
+    std::vector<std::string> equ_paths {};
+    std::vector<std::string> include_dirs {};
+
+    // When set, the source is compiled into an equ snapshot rather than assembled.
+    std::optional<std::string> make_equ_path {};
+
+    bool phony_dependencies = false;
+
+    // Serve requests on this socket, rather than assembling.
+    std::optional<std::string> serve_socket {};
+
+    // Forward this invocation to the server on this socket, if one is listening.
+    std::optional<std::string> connect_socket {};
+
+    // Reassemble the source whenever it or anything it includes changes.
+    bool watch = false;
+};
+
+struct Assembled {
+    std::string rof;
+    std::vector<std::filesystem::path> included_files;
+};
+
+struct LoadedSnapshot {
+    std::shared_ptr<const assembler::EquSnapshot> snapshot;
+    std::string digest;
+};
+
+// State shared by every job in a run. None of it is modified once assembly starts.
+struct Shared {
+    std::vector<LoadedSnapshot> snapshots;
+    std::shared_ptr<assembler::IncludeCache> includes;
+    std::optional<amips::AssemblyCache> cache;
+    std::string fingerprint;
+};
+
+[[noreturn]] void Usage(const std::string& error) {
+    throw UsageError(error);
+}
+
+// Far more workers than any machine needs, but few enough that their threads can be created.
+constexpr std::size_t MaxWorkerCount = 1024;
+
+std::size_t WorkerCount(const std::string& value) {
+    try {
+        // stoul would accept a sign or leading spaces, and wrap negative counts.
+        std::size_t end = 0;
+        auto count = std::stoul(value, &end);
+        if (!value.empty() && std::isdigit(static_cast<unsigned char>(value.front())) && end == value.size()
+            && count >= 1 && count <= MaxWorkerCount) {
+            return count;
+        }
+    } catch (std::exception const&) {
+    }
+
+    Usage("-j must be a number from 1 to " + std::to_string(MaxWorkerCount) + ".");
+}
+
+void PrintUsage(std::ostream& out) {
+    out << "usage: amips [options] <source>..." << std::endl
+              << "  -o <file>            write the ROF to <file> (default: amips_out.r, or <source>.r for many sources)" << std::endl
+              << "  --batch <file>       also assemble each '<source> [<output>]' line of <file>" << std::endl
+              << "  -j <count>           assemble up to <count> sources at once (default: hardware threads)" << std::endl
+              << "  --deterministic      stamp output with SOURCE_DATE_EPOCH (or 0) instead of the current time" << std::endl
+              << "  --cache-dir <dir>    reuse ROFs for previously assembled inputs (implies --deterministic)" << std::endl
+              << "  -I <dir>             search <dir> for files named by 'use' (may be repeated)" << std::endl
+              << "  -MD                  write a Makefile dependency rule to <output>.d" << std::endl
+              << "  -MF <file>           write the dependency rule to <file> (implies -MD)" << std::endl
+              << "  -MP                  add an empty rule for each dependency, so deleted files don't break make" << std::endl
+              << "  --equ <snapshot>     predefine the equs in <snapshot> (may be repeated)" << std::endl
+              << "  --make-equ <file>    compile a source of equ directives into a snapshot at <file>" << std::endl
+              << "  --watch              reassemble the source whenever it or a file it uses changes" << std::endl
+              << "  --server <socket>    serve assembly requests on the Unix domain socket <socket>" << std::endl
+              << "  --connect <socket>   forward this command to the server on <socket>, or assemble locally if there is none" << std::endl
+              << std::endl
+              << "A source named '-' is read from standard input." << std::endl
+              << "SOURCE_DATE_EPOCH, if set, always overrides the timestamp. AMIPS_CACHE_DIR sets a default cache directory." << std::endl
+              << "AMIPS_SERVER sets a default for --connect." << std::endl;
+}
+
+std::filesystem::path Resolve(const Options& options, const std::string& path) {
+    return options.working_directory / path;
+}
+
+std::optional<std::time_t> SourceDateEpoch(const Invocation& invocation) {
+    if (!invocation.source_date_epoch) return std::nullopt;
+
+    try {
+        return static_cast<std::time_t>(std::stoll(invocation.source_date_epoch.value()));
+    } catch (std::exception const&) {
+        Usage("SOURCE_DATE_EPOCH must be an integer.");
+    }
+}
+
+Options ParseArguments(const Invocation& invocation) {
+    Options options {};
+    options.working_directory = invocation.working_directory;
+    options.standard_input = invocation.standard_input;
+    options.connect_socket = invocation.server_socket;
+    bool deterministic = false;
+    bool write_dependencies = false;
+    std::optional<std::string> output_path {};
+    std::optional<std::string> dependency_path {};
+    std::vector<Job> batch {};
+
+    if (invocation.cache_dir && !invocation.cache_dir->empty()) {
+        options.cache_dir = invocation.cache_dir;
+    }
+
+    auto& args = invocation.args;
+    for (std::size_t i = 0; i < args.size(); i++) {
+        auto& arg = args[i];
+
+        auto value = [&]() -> std::string {
+            if (i + 1 >= args.size()) Usage("Missing value for " + arg + ".");
+            return args[++i];
+        };
+
+        if (arg == "-o") {
+            output_path = value();
+        } else if (arg == "--batch") {
+            auto batch_path = value();
+            std::ifstream batch_file(Resolve(options, batch_path));
+            if (!batch_file.is_open()) Usage("Failed to open batch file " + batch_path + ".");
+
+            for (std::string line; std::getline(batch_file, line);) {
+                std::istringstream fields(line);
+                Job job {};
+                if (fields >> job.input_path) {
+                    fields >> job.output_path;
+                    batch.push_back(job);
+                }
+            }
+        } else if (arg == "-j") {
+            options.worker_count = WorkerCount(value());
+        } else if (arg == "--deterministic") {
+            deterministic = true;
+        } else if (arg == "--cache-dir") {
+            options.cache_dir = value();
+        } else if (arg == "-I") {
+            options.include_dirs.push_back(value());
+        } else if (arg == "-MD") {
+            write_dependencies = true;
+        } else if (arg == "-MF") {
+            dependency_path = value();
+        } else if (arg == "-MP") {
+            options.phony_dependencies = true;
+        } else if (arg == "--equ") {
+            options.equ_paths.push_back(value());
+        } else if (arg == "--make-equ") {
+            options.make_equ_path = value();
+        } else if (arg == "--watch") {
+            options.watch = true;
+        } else if (arg == "--server") {
+            options.serve_socket = value();
+        } else if (arg == "--connect") {
+            options.connect_socket = value();
+        } else if (arg == "-") {
+            options.jobs.push_back(Job { arg });
+        } else if (!arg.empty() && arg.front() == '-') {
+            Usage("Unknown option: " + arg);
+        } else {
+            options.jobs.push_back(Job { arg });
+        }
+    }
+
+    bool single_source = options.jobs.size() == 1 && batch.empty();
+    options.jobs.insert(options.jobs.end(), batch.begin(), batch.end());
+
+    if (options.serve_socket) {
+        if (!options.jobs.empty()) Usage("--server doesn't take sources.");
+        return options;
+    }
 
+    if (options.jobs.empty()) {
+        Usage("No source file specified.");
+    }
+
+    if (!single_source && (output_path || dependency_path || options.make_equ_path)) {
+        Usage("-o, -MF and --make-equ need a single source.");
+    }
+
+    if (options.watch && (!single_source || options.jobs.front().input_path == "-" || options.make_equ_path)) {
+        Usage("--watch needs a single source file.");
+    }
+
+    for (auto& job : options.jobs) {
+        if (job.input_path == "-" && !single_source) {
+            Usage("Standard input can only be assembled as a single source.");
+        }
+
+        if (job.output_path.empty()) {
+            job.output_path = single_source
+                ? output_path.value_or("amips_out.r")
+                : std::filesystem::path(job.input_path).replace_extension(".r").string();
+        }
+
+        if (dependency_path) {
+            job.dependency_path = dependency_path;
+        } else if (write_dependencies) {
+            job.dependency_path = std::filesystem::path(job.output_path).replace_extension(".d").string();
+        }
+    }
+
+    // Caching is only sound when output depends on nothing but the inputs.
+    if (deterministic || options.cache_dir || SourceDateEpoch(invocation)) {
+        options.fixed_time = SourceDateEpoch(invocation).value_or(0);
+    }
+
+    return options;
+}
+
+/**
+ * Describes every option which affects the produced ROF, for use in cache keys.
+ */
+std::string OptionsFingerprint(const Options& options, const std::vector<LoadedSnapshot>& snapshots) {
+    auto fingerprint = "target=mips;endian=big;time=" + std::to_string(options.fixed_time.value_or(0));
+
+    // Included files are hashed separately, but which ones are found depends on the search order.
+    for (auto& dir : options.include_dirs) {
+        fingerprint += ";include=" + Resolve(options, dir).string();
+    }
+
+    // Snapshots are identified by content, so rebuilding one invalidates dependent entries.
+    for (auto& loaded : snapshots) {
+        fingerprint += ";equ=" + loaded.digest;
+    }
+
+    return fingerprint;
+}
+
+std::string EscapeForMake(const std::string& path) {
+    std::string escaped {};
+    for (char c : path) {
+        if (c == '$') {
+            escaped += "$$";
+        } else if (c == ' ' || c == '#' || c == ':') {
+            escaped += '\\';
+            escaped += c;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+/**
+ * Write a Makefile rule making the ROF depend on its source, snapshots and every included file.
+ */
+void WriteDependencies(const Options& options, const Job& job, const std::vector<std::filesystem::path>& included_files) {
+    std::vector<std::string> dependencies {};
+    if (job.input_path != "-") {
+        dependencies.push_back(job.input_path);
+    }
+    dependencies.insert(dependencies.end(), options.equ_paths.begin(), options.equ_paths.end());
+    for (auto& file : included_files) {
+        dependencies.push_back(file.string());
+    }
+
+    std::ostringstream rule {};
+    rule << EscapeForMake(job.output_path) << ":";
+    for (auto& dependency : dependencies) {
+        rule << " \\\n  " << EscapeForMake(dependency);
+    }
+    rule << "\n";
+
+    if (options.phony_dependencies) {
+        for (std::size_t i = job.input_path != "-" ? 1 : 0; i < dependencies.size(); i++) {
+            rule << "\n" << EscapeForMake(dependencies[i]) << ":\n";
+        }
+    }
+
+    std::ofstream out(Resolve(options, job.dependency_path.value()), std::ios::trunc);
+    out << rule.str();
+    if (!out) {
+        throw std::runtime_error("Failed to write " + job.dependency_path.value());
+    }
+}
+
+std::vector<LoadedSnapshot> LoadSnapshots(const Options& options) {
+    std::vector<LoadedSnapshot> snapshots {};
+
+    for (auto& path : options.equ_paths) {
+        try {
+            auto resolved = Resolve(options, path).string();
+            support::MappedFile file(resolved);
+            support::Sha256 hash {};
+            hash.Update(file.Data(), file.Size());
+
+            auto snapshot = std::make_shared<const assembler::EquSnapshot>(resolved);
+            snapshots.push_back({ std::move(snapshot), support::Sha256::ToHex(hash.Finish()) });
+        } catch (std::exception const& e) {
+            throw std::runtime_error("Failed to load equ snapshot " + path + ": " + e.what());
+        }
+    }
+
+    return snapshots;
+}
+
+driver::AssembleOptions DriverOptions(const Options& options, const Shared& shared) {
+    driver::AssembleOptions assemble_options {};
+    assemble_options.assembler_version = constants::AssemblerVersion;
+    assemble_options.fixed_time = options.fixed_time;
+    assemble_options.include_cache = shared.includes;
+    assemble_options.working_directory = options.working_directory;
+
+    for (auto& loaded : shared.snapshots) {
+        assemble_options.equ_snapshots.push_back(loaded.snapshot);
+    }
+
+    for (auto& dir : options.include_dirs) {
+        assemble_options.include_directories.push_back(Resolve(options, dir));
+    }
+
+    return assemble_options;
+}
+
+std::string FormatDiagnostics(const std::vector<driver::Diagnostic>& diagnostics, const Job& job) {
+    std::string message {};
+    for (auto& diagnostic : diagnostics) {
+        if (!message.empty()) message += "\n";
+        message += driver::FormatDiagnostic(diagnostic, job.input_path);
+    }
+    return message;
+}
+
+Assembled Assemble(const Options& options, const Shared& shared, const Job& job, const std::string& source) {
+    // Each job gets its own assembler and state. Only the target's static tables are shared.
+    auto result = driver::Assemble(source, DriverOptions(options, shared));
+    if (!result.rof) {
+        throw AssemblyFailed(FormatDiagnostics(result.diagnostics, job));
+    }
+
+    return { std::move(result.rof.value()), std::move(result.included_files) };
+}
+
+std::string ReadSource(const Options& options, const std::string& path) {
+    if (path == "-") {
+        return options.standard_input.value_or("");
+    }
+
+    std::ifstream in_file(Resolve(options, path));
     if (!in_file.is_open()) {
-        std::cerr << "Failed to open input file.";
-        exit(1);
+        throw std::runtime_error("Failed to open input file.");
     }
-    
+
+    std::stringstream source {};
+    source << in_file.rdbuf();
+    return source.str();
+}
+
+void MakeEquSnapshot(const Options& options) {
+    auto source = ReadSource(options, options.jobs.front().input_path);
+    std::istringstream in(source);
+
     assembler::InputFileParser parser {};
-    parser.Parse(in_file);
+    parser.Parse(in);
+
+    auto snapshot = assembler::EquSnapshot::Compile(parser.GetListing());
+
+    std::ofstream out_file(Resolve(options, options.make_equ_path.value()), std::ios::binary | std::ios::trunc);
+    if (!out_file.write(snapshot.data(), snapshot.size())) {
+        throw std::runtime_error("Failed to write " + options.make_equ_path.value());
+    }
+}
+
+/**
+ * Assemble one source to its ROF, or copy the ROF from the cache. Throws on failure.
+ */
+void RunJob(const Options& options, const Shared& shared, const Job& job) {
+    auto source = ReadSource(options, job.input_path);
+    std::string cache_key {};
+
+    if (shared.cache) {
+        // Relative 'use' paths that aren't in an include directory resolve against the working directory.
+        cache_key = amips::AssemblyCache::Key(source, shared.fingerprint, options.working_directory);
+
+        std::optional<std::filesystem::path> entry {};
+        auto dependencies = shared.cache->LookupDependencies(cache_key);
+        if (dependencies) {
+            if (auto key = amips::AssemblyCache::DependentKey(cache_key, dependencies.value())) {
+                entry = shared.cache->Lookup(key.value());
+            }
+        }
+
+        if (entry) {
+            // Cache hit. Skip parsing and assembly entirely.
+            try {
+                std::filesystem::copy_file(entry.value(), Resolve(options, job.output_path),
+                    std::filesystem::copy_options::overwrite_existing);
+
+                if (job.dependency_path) {
+                    WriteDependencies(options, job, dependencies.value());
+                }
+                return;
+            } catch (std::exception const& e) {
+                // Fall through and assemble as usual.
+                std::cerr << "Ignoring unusable cache entry: " << e.what() << std::endl;
+            }
+        }
+    }
+
+    auto [rof, included_files] = Assemble(options, shared, job, source);
+
+    std::ofstream out_file(Resolve(options, job.output_path), std::ios::binary | std::ios::trunc);
+    if (!out_file.write(rof.data(), rof.size())) {
+        throw std::runtime_error("Failed to write " + job.output_path);
+    }
 
-    auto target = std::make_unique<assembler::MipsAssemblerTarget>(support::Endian::big);
-    assembler::Assembler a(constants::AssemblerVersion, std::move(target));
+    if (job.dependency_path) {
+        WriteDependencies(options, job, included_files);
+    }
 
-    auto object = a.Process(parser.GetListing());
+    if (shared.cache) {
+        try {
+            // The ROF goes in first, so that readers never find dependencies without it.
+            if (auto key = amips::AssemblyCache::DependentKey(cache_key, included_files)) {
+                shared.cache->Store(key.value(), rof);
+                shared.cache->StoreDependencies(cache_key, included_files);
+            }
+        } catch (std::exception const& e) {
+            // A cache that can't be written shouldn't fail the build.
+            std::cerr << "Failed to update cache: " << e.what() << std::endl;
+        }
+    }
+}
 
-    rof::Rof15ObjectWriter writer {};
+// Runs the job, returning a description of the failure if there was one.
+std::optional<std::string> TryRunJob(const Options& options, const Shared& shared, const Job& job) {
+    try {
+        RunJob(options, shared, job);
+        return std::nullopt;
+    } catch (AssemblyFailed const& e) {
+        return std::string(e.what());
+    } catch (std::exception const& e) {
+        return job.input_path + ": " + e.what();
+    }
+}
 
-    std::fstream out_file;
-    out_file.exceptions(std::fstream::badbit | std::fstream::failbit);
+/**
+ * Carry out a parsed invocation, reporting failures to errors. Returns the exit status.
+ *
+ * @param includes parsed include files, which may be shared with other runs.
+ * @param pool workers for assembling many sources. If null, a pool is created for the run.
+ */
+int Run(const Options& options, const std::shared_ptr<assembler::IncludeCache>& includes,
+        support::ThreadPool* pool, std::ostream& errors) {
+    if (options.make_equ_path) {
+        try {
+            MakeEquSnapshot(options);
+        } catch (std::exception const& e) {
+            errors << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
+    Shared shared {};
     try {
-        out_file.open("amips_out.r", std::fstream::out | std::fstream::binary);
+        shared.snapshots = LoadSnapshots(options);
     } catch (std::exception const& e) {
-        std::cerr << e.what();
-        exit(1);
+        errors << e.what() << std::endl;
+        return 1;
     }
 
-    writer.Write(*object, out_file);
+    shared.includes = includes;
+    shared.fingerprint = OptionsFingerprint(options, shared.snapshots);
+    if (options.cache_dir) {
+        shared.cache.emplace(Resolve(options, options.cache_dir.value()));
+    }
+
+    std::vector<std::optional<std::string>> failures(options.jobs.size());
+    if (options.jobs.size() == 1 && !pool) {
+        // Not worth starting threads for. A server passes its warm pool, which is always used.
+        failures[0] = TryRunJob(options, shared, options.jobs[0]);
+    } else {
+        std::optional<support::ThreadPool> run_pool {};
+        if (!pool) {
+            pool = &run_pool.emplace(std::min(options.worker_count, options.jobs.size()));
+        }
+
+        // Jobs are independent, so idle workers simply take the next source from the shared queue.
+        std::vector<std::future<std::optional<std::string>>> results {};
+        for (auto& job : options.jobs) {
+            results.push_back(pool->Submit([&options, &shared, &job]() { return TryRunJob(options, shared, job); }));
+        }
+
+        for (std::size_t i = 0; i < results.size(); i++) {
+            failures[i] = results[i].get();
+        }
+    }
+
+    // Report in input order, regardless of which job finished first.
+    int status = 0;
+    for (std::size_t i = 0; i < failures.size(); i++) {
+        if (failures[i]) {
+            errors << failures[i].value() << std::endl;
+            status = 1;
+        }
+    }
+
+    return status;
+}
+
+/**
+ * Serve requests until interrupted. Parsed include files and workers stay warm between requests.
+ */
+int Serve(const Options& options) {
+    auto includes = std::make_shared<assembler::IncludeCache>();
+    support::ThreadPool workers(options.worker_count);
+
+    auto handle = [&includes, &workers](const amips::ServerRequest& request) {
+        Invocation invocation {};
+        invocation.args = request.args;
+        invocation.working_directory = request.working_directory;
+        invocation.standard_input = request.standard_input;
+        for (auto& [name, value] : request.environment) {
+            if (name == "SOURCE_DATE_EPOCH") invocation.source_date_epoch = value;
+            if (name == "AMIPS_CACHE_DIR") invocation.cache_dir = value;
+        }
+
+        std::ostringstream errors {};
+        try {
+            auto request_options = ParseArguments(invocation);
+            if (request_options.serve_socket || !invocation.working_directory.is_absolute()) {
+                Usage("Requests must name sources and come from an absolute working directory.");
+            }
+
+            return amips::ServerResponse { Run(request_options, includes, &workers, errors), errors.str() };
+        } catch (UsageError const& e) {
+            errors << e.what() << std::endl;
+            PrintUsage(errors);
+            return amips::ServerResponse { 1, errors.str() };
+        }
+    };
+
+    try {
+        // Connections mostly wait on workers, so allow plenty of them.
+        amips::AssemblyServer server(Resolve(options, options.serve_socket.value()), 4 * workers.Size(), handle);
+        server.Serve();
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
 
     return 0;
+}
+
+/**
+ * Reassemble the source each time it, an included file or a snapshot changes, until interrupted.
+ *
+ * The listing is kept between passes, and only changed lines are reparsed. Included files
+ * stay parsed until they change.
+ */
+int Watch(const Options& options) {
+    using clock = std::chrono::steady_clock;
+
+    auto& job = options.jobs.front();
+    driver::IncrementalListing listing {};
+    driver::IncrementalAssembly assembly {};
+    amips::FileWatcher watcher {};
+    std::optional<std::string> last_rof {};
+
+    Shared shared {};
+    shared.includes = std::make_shared<assembler::IncludeCache>();
+
+    // Snapshots are reloaded only when their files change, since new snapshots mean a full pass.
+    std::optional<std::vector<std::filesystem::file_time_type>> snapshot_times {};
+
+    while (true) {
+        auto start = clock::now();
+        std::vector<std::filesystem::path> watched { Resolve(options, job.input_path) };
+        for (auto& path : options.equ_paths) {
+            watched.push_back(Resolve(options, path));
+        }
+
+        try {
+            std::vector<std::filesystem::file_time_type> times {};
+            for (auto& path : options.equ_paths) {
+                std::error_code error {};
+                times.push_back(std::filesystem::last_write_time(Resolve(options, path), error));
+            }
+
+            if (times != snapshot_times) {
+                shared.snapshots = LoadSnapshots(options);
+                snapshot_times = std::move(times);
+            }
+
+            auto diagnostics = listing.Update(ReadSource(options, job.input_path));
+            if (!diagnostics.empty()) {
+                throw AssemblyFailed(FormatDiagnostics(diagnostics, job));
+            }
+
+            auto result = assembly.Update(listing.Listing(), DriverOptions(options, shared));
+            watched.insert(watched.end(), result.included_files.begin(), result.included_files.end());
+            if (!result.rof) {
+                throw AssemblyFailed(FormatDiagnostics(result.diagnostics, job));
+            }
+
+            // Leave the output untouched if nothing changed, so that dependents aren't rebuilt.
+            if (result.rof != last_rof) {
+                std::ofstream out_file(Resolve(options, job.output_path), std::ios::binary | std::ios::trunc);
+                if (!out_file.write(result.rof->data(), result.rof->size())) {
+                    throw std::runtime_error("Failed to write " + job.output_path);
+                }
+                last_rof = std::move(result.rof);
+            }
+
+            if (job.dependency_path) {
+                WriteDependencies(options, job, result.included_files);
+            }
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+            std::cerr << "amips: assembled " << job.output_path << " in " << elapsed.count() / 1000.0 << " ms ("
+                      << listing.LastParsedLineCount() << " lines parsed, " << assembly.LastEncodedCount()
+                      << " instructions encoded, " << (assembly.LastKeptLayout() ? "layout kept" : "full pass") << ")"
+                      << std::endl;
+        } catch (AssemblyFailed const& e) {
+            std::cerr << e.what() << std::endl;
+        } catch (std::exception const& e) {
+            std::cerr << job.input_path << ": " << e.what() << std::endl;
+        }
+
+        try {
+            watcher.SetFiles(watched);
+            watcher.WaitForChange();
+        } catch (std::exception const& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+}
+
+/**
+ * Forward the invocation to the server. Returns nullopt if no server is listening.
+ */
+std::optional<int> Forward(const Options& options, const Invocation& invocation) {
+    amips::ServerRequest request {};
+    request.working_directory = invocation.working_directory.string();
+    request.standard_input = invocation.standard_input;
+
+    for (std::size_t i = 0; i < invocation.args.size(); i++) {
+        if (invocation.args[i] == "--connect") {
+            i++;
+            continue;
+        }
+        request.args.push_back(invocation.args[i]);
+    }
+
+    if (invocation.source_date_epoch) request.environment.emplace_back("SOURCE_DATE_EPOCH", invocation.source_date_epoch.value());
+    if (invocation.cache_dir) request.environment.emplace_back("AMIPS_CACHE_DIR", invocation.cache_dir.value());
+
+    try {
+        auto response = amips::ForwardToServer(Resolve(options, options.connect_socket.value()), request);
+        if (!response) {
+            return std::nullopt;
+        }
+
+        std::cerr << response->errors;
+        return response->status;
+    } catch (std::exception const& e) {
+        std::cerr << "amips server: " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+std::optional<std::string> GetEnvironment(const char* name) {
+    auto value = std::getenv(name);
+    if (!value) return std::nullopt;
+
+    return std::string(value);
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    Invocation invocation {};
+    invocation.args.assign(argv + 1, argv + argc);
+    invocation.working_directory = std::filesystem::current_path();
+    invocation.source_date_epoch = GetEnvironment("SOURCE_DATE_EPOCH");
+    invocation.cache_dir = GetEnvironment("AMIPS_CACHE_DIR");
+    invocation.server_socket = GetEnvironment("AMIPS_SERVER");
+    if (invocation.server_socket && invocation.server_socket->empty()) {
+        invocation.server_socket.reset();
+    }
+
+    Options options {};
+    try {
+        options = ParseArguments(invocation);
+    } catch (UsageError const& e) {
+        std::cerr << e.what() << std::endl;
+        PrintUsage(std::cerr);
+        return 1;
+    }
+
+    if (options.serve_socket) {
+        return Serve(options);
+    }
+
+    if (options.watch) {
+        return Watch(options);
+    }
+
+    if (options.jobs.front().input_path == "-") {
+        std::stringstream input {};
+        input << std::cin.rdbuf();
+        invocation.standard_input = options.standard_input = input.str();
+    }
+
+    if (options.connect_socket) {
+        if (auto status = Forward(options, invocation)) {
+            return status.value();
+        }
+        // No server. Assemble locally instead.
+    }
+
+    auto includes = std::make_shared<assembler::IncludeCache>();
+    return Run(options, includes, nullptr, std::cerr);
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace constants {
 constexpr uint16_t AssemblerVersion = 15U;
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+
+#include <AssemblyCache.h>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace amips {
+
+namespace {
+std::filesystem::path MakeTempDirectory() {
+    auto directory = std::filesystem::temp_directory_path() / ("assembly-cache-test-" + std::to_string(getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+void WriteFile(const std::filesystem::path& path, const std::string& contents) {
+    std::ofstream out(path, std::ios::trunc);
+    out << contents;
+}
+
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents {};
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+// Looks up a source the way amips does: by its key, then by the current contents of its recorded includes.
+std::optional<std::string> Lookup(const AssemblyCache& cache, const std::string& key) {
+    auto dependencies = cache.LookupDependencies(key);
+    if (!dependencies) return std::nullopt;
+
+    auto dependent_key = AssemblyCache::DependentKey(key, dependencies.value());
+    if (!dependent_key) return std::nullopt;
+
+    auto entry = cache.Lookup(dependent_key.value());
+    if (!entry) return std::nullopt;
+
+    return ReadFile(entry.value());
+}
+
+void Store(const AssemblyCache& cache, const std::string& key, const std::string& rof,
+        const std::vector<std::filesystem::path>& dependencies) {
+    cache.Store(AssemblyCache::DependentKey(key, dependencies).value(), rof);
+    cache.StoreDependencies(key, dependencies);
+}
+}
+
+SCENARIO("Cached ROFs are reused only where includes resolve the same way", "[amips]") {
+    auto directory = MakeTempDirectory();
+    AssemblyCache cache(directory / "cache");
+
+    const std::string source = " use defs.d\n";
+    const std::string options = "target=mips;endian=big;time=0";
+
+    GIVEN("the same source in two directories, each with its own 'defs.d'") {
+        auto first = directory / "first";
+        auto second = directory / "second";
+        std::filesystem::create_directories(first);
+        std::filesystem::create_directories(second);
+        WriteFile(first / "defs.d", "Size equ 4\n");
+        WriteFile(second / "defs.d", "Size equ 64\n");
+
+        auto first_key = AssemblyCache::Key(source, options, first);
+        Store(cache, first_key, "first rof", { first / "defs.d" });
+
+        THEN("the first directory hits its own entry") {
+            REQUIRE(Lookup(cache, first_key) == "first rof");
+        }
+
+        THEN("the second directory doesn't get the first directory's ROF") {
+            auto second_key = AssemblyCache::Key(source, options, second);
+            REQUIRE(second_key != first_key);
+            REQUIRE_FALSE(Lookup(cache, second_key));
+
+            Store(cache, second_key, "second rof", { second / "defs.d" });
+            REQUIRE(Lookup(cache, second_key) == "second rof");
+            REQUIRE(Lookup(cache, first_key) == "first rof");
+        }
+
+        WHEN("the first directory's include changes") {
+            WriteFile(first / "defs.d", "Size equ 8\n");
+
+            THEN("its entry is no longer found") {
+                REQUIRE_FALSE(Lookup(cache, first_key));
+            }
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+}
\ No newline at end of file
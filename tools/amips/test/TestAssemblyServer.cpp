@@ -0,0 +1,149 @@
+#include <catch2/catch.hpp>
+
+#include <AssemblyServer.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace amips {
+
+namespace {
+std::filesystem::path MakeTempDirectory() {
+    auto directory = std::filesystem::temp_directory_path() / ("assembly-server-test-" + std::to_string(getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
+
+// Describes each request in the response, so that what the server decoded can be checked.
+ServerResponse Echo(const ServerRequest& request) {
+    std::ostringstream errors {};
+    errors << request.working_directory << "|" << request.standard_input.value_or("<none>");
+    for (auto& [name, value] : request.environment) {
+        errors << "|" << name << "=" << value;
+    }
+    for (auto& arg : request.args) {
+        errors << "|" << arg;
+    }
+
+    return ServerResponse { static_cast<int>(request.args.size()), errors.str() };
+}
+
+// Serves on a thread for as long as it's in scope.
+struct RunningServer {
+    explicit RunningServer(const std::filesystem::path& path) : server(path, 2, Echo), thread([this]() { server.Serve(); }) {}
+
+    ~RunningServer() {
+        server.Stop();
+        thread.join();
+    }
+
+    AssemblyServer server;
+    std::thread thread;
+};
+}
+
+SCENARIO("Requests and responses round-trip through the server", "[amips]") {
+    auto directory = MakeTempDirectory();
+    auto socket_path = directory / "server.sock";
+
+    GIVEN("a running server") {
+        RunningServer running(socket_path);
+
+        THEN("its socket is only accessible to its user") {
+            struct stat info {};
+            REQUIRE(lstat(socket_path.c_str(), &info) == 0);
+            REQUIRE((info.st_mode & 077) == 0);
+        }
+
+        WHEN("a request is forwarded") {
+            ServerRequest request {};
+            request.args = { "-o", "out.r", "", "in.a" };
+            request.working_directory = "/some/where";
+            request.environment = { { "AMIPS_PATH", "a:b" } };
+            request.standard_input = std::string("line 1\nline 2\n");
+
+            auto response = ForwardToServer(socket_path, request);
+
+            THEN("the server sees it as sent") {
+                REQUIRE(response);
+                REQUIRE(response->status == 4);
+                REQUIRE(response->errors == "/some/where|line 1\nline 2\n|AMIPS_PATH=a:b|-o|out.r||in.a");
+            }
+        }
+
+        WHEN("a request without standard input is forwarded") {
+            auto response = ForwardToServer(socket_path, ServerRequest { { "x.a" }, "/", {}, std::nullopt });
+
+            THEN("none is seen") {
+                REQUIRE(response);
+                REQUIRE(response->errors == "/|<none>|x.a");
+            }
+        }
+
+        WHEN("another server is started on the same socket") {
+            THEN("it's refused, and the first keeps serving") {
+                REQUIRE_THROWS_WITH(AssemblyServer(socket_path, 1, Echo), Catch::Contains("already in use"));
+                REQUIRE(ForwardToServer(socket_path, ServerRequest { { "x.a" }, "/", {}, std::nullopt }));
+            }
+        }
+    }
+
+    GIVEN("no server") {
+        THEN("forwarding reports that none is listening") {
+            REQUIRE_FALSE(ForwardToServer(socket_path, ServerRequest {}));
+        }
+    }
+
+    GIVEN("a file which isn't a socket") {
+        std::ofstream(socket_path) << "source";
+
+        THEN("a server won't replace it") {
+            REQUIRE_THROWS_WITH(AssemblyServer(socket_path, 1, Echo), Catch::Contains("isn't a socket"));
+            REQUIRE(std::filesystem::file_size(socket_path) == 6);
+        }
+    }
+
+    GIVEN("a stale socket, left by a server which didn't shut down cleanly") {
+        {
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            sockaddr_un address {};
+            address.sun_family = AF_UNIX;
+            std::strcpy(address.sun_path, socket_path.c_str());
+            REQUIRE(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+            close(fd);
+        }
+
+        THEN("a server replaces it") {
+            RunningServer running(socket_path);
+            REQUIRE(ForwardToServer(socket_path, ServerRequest { { "x.a" }, "/", {}, std::nullopt }));
+        }
+    }
+
+    GIVEN("a server whose socket was replaced by a newer server's") {
+        std::optional<RunningServer> older(std::in_place, socket_path);
+        std::filesystem::remove(socket_path);
+        RunningServer newer(socket_path);
+
+        WHEN("the older server shuts down") {
+            older.reset();
+
+            THEN("the newer server's socket is left in place") {
+                REQUIRE(ForwardToServer(socket_path, ServerRequest { { "x.a" }, "/", {}, std::nullopt }));
+            }
+        }
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+}
\ No newline at end of file
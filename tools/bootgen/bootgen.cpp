@@ -0,0 +1,256 @@
+#include <FileCopy.h>
+#include <MappedFile.h>
+#include <Module.hpp>
+#include <ThreadPool.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+
+struct Options {
+    std::vector<std::string> module_paths {};
+    std::string output_path {};
+    std::optional<std::string> manifest_path {};
+    std::size_t alignment = 1;
+    unsigned int jobs = support::ThreadPool::DefaultThreadCount();
+};
+
+struct Entry {
+    std::string path;
+
+    // The checked file, kept open so that it is what gets copied, even if the path is replaced meanwhile.
+    int descriptor = -1;
+    std::string name {};
+    std::size_t size = 0;
+    std::size_t offset = 0;
+    std::string error {};
+};
+
+[[noreturn]] void Usage(const std::string& error) {
+    std::cerr << error << std::endl;
+    std::cerr << "usage: bootgen [options] -o <bootfile> <module>..." << std::endl
+              << "Checks each module, then concatenates them into a bootfile." << std::endl
+              << "  -o <file>            write the bootfile to <file>" << std::endl
+              << "  -m <file>            write the manifest of module offsets to <file> (default: stdout)" << std::endl
+              << "  --align <bytes>      start each module on a multiple of <bytes>, padding with zeros (default: 1)" << std::endl
+              << "  -j <count>           check modules on up to <count> threads (default: hardware threads)" << std::endl;
+    exit(1);
+}
+
+// Far more threads than any machine needs, but few enough to create.
+constexpr unsigned long MaxJobs = 1024;
+
+unsigned long Number(const std::string& arg, const std::string& value, unsigned long min, unsigned long max) {
+    try {
+        // stoul would accept a sign or leading spaces, and wrap negative numbers.
+        std::size_t end = 0;
+        auto number = std::stoul(value, &end, 0);
+        if (!value.empty() && std::isdigit(static_cast<unsigned char>(value.front())) && end == value.size()
+            && number >= min && number <= max) {
+            return number;
+        }
+    } catch (std::exception const&) {
+    }
+
+    Usage(arg + " must be a number from " + std::to_string(min) + " to " + std::to_string(max) + ".");
+}
+
+Options ParseArguments(int argc, const char* argv[]) {
+    Options options {};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) Usage("Missing value for " + arg + ".");
+            return argv[++i];
+        };
+
+        if (arg == "-o") {
+            options.output_path = value();
+        } else if (arg == "-m") {
+            options.manifest_path = value();
+        } else if (arg == "--align") {
+            options.alignment = Number(arg, value(), 1, std::numeric_limits<uint32_t>::max());
+            if (options.alignment == 0 || (options.alignment & (options.alignment - 1)) != 0) {
+                Usage("--align must be a power of two.");
+            }
+        } else if (arg == "-j") {
+            options.jobs = static_cast<unsigned int>(Number(arg, value(), 1, MaxJobs));
+        } else if (!arg.empty() && arg.front() == '-') {
+            Usage("Unknown option: " + arg);
+        } else {
+            options.module_paths.push_back(arg);
+        }
+    }
+
+    if (options.output_path.empty()) {
+        Usage("No bootfile specified.");
+    }
+
+    if (options.module_paths.empty()) {
+        Usage("No modules specified.");
+    }
+
+    return options;
+}
+
+// Each module is mapped only to be checked. Its bytes are copied into the bootfile later, by the kernel,
+// from the same descriptor.
+Entry Check(const std::string& path) {
+    Entry entry { path };
+
+    entry.descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (entry.descriptor < 0) {
+        entry.error = std::string("Failed to open: ") + std::strerror(errno);
+        return entry;
+    }
+
+    try {
+        auto check = module::CheckModuleFile(support::MappedFile(entry.descriptor, path));
+        entry.name = check.name;
+        entry.size = check.size;
+
+        if (!check.header_valid) {
+            entry.error = "invalid header parity";
+        } else if (!check.crc_valid) {
+            entry.error = "invalid CRC";
+        }
+    } catch (std::exception const& e) {
+        entry.error = e.what();
+    }
+    return entry;
+}
+
+// The bootfile is built beside the output and renamed over it, so a failed build leaves any old one intact.
+void Assemble(const std::vector<Entry>& entries, const std::string& output_path, std::size_t total_size) {
+    auto temp_path = output_path + ".tmp" + std::to_string(getpid());
+    int out = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (out < 0) {
+        throw std::runtime_error("Failed to open " + temp_path + ": " + std::strerror(errno));
+    }
+
+    try {
+        for (auto& entry : entries) {
+            support::CopyFileRange(entry.descriptor, 0, out, static_cast<off_t>(entry.offset), entry.size);
+        }
+
+        // Padding is never written. Extending the file past the last module fills any gaps with zeros.
+        if (ftruncate(out, static_cast<off_t>(total_size)) != 0) {
+            throw std::runtime_error("Failed to size " + output_path + ": " + std::strerror(errno));
+        }
+        if (close(out) != 0) {
+            out = -1;
+            throw std::runtime_error("Failed to write " + temp_path + ": " + std::strerror(errno));
+        }
+        out = -1;
+
+        if (rename(temp_path.c_str(), output_path.c_str()) != 0) {
+            throw std::runtime_error("Failed to replace " + output_path + ": " + std::strerror(errno));
+        }
+    } catch (...) {
+        if (out >= 0) close(out);
+        unlink(temp_path.c_str());
+        throw;
+    }
+}
+
+void WriteManifest(const std::vector<Entry>& entries, std::size_t total_size, std::ostream& out) {
+    char line[64];
+    for (auto& entry : entries) {
+        std::snprintf(line, sizeof(line), "0x%08zX %10zu  ", entry.offset, entry.size);
+        out << line << entry.name << "  " << entry.path << std::endl;
+    }
+
+    std::snprintf(line, sizeof(line), "0x%08zX %10s  ", total_size, "");
+    out << line << "end" << std::endl;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    auto options = ParseArguments(argc, argv);
+
+    // Every module stays open from its check until it's copied, so allow as many open files as permitted.
+    struct rlimit limit {};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    // Replacing an input would lose it, even though it's only replaced once the bootfile is built.
+    for (auto& path : options.module_paths) {
+        std::error_code error {};
+        if (std::filesystem::equivalent(options.output_path, path, error)) {
+            std::cerr << "The bootfile " << options.output_path << " is also an input." << std::endl;
+            exit(1);
+        }
+    }
+
+    std::vector<Entry> entries {};
+    {
+        support::ThreadPool pool(options.jobs);
+        std::vector<std::future<Entry>> checks {};
+        for (auto& path : options.module_paths) {
+            checks.push_back(pool.Submit([&path]() { return Check(path); }));
+        }
+
+        for (auto& check : checks) {
+            entries.push_back(check.get());
+        }
+    }
+
+    bool valid = true;
+    for (auto& entry : entries) {
+        if (!entry.error.empty()) {
+            std::cerr << entry.path << ": " << entry.error << std::endl;
+            valid = false;
+        }
+    }
+
+    if (!valid) {
+        exit(1);
+    }
+
+    std::size_t offset = 0;
+    for (auto& entry : entries) {
+        offset = (offset + options.alignment - 1) & ~(options.alignment - 1);
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    try {
+        Assemble(entries, options.output_path, offset);
+
+        if (options.manifest_path) {
+            std::ofstream manifest;
+            manifest.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+            manifest.open(*options.manifest_path);
+            WriteManifest(entries, offset, manifest);
+        } else {
+            WriteManifest(entries, offset, std::cout);
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        exit(1);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include <MappedFile.h>
+#include <ModulePatcher.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Patch {
+    std::size_t offset;
+    std::string bytes;
+};
+
+struct Options {
+    std::vector<std::string> module_paths {};
+
+    // Applied to each module, in order.
+    std::vector<std::function<void(module::ModulePatcher&)>> edits {};
+    std::vector<Patch> patches {};
+
+    // Recompute the CRC over the whole module, rather than only over the patched bytes.
+    bool rebuild = false;
+};
+
+[[noreturn]] void Usage(const std::string& error) {
+    std::cerr << error << std::endl;
+    std::cerr << "usage: fixmod [options] <module>..." << std::endl
+              << "Patches OS-9 modules in place, then updates their header parity and CRC." << std::endl
+              << "  --edition <n>            set the edition" << std::endl
+              << "  --stack <n>              set the minimum stack size" << std::endl
+              << "  --attributes <n>         set the attributes and revision word" << std::endl
+              << "  --access <n>             set the access permissions" << std::endl
+              << "  --type-language <n>      set the type and language word" << std::endl
+              << "  --patch <offset>=<hex>   overwrite bytes at <offset> with <hex>, e.g. 0x100=deadbeef" << std::endl
+              << "  --rebuild                recompute the CRC over each whole module, e.g. if it was invalid" << std::endl;
+    exit(1);
+}
+
+// Accepts decimal, or hex with a 0x prefix.
+uint32_t ParseNumber(const std::string& option, const std::string& text, uint32_t max) {
+    try {
+        std::size_t end = 0;
+        auto value = std::stoull(text, &end, 0);
+        if (end == text.size() && value <= max) return static_cast<uint32_t>(value);
+    } catch (std::exception const&) {
+    }
+
+    Usage(option + " must be a number no greater than " + std::to_string(max) + ".");
+}
+
+std::string ParseHex(const std::string& text) {
+    if (text.empty() || text.size() % 2 != 0) Usage("Patch bytes must be an even number of hex digits.");
+
+    std::string bytes {};
+    for (std::size_t i = 0; i < text.size(); i += 2) {
+        auto digits = text.substr(i, 2);
+        if (digits.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+            Usage("Patch bytes must be hex digits: " + text);
+        }
+        bytes.push_back(static_cast<char>(std::stoi(digits, nullptr, 16)));
+    }
+    return bytes;
+}
+
+Options ParseArguments(int argc, const char* argv[]) {
+    Options options {};
+    constexpr auto max16 = std::numeric_limits<uint16_t>::max();
+    constexpr auto max32 = std::numeric_limits<uint32_t>::max();
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) Usage("Missing value for " + arg + ".");
+            return argv[++i];
+        };
+
+        if (arg == "--edition") {
+            auto edition = static_cast<uint16_t>(ParseNumber(arg, value(), max16));
+            options.edits.emplace_back([edition](auto& patcher) { patcher.SetEdition(edition); });
+        } else if (arg == "--stack") {
+            auto stack = ParseNumber(arg, value(), max32);
+            options.edits.emplace_back([stack](auto& patcher) { patcher.SetMinStackSize(stack); });
+        } else if (arg == "--attributes") {
+            auto attributes = static_cast<uint16_t>(ParseNumber(arg, value(), max16));
+            options.edits.emplace_back([attributes](auto& patcher) { patcher.SetAttributesRevision(attributes); });
+        } else if (arg == "--access") {
+            auto access = static_cast<uint16_t>(ParseNumber(arg, value(), max16));
+            options.edits.emplace_back([access](auto& patcher) { patcher.SetAccess(access); });
+        } else if (arg == "--type-language") {
+            auto type_language = static_cast<uint16_t>(ParseNumber(arg, value(), max16));
+            options.edits.emplace_back([type_language](auto& patcher) { patcher.SetTypeLanguage(type_language); });
+        } else if (arg == "--patch") {
+            auto patch = value();
+            auto equals = patch.find('=');
+            if (equals == std::string::npos) Usage("--patch must be <offset>=<hex>.");
+            options.patches.push_back(Patch {
+                ParseNumber(arg, patch.substr(0, equals), max32),
+                ParseHex(patch.substr(equals + 1))
+            });
+        } else if (arg == "--rebuild") {
+            options.rebuild = true;
+        } else if (!arg.empty() && arg.front() == '-') {
+            Usage("Unknown option: " + arg);
+        } else {
+            options.module_paths.push_back(arg);
+        }
+    }
+
+    if (options.module_paths.empty()) {
+        Usage("No modules specified.");
+    }
+
+    return options;
+}
+
+void Fix(const Options& options, const std::string& path) {
+    support::MappedFile file(path, support::MappedFile::Access::ReadWrite);
+    module::ModulePatcher patcher(file.MutableData(), file.Size());
+
+    // Nothing is written unless every patch fits, since writes go straight to the file.
+    for (auto& patch : options.patches) {
+        patcher.CheckWritable(patch.offset, patch.bytes.size());
+    }
+
+    for (auto& edit : options.edits) {
+        edit(patcher);
+    }
+
+    for (auto& patch : options.patches) {
+        patcher.Write(patch.offset, patch.bytes.data(), patch.bytes.size());
+    }
+
+    auto complement = options.rebuild ? patcher.Rebuild() : patcher.Commit();
+    file.Sync();
+
+    std::printf("%s: crc $%06X\n", path.c_str(), complement);
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    auto options = ParseArguments(argc, argv);
+
+    int status = 0;
+    for (auto& path : options.module_paths) {
+        try {
+            Fix(options, path);
+        } catch (std::exception const& e) {
+            std::cerr << path << ": " << e.what() << std::endl;
+            status = 1;
+        }
+    }
+
+    return status;
+}
\ No newline at end of file
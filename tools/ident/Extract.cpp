@@ -0,0 +1,69 @@
+#include "Extract.h"
+
+#include <FileCopy.h>
+
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ident {
+
+bool ModuleFilter::IsSet() const {
+    return name || type || language || edition;
+}
+
+bool ModuleFilter::Matches(const module::ScannedModule& scanned, const module::ModuleHeaderView& header) const {
+    auto type_language = header.TypeLanguage();
+    return (!name || scanned.name == *name)
+        && (!type || type_language >> 8U == *type)
+        && (!language || (type_language & 0xFFU) == *language)
+        && (!edition || header.Edition() == *edition);
+}
+
+std::string FileNameFor(const std::string& name) {
+    std::string file_name {};
+    for (auto c : name) {
+        file_name.push_back(std::isalnum(static_cast<unsigned char>(c)) || c == '.' || c == '_' || c == '-' ? c : '_');
+    }
+    if (file_name.empty() || file_name.front() == '.') file_name.insert(0, "module");
+    return file_name;
+}
+
+std::string Extract(int image, const module::ScannedModule& scanned, const std::filesystem::path& directory) {
+    auto base_name = FileNameFor(scanned.name);
+    auto file_name = base_name;
+    auto path = directory / file_name;
+
+    int out = -1;
+    for (std::size_t counter = 1; (out = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644)) < 0; counter++) {
+        if (errno != EEXIST) {
+            throw std::runtime_error("Failed to open " + path.string() + ": " + std::strerror(errno));
+        }
+
+        file_name = base_name + "_" + std::to_string(counter);
+        path = directory / file_name;
+    }
+
+    // The file was created for this module, so a partial copy is removed rather than left behind.
+    try {
+        support::CopyFileRange(image, static_cast<off_t>(scanned.offset), out, 0, scanned.size);
+    } catch (...) {
+        close(out);
+        unlink(path.c_str());
+        throw;
+    }
+
+    if (close(out) != 0) {
+        auto error = errno;
+        unlink(path.c_str());
+        throw std::runtime_error("Failed to write " + path.string() + ": " + std::strerror(error));
+    }
+
+    return file_name;
+}
+
+}
\ No newline at end of file
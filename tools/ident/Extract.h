@@ -0,0 +1,41 @@
+#pragma once
+
+#include <ModuleHeaderView.hpp>
+#include <ModuleScanner.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+namespace ident {
+
+/**
+ * Selects the modules a scan reports and extracts. A module matches if it passes every
+ * filter which is set.
+ */
+struct ModuleFilter {
+    std::optional<std::string> name {};
+    std::optional<uint8_t> type {};
+    std::optional<uint8_t> language {};
+    std::optional<uint16_t> edition {};
+
+    bool IsSet() const;
+    bool Matches(const module::ScannedModule& scanned, const module::ModuleHeaderView& header) const;
+};
+
+/**
+ * A plain file name for a module. Names come from the image, so any character which isn't a
+ * letter, digit, '.', '_' or '-' is replaced, and names which are empty or hidden are prefixed.
+ */
+std::string FileNameFor(const std::string& name);
+
+/**
+ * Copy the module out of the image open on image, into a new file in directory named after it,
+ * and return the file's name. Existing files are never replaced: "_1", "_2" and so on are
+ * added to the name until it's unused. The bytes are copied by the kernel, straight from the
+ * image to the new file.
+ */
+std::string Extract(int image, const module::ScannedModule& scanned, const std::filesystem::path& directory);
+
+}
\ No newline at end of file
@@ -25,48 +25,290 @@
 // (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include <fstream>
-#include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
 
+#include "Extract.h"
+#include "MappedFile.h"
 #include "Module.hpp"
-#include "ModuleHeader.hpp"
-#include "ModuleUtils.hpp"
+#include "ModuleHeaderView.hpp"
 #include "ModuleInfoPrinter.hpp"
-
-#include "Serialization.h"
+#include "ModuleScanner.hpp"
+#include "ThreadPool.h"
 
 using namespace module;
 
+namespace {
+
+struct Options {
+    std::vector<std::string> paths {};
+    unsigned int jobs = support::ThreadPool::DefaultThreadCount();
+
+    // Check every module and print a line for each, rather than describing a single module.
+    bool batch = false;
+
+    // Search each file for the modules within it, e.g. a bootfile or ROM image.
+    bool scan = false;
+
+    // Write each module found by a scan to its own file in this directory.
+    std::optional<std::string> extract_directory {};
+
+    // Scans only report, and extract, the modules which match it.
+    ident::ModuleFilter filter {};
+};
+
+struct CheckResult {
+    bool valid = false;
+    std::size_t size = 0;
+    std::string line {};
+};
+
+[[noreturn]] void Usage(const std::string& error) {
+    std::cerr << error << std::endl;
+    std::cerr << "usage: ident [options] <module>..." << std::endl
+              << "Describes a module. Given several modules or a directory, checks each in batch mode." << std::endl
+              << "  -b                batch mode, even for a single module" << std::endl
+              << "  -s                scan each file for the modules within it, e.g. a bootfile" << std::endl
+              << "  -x <directory>    scan, and write each module found to a new file in <directory>" << std::endl
+              << "  --name <name>     scan only for modules named <name>" << std::endl
+              << "  --type <n>        scan only for modules of type <n>" << std::endl
+              << "  --language <n>    scan only for modules of language <n>" << std::endl
+              << "  --edition <n>     scan only for modules of edition <n>" << std::endl
+              << "  -j <count>        check modules on up to <count> threads (default: hardware threads)" << std::endl;
+    exit(1);
+}
+
+unsigned long Number(const std::string& arg, const std::string& value, unsigned long max) {
+    try {
+        std::size_t end = 0;
+        auto number = std::stoul(value, &end, 0);
+        if (end == value.size() && number <= max) return number;
+    } catch (std::exception const&) {
+    }
+
+    Usage(arg + " must be a number no greater than " + std::to_string(max) + ".");
+}
+
+Options ParseArguments(int argc, const char* argv[]) {
+    Options options {};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) Usage("Missing value for " + arg + ".");
+            return argv[++i];
+        };
+
+        if (arg == "-b") {
+            options.batch = true;
+        } else if (arg == "-s") {
+            options.scan = true;
+        } else if (arg == "-x") {
+            options.scan = true;
+            options.extract_directory = value();
+        } else if (arg == "--name") {
+            options.filter.name = value();
+        } else if (arg == "--type") {
+            options.filter.type = static_cast<uint8_t>(Number(arg, value(), 0xFF));
+        } else if (arg == "--language") {
+            options.filter.language = static_cast<uint8_t>(Number(arg, value(), 0xFF));
+        } else if (arg == "--edition") {
+            options.filter.edition = static_cast<uint16_t>(Number(arg, value(), 0xFFFF));
+        } else if (arg == "-j") {
+            options.jobs = static_cast<unsigned int>(Number(arg, value(), std::numeric_limits<unsigned int>::max()));
+        } else if (!arg.empty() && arg.front() == '-') {
+            Usage("Unknown option: " + arg);
+        } else {
+            options.paths.push_back(arg);
+        }
+    }
+
+    if (options.paths.empty()) {
+        Usage("No modules specified.");
+    }
+
+    if (!options.scan && options.filter.IsSet()) {
+        Usage("Filters only apply to -s and -x.");
+    }
+
+    if (options.paths.size() > 1 || std::filesystem::is_directory(options.paths.front())) {
+        options.batch = true;
+    }
+
+    return options;
+}
+
+// Directories are searched recursively. Their files are visited in sorted order, so output is stable.
+std::vector<std::string> ExpandPaths(const std::vector<std::string>& paths) {
+    std::vector<std::string> files {};
+    for (auto& path : paths) {
+        if (!std::filesystem::is_directory(path)) {
+            files.push_back(path);
+            continue;
+        }
+
+        std::vector<std::string> found {};
+        for (auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+            if (entry.is_regular_file()) found.push_back(entry.path().string());
+        }
+
+        std::sort(found.begin(), found.end());
+        files.insert(files.end(), found.begin(), found.end());
+    }
+    return files;
+}
+
+CheckResult Check(const std::string& path) {
+    CheckResult result {};
+    try {
+        auto check = CheckModuleFile(support::MappedFile(path));
+        result.size = check.size;
+        result.valid = check.header_valid && check.crc_valid;
+
+        result.line = path + ": " + check.name + ", " + std::to_string(check.size) + " bytes, edition "
+            + std::to_string(check.edition) + ", parity " + (check.header_valid ? "ok" : "BAD")
+            + ", crc " + (check.crc_valid ? "ok" : "BAD");
+    } catch (std::exception const& e) {
+        result.line = path + ": " + e.what();
+    }
+    return result;
+}
+
+int Batch(const Options& options) {
+    std::vector<std::string> files {};
+    try {
+        files = ExpandPaths(options.paths);
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::future<CheckResult>> results {};
+    results.reserve(files.size());
+
+    support::ThreadPool pool(options.jobs);
+    for (auto& file : files) {
+        results.push_back(pool.Submit([&file]() { return Check(file); }));
+    }
+
+    // Results are printed in the order of the files, as each becomes ready.
+    std::size_t failed = 0;
+    std::size_t total_bytes = 0;
+    for (auto& future : results) {
+        auto result = future.get();
+        std::cout << result.line << std::endl;
+        if (!result.valid) failed++;
+        total_bytes += result.size;
+    }
+
+    std::cout << files.size() << " files, " << files.size() - failed << " valid, " << failed << " failed, "
+              << total_bytes << " bytes" << std::endl;
+
+    return failed == 0 ? 0 : 1;
+}
+
+int Scan(const Options& options) {
+    std::size_t found = 0;
+    std::size_t failed = 0;
+
+    try {
+        if (options.extract_directory) {
+            std::filesystem::create_directories(*options.extract_directory);
+        }
+
+        for (auto& path : ExpandPaths(options.paths)) {
+            // Modules are extracted through the descriptor that was scanned, so they're the bytes that were checked.
+            int image_descriptor = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (image_descriptor < 0) {
+                throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+            }
+
+            std::size_t matched = 0;
+            std::size_t module_bytes = 0;
+            std::size_t image_size = 0;
+            try {
+                support::MappedFile image(image_descriptor, path);
+                image_size = image.Size();
+                auto modules = ScanImage(image.Data(), image.Size(), options.jobs);
+
+                std::cout << path << ":" << std::endl;
+                for (auto& scanned : modules) {
+                    ModuleHeaderView header(image.Data() + scanned.offset, scanned.size);
+                    if (!options.filter.Matches(scanned, header)) continue;
+
+                    char offset[16];
+                    std::snprintf(offset, sizeof(offset), "0x%08zX", scanned.offset);
+                    std::cout << "  " << offset << ": " << scanned.name << ", " << scanned.size << " bytes, edition "
+                              << header.Edition() << ", crc " << (scanned.crc_valid ? "ok" : "BAD");
+
+                    if (options.extract_directory) {
+                        std::cout << " -> " << ident::Extract(image_descriptor, scanned, *options.extract_directory);
+                    }
+                    std::cout << std::endl;
+
+                    if (!scanned.crc_valid) failed++;
+                    matched++;
+                    module_bytes += scanned.size;
+                }
+            } catch (...) {
+                close(image_descriptor);
+                throw;
+            }
+            close(image_descriptor);
+
+            std::cout << "  " << matched << " modules, " << module_bytes << " of " << image_size
+                      << " bytes" << std::endl;
+            found += matched;
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    std::cout << found << " modules, " << found - failed << " valid, " << failed << " failed" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
+
+}
+
 int main(int argc, const char* argv[])
 {
-    std::fstream file;
-    file.exceptions(std::fstream::badbit | std::fstream::failbit | std::fstream::eofbit);
+    auto options = ParseArguments(argc, argv);
+    if (options.scan) {
+        return Scan(options);
+    }
 
+    if (options.batch) {
+        return Batch(options);
+    }
+
+    // The module is read in place from the mapping, so large images aren't copied.
+    std::unique_ptr<Module> module;
     try {
-        file.open(argv[1], std::fstream::in | std::fstream::binary);
+        module = std::make_unique<Module>(support::MappedFile(options.paths.front()));
     } catch (std::exception const& e) {
-        std::cerr << e.what();
+        std::cerr << e.what() << std::endl;
         exit(1);
     }
 
-    // deserialize module header
-    file.seekg(0);
-    auto header = std::make_shared<ModuleHeader>();
-    auto serializable = static_cast<SerializableModuleHeader*>(header.get());
-    serializer::Deserialize<support::Endian::big>(*serializable, file);
-
-    // read entire module to memory
-    file.seekg(0);
-    auto module_raw = std::make_unique<char[]>(header->Size()); // TODO: size could be wrong if incorrect in module
-    file.read(module_raw.get(), header->Size());
+    //assert(module->IsHeaderValid());
+    assert(module->IsCrcValid());
 
-    Module module(header, std::move(module_raw));
-    //assert(module.IsHeaderValid());
-    assert(module.IsCrcValid());
-
-    util::PrintModuleInfo(module, std::cout);
+    util::PrintModuleInfo(*module, std::cout);
 
     return 0;
-}
+}
\ No newline at end of file
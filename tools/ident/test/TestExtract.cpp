@@ -0,0 +1,140 @@
+#include <catch2/catch.hpp>
+
+#include "Extract.h"
+#include "ModuleHelpers.h"
+
+#include <ModulePatcher.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace ident {
+
+namespace {
+std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents {};
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+std::string MakeModule(std::size_t size, const std::string& name, uint16_t type_language, uint16_t edition) {
+    auto module = module::MakeModule(size, name, '\x5A');
+    module::ModulePatcher patcher(module.data(), module.size());
+    patcher.SetTypeLanguage(type_language);
+    patcher.SetEdition(edition);
+    patcher.Commit();
+    return module;
+}
+}
+
+SCENARIO("Scanned modules are filtered by their header", "[ident]") {
+    auto image = std::string(64, '\0') + MakeModule(256, "init", 0x0C01, 3) + MakeModule(320, "shell", 0x1101, 7);
+    auto modules = module::ScanImage(image.data(), image.size(), 1);
+    REQUIRE(modules.size() == 2);
+
+    auto matching = [&](const ModuleFilter& filter) {
+        std::vector<std::string> names {};
+        for (auto& scanned : modules) {
+            module::ModuleHeaderView header(image.data() + scanned.offset, scanned.size);
+            if (filter.Matches(scanned, header)) names.push_back(scanned.name);
+        }
+        return names;
+    };
+
+    GIVEN("no filters") {
+        ModuleFilter filter {};
+
+        THEN("it isn't set, and every module matches") {
+            REQUIRE_FALSE(filter.IsSet());
+            REQUIRE(matching(filter) == std::vector<std::string> {"init", "shell"});
+        }
+    }
+
+    GIVEN("a single filter") {
+        THEN("only the modules it selects match") {
+            REQUIRE(matching(ModuleFilter {"shell"}) == std::vector<std::string> {"shell"});
+            REQUIRE(matching(ModuleFilter {{}, 0x0C}) == std::vector<std::string> {"init"});
+            REQUIRE(matching(ModuleFilter {{}, {}, 0x01}) == std::vector<std::string> {"init", "shell"});
+            REQUIRE(matching(ModuleFilter {{}, {}, {}, 7}) == std::vector<std::string> {"shell"});
+            REQUIRE(ModuleFilter {{}, {}, {}, 7}.IsSet());
+        }
+    }
+
+    GIVEN("several filters") {
+        THEN("a module must pass all of them") {
+            REQUIRE(matching(ModuleFilter {"init", 0x0C, 0x01, 3}) == std::vector<std::string> {"init"});
+            REQUIRE(matching(ModuleFilter {"init", 0x11}).empty());
+            REQUIRE(matching(ModuleFilter {{}, {}, 0x02}).empty());
+        }
+    }
+}
+
+SCENARIO("Module names become plain file names", "[ident]") {
+    REQUIRE(FileNameFor("init") == "init");
+    REQUIRE(FileNameFor("sys_mod-2.v1") == "sys_mod-2.v1");
+    REQUIRE(FileNameFor("a/b") == "a_b");
+    REQUIRE(FileNameFor("/etc/passwd") == "_etc_passwd");
+    REQUIRE(FileNameFor("..") == "module..");
+    REQUIRE(FileNameFor(".hidden") == "module.hidden");
+    REQUIRE(FileNameFor("") == "module");
+    REQUIRE(FileNameFor("a b\n\xFF") == "a_b__");
+}
+
+SCENARIO("Modules are extracted into new files", "[ident]") {
+    auto directory = std::filesystem::temp_directory_path() / ("ident-extract-test-" + std::to_string(getpid()));
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    auto module = MakeModule(256, "../init", 0x0C01, 1);
+    auto contents = std::string(100, '\x01') + module + std::string(50, '\x02');
+    std::ofstream(directory / "image", std::ios::binary) << contents;
+
+    auto image = open((directory / "image").c_str(), O_RDONLY | O_CLOEXEC);
+    REQUIRE(image >= 0);
+    auto modules = module::ScanImage(contents.data(), contents.size(), 1);
+    REQUIRE(modules.size() == 1);
+    REQUIRE(modules[0].offset == 100);
+
+    GIVEN("an empty directory") {
+        THEN("the module is copied from its offset, under a sanitised name") {
+            REQUIRE(Extract(image, modules[0], directory) == "module.._init");
+            REQUIRE(ReadFile(directory / "module.._init") == module);
+        }
+    }
+
+    GIVEN("files already named after the module") {
+        std::ofstream(directory / "module.._init") << "first";
+        std::ofstream(directory / "module.._init_1") << "second";
+
+        THEN("the next unused suffix is taken, and the existing files are kept") {
+            REQUIRE(Extract(image, modules[0], directory) == "module.._init_2");
+            REQUIRE(Extract(image, modules[0], directory) == "module.._init_3");
+            REQUIRE(ReadFile(directory / "module.._init_2") == module);
+            REQUIRE(ReadFile(directory / "module.._init_3") == module);
+            REQUIRE(ReadFile(directory / "module.._init") == "first");
+            REQUIRE(ReadFile(directory / "module.._init_1") == "second");
+        }
+    }
+
+    GIVEN("a module which runs past the end of the image") {
+        auto truncated = modules[0];
+        truncated.size = contents.size();
+
+        THEN("extracting it fails, and no partial file is left") {
+            REQUIRE_THROWS_AS(Extract(image, truncated, directory), std::runtime_error);
+            REQUIRE_FALSE(std::filesystem::exists(directory / "module.._init"));
+        }
+    }
+
+    close(image);
+    std::filesystem::remove_all(directory);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#include <Linker.h>
+#include <Rof15ObjectReader.h>
+#include <RofArchive.h>
+#include <ThreadPool.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Options {
+    std::vector<std::string> input_paths {};
+    std::vector<std::string> archive_paths {};
+    std::optional<std::string> output_path {};
+    linker::ModuleOptions module {};
+    unsigned int jobs = support::ThreadPool::DefaultThreadCount();
+};
+
+[[noreturn]] void Usage(const std::string& error) {
+    std::cerr << error << std::endl;
+    std::cerr << "usage: lmips [options] <rof>..." << std::endl
+              << "  -o <file>          write the module to <file> (default: the module name)" << std::endl
+              << "  -n <name>          module name (default: name of the first ROF)" << std::endl
+              << "  -e <edition>       module edition (default: edition of the first ROF)" << std::endl
+              << "  -l <archive>       search <archive> for undefined symbols" << std::endl
+              << "  -p <permissions>   module access permissions (default: 0x555)" << std::endl
+              << "  -a <attr/rev>      module attributes and revision (default: 0x8000)" << std::endl
+              << "  --stack <bytes>    stack to add to what the ROFs require" << std::endl
+              << "  -j <count>         link on up to <count> threads (default: hardware threads)" << std::endl;
+    exit(1);
+}
+
+unsigned long Number(const std::string& arg, const std::string& value) {
+    try {
+        return std::stoul(value, nullptr, 0);
+    } catch (std::exception const&) {
+        Usage(arg + " must be a number.");
+    }
+}
+
+Options ParseArguments(int argc, const char* argv[]) {
+    Options options {};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) Usage("Missing value for " + arg + ".");
+            return argv[++i];
+        };
+
+        if (arg == "-o") {
+            options.output_path = value();
+        } else if (arg == "-n") {
+            options.module.name = value();
+        } else if (arg == "-e") {
+            options.module.edition = static_cast<uint16_t>(Number(arg, value()));
+        } else if (arg == "-l") {
+            options.archive_paths.push_back(value());
+        } else if (arg == "-p") {
+            options.module.access = static_cast<uint16_t>(Number(arg, value()));
+        } else if (arg == "-a") {
+            options.module.attributes_revision = static_cast<uint16_t>(Number(arg, value()));
+        } else if (arg == "--stack") {
+            options.module.extra_stack = static_cast<uint32_t>(Number(arg, value()));
+        } else if (arg == "-j") {
+            options.jobs = static_cast<unsigned int>(Number(arg, value()));
+        } else if (!arg.empty() && arg.front() == '-') {
+            Usage("Unknown option: " + arg);
+        } else {
+            options.input_paths.push_back(arg);
+        }
+    }
+
+    if (options.input_paths.empty()) {
+        Usage("No ROF files specified.");
+    }
+
+    return options;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    auto options = ParseArguments(argc, argv);
+
+    linker::Linker linker(options.jobs);
+    std::string first_name {};
+
+    std::vector<char> module {};
+    try {
+        for (auto& path : options.input_paths) {
+            auto object = std::make_shared<rof::Rof15ObjectReader>(path);
+            if (first_name.empty()) first_name = object->Header().Name();
+            linker.AddObject(std::move(object));
+        }
+
+        for (auto& path : options.archive_paths) {
+            linker.AddArchive(std::make_shared<rof::RofArchive>(path));
+        }
+
+        module = linker.Link(options.module);
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        exit(1);
+    }
+
+    std::fstream out_file;
+    out_file.exceptions(std::fstream::badbit | std::fstream::failbit);
+
+    try {
+        out_file.open(options.output_path.value_or(options.module.name.value_or(first_name)),
+            std::fstream::out | std::fstream::binary | std::fstream::trunc);
+        out_file.write(module.data(), module.size());
+    } catch (std::exception const& e) {
+        std::cerr << e.what();
+        exit(1);
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include <Rof15ObjectFile.h>
+#include <Rof15ObjectReader.h>
+#include <ThreadPool.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace rof;
+
+namespace {
+
+struct Options {
+    std::vector<std::string> input_paths {};
+
+    // One tab-separated record per line, prefixed with the input path.
+    bool compact = false;
+    std::size_t jobs = support::ThreadPool::DefaultThreadCount();
+};
+
+[[noreturn]] void Usage(const std::string& error) {
+    std::cerr << error << std::endl;
+    std::cerr << "usage: rdump [options] <rof>..." << std::endl
+              << "  --compact     print one tab-separated record per line" << std::endl
+              << "  -j <count>    read up to <count> files at once (default: hardware threads)" << std::endl;
+    exit(1);
+}
+
+Options ParseArguments(int argc, const char* argv[]) {
+    Options options {};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--compact") {
+            options.compact = true;
+        } else if (arg == "-j") {
+            if (i + 1 >= argc) Usage("Missing value for -j.");
+            try {
+                options.jobs = std::stoul(argv[++i]);
+            } catch (std::exception const&) {
+                Usage("-j must be a number.");
+            }
+        } else if (!arg.empty() && arg.front() == '-') {
+            Usage("Unknown option: " + arg);
+        } else {
+            options.input_paths.push_back(arg);
+        }
+    }
+
+    if (options.input_paths.empty()) {
+        Usage("No ROF files specified.");
+    }
+
+    return options;
+}
+
+std::string Hex(uint32_t value, int digits) {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "0x%0*X", digits, value);
+    return buf;
+}
+
+const char* OperatorName(ExpressionOperator op) {
+    switch (op) {
+        case ExpressionOperator::Hi: return "hi";
+        case ExpressionOperator::Lo: return "lo";
+        case ExpressionOperator::High: return "high";
+        case ExpressionOperator::ArithmeticNegation: return "neg";
+        case ExpressionOperator::BitwiseNegation: return "~";
+        case ExpressionOperator::BitwiseAnd: return "&";
+        case ExpressionOperator::BitwiseOr: return "|";
+        case ExpressionOperator::BitwiseXor: return "^";
+        case ExpressionOperator::Multiplication: return "*";
+        case ExpressionOperator::Division: return "/";
+        case ExpressionOperator::Addition: return "+";
+        case ExpressionOperator::Subtraction: return "-";
+        case ExpressionOperator::LeftShift: return "<<";
+        case ExpressionOperator::RightShift: return ">>";
+        case ExpressionOperator::ArithmeticRightShift: return ">>>";
+        default: return "?";
+    }
+}
+
+const char* SectionName(uint16_t location_flag) {
+    if (location_flag & static_cast<uint16_t>(ReferenceFlags::Code)) return "code";
+    if (location_flag & static_cast<uint16_t>(ReferenceFlags::Remote)) return "rdata";
+    return "idata";
+}
+
+// Prints an expression tree as an s-expression, naming extern refs where possible.
+void PrintExpression(const ExpressionTreeView& tree, const std::vector<std::string_view>& extern_refs, std::ostream& out) {
+    switch (tree.Op()) {
+        case ExpressionOperator::NumericConstant:
+            out << Hex(tree.Value(), 1);
+            return;
+        case ExpressionOperator::Reference: {
+            auto ref = tree.Ref();
+            if (ref.Flags() & LocalReferenceFlag) {
+                out << "local:" << Hex(ref.Value(), 8);
+            } else if (ref.Value() < extern_refs.size()) {
+                out << extern_refs[ref.Value()];
+            } else {
+                out << "extern:" << ref.Value();
+            }
+            return;
+        }
+        default:
+            out << "(" << OperatorName(tree.Op()) << " ";
+            PrintExpression(tree.Operand1(), extern_refs, out);
+            if (tree.SubtreeCount() == 2) {
+                out << " ";
+                PrintExpression(tree.Operand2(), extern_refs, out);
+            }
+            out << ")";
+    }
+}
+
+std::string FormatDate(std::array<uint8_t, 6> date) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%04d-%02d-%02d %02d:%02d:%02d",
+        date[0] + 1900, date[1] + 1, date[2], date[3], date[4], date[5]);
+    return buf;
+}
+
+void PrintRof(const Rof15ObjectReader& reader, std::ostream& out) {
+    auto header = reader.Header();
+
+    out << "Name: " << header.Name() << std::endl;
+    out << "Type/Language: " << Hex(header.TypeLanguage(), 4) << std::endl;
+    out << "Revision: " << header.Revision() << std::endl;
+    out << "Assembler Version: " << header.AsmVersion() << std::endl;
+    out << "Assembly Date: " << FormatDate(header.AsmDate()) << std::endl;
+    out << "Edition: " << header.Edition() << std::endl;
+    out << "Target CPU: " << Hex(header.TargetCPU(), 4)
+        << " (" << (reader.Endian() == support::big ? "big" : "little") << ")" << std::endl;
+    out << "Code Size: " << header.CodeSize() << std::endl;
+    out << "Initialized Data Size: " << header.InitializedDataSize() << std::endl;
+    out << "Uninitialized Data Size: " << header.StaticDataSize() << std::endl;
+    out << "Remote Initialized Data Size: " << header.RemoteInitializedDataSizeRequired() << std::endl;
+    out << "Remote Uninitialized Data Size: " << header.RemoteStaticDataSizeRequired() << std::endl;
+    out << "Stack Size: " << header.RequiredStackSize() << std::endl;
+    out << "Entry Offset: " << Hex(header.OffsetToEntry(), 8) << std::endl;
+    out << "Trap Handler Offset: " << Hex(header.OffsetToUninitializedTrapHandler(), 8) << std::endl;
+
+    auto defs = reader.ExternDefinitions();
+    out << "External Definitions (" << defs.Count() << "):" << std::endl;
+    for (auto def : defs) {
+        out << "  " << def.name << " type " << Hex(def.type, 4) << " value " << Hex(def.symbol_value, 8) << std::endl;
+    }
+
+    std::vector<std::string_view> extern_refs {};
+    for (auto name : reader.ExternRefs()) {
+        extern_refs.push_back(name);
+    }
+
+    out << "External References (" << extern_refs.size() << "):" << std::endl;
+    for (std::size_t i = 0; i < extern_refs.size(); i++) {
+        out << "  [" << i << "] " << extern_refs[i] << std::endl;
+    }
+
+    auto references = reader.References();
+    out << "References (" << references.Count() << "):" << std::endl;
+    for (auto ref : references) {
+        out << "  " << SectionName(ref.LocationFlag()) << "+" << Hex(ref.LocalOffset(), 8)
+            << " bit " << static_cast<int>(ref.BitNumber())
+            << " len " << static_cast<int>(ref.FieldLength())
+            << " flags " << Hex(ref.LocationFlag(), 4) << ": ";
+        PrintExpression(reader.ExpressionTreeAt(ref.ExprTreeIndex()), extern_refs, out);
+        out << std::endl;
+    }
+}
+
+void PrintRofCompact(const std::string& path, const Rof15ObjectReader& reader, std::ostream& out) {
+    auto header = reader.Header();
+
+    out << path << "\theader"
+        << "\tname=" << header.Name()
+        << "\ttylan=" << Hex(header.TypeLanguage(), 4)
+        << "\trev=" << header.Revision()
+        << "\tedition=" << header.Edition()
+        << "\tcpu=" << Hex(header.TargetCPU(), 4)
+        << "\tcode=" << header.CodeSize()
+        << "\tidata=" << header.InitializedDataSize()
+        << "\tudata=" << header.StaticDataSize()
+        << "\tridata=" << header.RemoteInitializedDataSizeRequired()
+        << "\trudata=" << header.RemoteStaticDataSizeRequired()
+        << "\tstack=" << header.RequiredStackSize()
+        << "\tentry=" << Hex(header.OffsetToEntry(), 8)
+        << std::endl;
+
+    for (auto def : reader.ExternDefinitions()) {
+        out << path << "\tdef\t" << def.name << "\t" << Hex(def.type, 4) << "\t" << Hex(def.symbol_value, 8) << std::endl;
+    }
+
+    std::vector<std::string_view> extern_refs {};
+    for (auto name : reader.ExternRefs()) {
+        out << path << "\textern\t" << extern_refs.size() << "\t" << name << std::endl;
+        extern_refs.push_back(name);
+    }
+
+    for (auto ref : reader.References()) {
+        out << path << "\tref\t" << SectionName(ref.LocationFlag())
+            << "\t" << Hex(ref.LocalOffset(), 8)
+            << "\t" << static_cast<int>(ref.BitNumber())
+            << "\t" << static_cast<int>(ref.FieldLength())
+            << "\t" << Hex(ref.LocationFlag(), 4) << "\t";
+        PrintExpression(reader.ExpressionTreeAt(ref.ExprTreeIndex()), extern_refs, out);
+        out << std::endl;
+    }
+}
+
+struct DumpResult {
+    std::string output {};
+    std::string error {};
+};
+
+DumpResult Dump(const Options& options, const std::string& path) {
+    DumpResult result {};
+    std::ostringstream out {};
+
+    try {
+        Rof15ObjectReader reader(path);
+        if (options.compact) {
+            PrintRofCompact(path, reader, out);
+        } else {
+            out << path << ":" << std::endl;
+            PrintRof(reader, out);
+            out << std::endl;
+        }
+        result.output = out.str();
+    } catch (std::exception const& e) {
+        result.error = path + ": " + e.what();
+    }
+
+    return result;
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    auto options = ParseArguments(argc, argv);
+
+    std::vector<std::future<DumpResult>> results {};
+    results.reserve(options.input_paths.size());
+
+    support::ThreadPool pool(options.jobs);
+    for (auto& path : options.input_paths) {
+        results.push_back(pool.Submit([&options, &path]() { return Dump(options, path); }));
+    }
+
+    // Files are read concurrently, but reported in the order given.
+    int status = 0;
+    for (auto& result : results) {
+        auto dump = result.get();
+        if (!dump.error.empty()) {
+            std::cout.flush();
+            std::cerr << dump.error << std::endl;
+            status = 1;
+            continue;
+        }
+
+        std::cout << dump.output;
+    }
+
+    return status;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#include <RofArchive.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace {
+
+enum class Command {
+    Replace,
+    List,
+    Delete
+};
+
+struct Options {
+    Command command = Command::Replace;
+    std::string archive_path {};
+    std::vector<std::string> operands {};
+};
+
+[[noreturn]] void Usage(const std::string& error) {
+    std::cerr << error << std::endl;
+    std::cerr << "usage: rlib [-t | -d] <archive> [<rof>...]" << std::endl
+              << "       add each ROF to the archive (replacing members of the same name), creating it if needed" << std::endl
+              << "  -t   list the archive's members and the symbols indexed for each" << std::endl
+              << "  -d   delete the named members from the archive" << std::endl;
+    exit(1);
+}
+
+Options ParseArguments(int argc, const char* argv[]) {
+    Options options {};
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-t") {
+            options.command = Command::List;
+        } else if (arg == "-d") {
+            options.command = Command::Delete;
+        } else if (!arg.empty() && arg.front() == '-') {
+            Usage("Unknown option: " + arg);
+        } else if (options.archive_path.empty()) {
+            options.archive_path = arg;
+        } else {
+            options.operands.push_back(arg);
+        }
+    }
+
+    if (options.archive_path.empty()) {
+        Usage("No archive specified.");
+    }
+
+    if (options.command != Command::List && options.operands.empty()) {
+        Usage("No members specified.");
+    }
+
+    return options;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Failed to open " + path + ".");
+    }
+
+    std::ostringstream contents {};
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+uint32_t ModificationTime(const std::string& path) {
+    struct stat info {};
+    return stat(path.c_str(), &info) == 0 ? static_cast<uint32_t>(info.st_mtime) : 0;
+}
+
+void List(const rof::RofArchive& archive) {
+    std::vector<std::vector<std::string_view>> symbols(archive.MemberCount());
+    for (uint32_t i = 0; i < archive.SymbolCount(); i++) {
+        auto symbol = archive.Symbol(i);
+        if (symbol.member_index < symbols.size()) {
+            symbols[symbol.member_index].push_back(symbol.name);
+        }
+    }
+
+    for (uint32_t i = 0; i < archive.MemberCount(); i++) {
+        auto member = archive.Member(i);
+        std::cout << member.name << " (" << member.data.size() << " bytes)" << std::endl;
+        for (auto name : symbols[i]) {
+            std::cout << "  " << name << std::endl;
+        }
+    }
+}
+
+void Update(const Options& options) {
+    rof::RofArchiveWriter writer {};
+    if (std::filesystem::exists(options.archive_path)) {
+        rof::RofArchive existing(options.archive_path);
+        writer.AddMembers(existing);
+    } else if (options.command == Command::Delete) {
+        throw std::runtime_error(options.archive_path + " does not exist.");
+    }
+
+    for (auto& operand : options.operands) {
+        if (options.command == Command::Delete) {
+            if (!writer.RemoveMember(operand)) {
+                std::cerr << "No member named " << operand << std::endl;
+            }
+        } else {
+            auto name = std::filesystem::path(operand).filename().string();
+            try {
+                writer.AddMember(name, ReadFile(operand), ModificationTime(operand));
+            } catch (std::exception const& e) {
+                throw std::runtime_error(operand + ": " + e.what());
+            }
+        }
+    }
+
+    // Replace the archive only once the new one is complete.
+    auto temp_path = options.archive_path + ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+        writer.Write(out);
+    }
+
+    std::filesystem::rename(temp_path, options.archive_path);
+}
+
+}
+
+int main(int argc, const char* argv[]) {
+    auto options = ParseArguments(argc, argv);
+
+    try {
+        if (options.command == Command::List) {
+            List(rof::RofArchive(options.archive_path));
+        } else {
+            Update(options);
+        }
+    } catch (std::exception const& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file